@@ -0,0 +1,785 @@
+//
+//  FrameCapture.c
+//  LabExcelsior
+//
+//  Asynchronous pixel readback, and a writer that saves the frames to disk, see FrameCapture.h
+//
+
+#include "FrameCapture.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+#if defined(__APPLE__)
+    #ifndef GL_SILENCE_DEPRECATION
+        #define GL_SILENCE_DEPRECATION
+    #endif
+    #include <OpenGL/gl.h>
+#else
+    #include <GL/gl.h>
+#endif
+
+#define LAB_CAPTURE_READBACKS 3     // pixel buffers in flight on the GPU
+#define LAB_CAPTURE_FRAMES 4        // copies waiting for (or being used by) the consumer
+#define LAB_WRITER_QUEUE 8          // frames waiting to be encoded
+#define LAB_WRITER_MAX_THREADS 16
+
+/* the few GL 1.5 - 3.2 bits used here, so no glext.h is needed */
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#define LAB_GL_PIXEL_PACK_BUFFER 0x88EB
+#define LAB_GL_STREAM_READ 0x88E1
+#define LAB_GL_MAP_READ_BIT 0x0001
+#define LAB_GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define LAB_GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define LAB_GL_TIMEOUT_EXPIRED 0x911B
+#define LAB_GL_WAIT_FAILED 0x911D
+
+typedef struct __GLsync* LabGLsync;
+
+typedef void (APIENTRY* LabGenBuffersFunc)(GLsizei, GLuint*);
+typedef void (APIENTRY* LabDeleteBuffersFunc)(GLsizei, const GLuint*);
+typedef void (APIENTRY* LabBindBufferFunc)(GLenum, GLuint);
+typedef void (APIENTRY* LabBufferDataFunc)(GLenum, ptrdiff_t, const void*, GLenum);
+typedef void* (APIENTRY* LabMapBufferRangeFunc)(GLenum, ptrdiff_t, ptrdiff_t, GLbitfield);
+typedef GLboolean (APIENTRY* LabUnmapBufferFunc)(GLenum);
+typedef LabGLsync (APIENTRY* LabFenceSyncFunc)(GLenum, GLbitfield);
+typedef GLenum (APIENTRY* LabClientWaitSyncFunc)(LabGLsync, GLbitfield, uint64_t);
+typedef void (APIENTRY* LabDeleteSyncFunc)(LabGLsync);
+
+/* threads, only what the capture and writer need */
+#ifdef _WIN32
+    typedef CRITICAL_SECTION LabMutex;
+    typedef CONDITION_VARIABLE LabCond;
+    typedef HANDLE LabThread;
+
+    static void LabMutexInit(LabMutex* m) { InitializeCriticalSection(m); }
+    static void LabMutexDestroy(LabMutex* m) { DeleteCriticalSection(m); }
+    static void LabMutexLock(LabMutex* m) { EnterCriticalSection(m); }
+    static void LabMutexUnlock(LabMutex* m) { LeaveCriticalSection(m); }
+    static void LabCondInit(LabCond* c) { InitializeConditionVariable(c); }
+    static void LabCondDestroy(LabCond* c) { (void)c; }
+    static void LabCondWait(LabCond* c, LabMutex* m) { SleepConditionVariableCS(c, m, INFINITE); }
+    static void LabCondBroadcast(LabCond* c) { WakeAllConditionVariable(c); }
+
+    typedef struct { void* (*fn)(void*); void* arg; } LabThreadStart;
+    static DWORD WINAPI LabThreadMain(LPVOID p) {
+        LabThreadStart start = *(LabThreadStart*)p;
+        free(p);
+        start.fn(start.arg);
+        return 0;
+    }
+    static int LabThreadCreate(LabThread* t, void* (*fn)(void*), void* arg) {
+        LabThreadStart* start = (LabThreadStart*)malloc(sizeof(LabThreadStart));
+        if (start == NULL)
+            return 0;
+        start->fn = fn;
+        start->arg = arg;
+        *t = CreateThread(NULL, 0, LabThreadMain, start, 0, NULL);
+        if (*t == NULL)
+            free(start);
+        return *t != NULL;
+    }
+    static void LabThreadJoin(LabThread t) { WaitForSingleObject(t, INFINITE); CloseHandle(t); }
+#else
+    typedef pthread_mutex_t LabMutex;
+    typedef pthread_cond_t LabCond;
+    typedef pthread_t LabThread;
+
+    static void LabMutexInit(LabMutex* m) { pthread_mutex_init(m, NULL); }
+    static void LabMutexDestroy(LabMutex* m) { pthread_mutex_destroy(m); }
+    static void LabMutexLock(LabMutex* m) { pthread_mutex_lock(m); }
+    static void LabMutexUnlock(LabMutex* m) { pthread_mutex_unlock(m); }
+    static void LabCondInit(LabCond* c) { pthread_cond_init(c, NULL); }
+    static void LabCondDestroy(LabCond* c) { pthread_cond_destroy(c); }
+    static void LabCondWait(LabCond* c, LabMutex* m) { pthread_cond_wait(c, m); }
+    static void LabCondBroadcast(LabCond* c) { pthread_cond_broadcast(c); }
+    static int LabThreadCreate(LabThread* t, void* (*fn)(void*), void* arg) { return pthread_create(t, NULL, fn, arg) == 0; }
+    static void LabThreadJoin(LabThread t) { pthread_join(t, NULL); }
+#endif
+
+/*
+ capture
+ */
+
+typedef struct LabCapturedFrame {
+    unsigned char* pixels;
+    size_t capacity;
+    int width, height;
+    unsigned long long frame;
+    int state;                  // LAB_FRAME_FREE, _QUEUED or _CONSUMING
+} LabCapturedFrame;
+
+enum { LAB_FRAME_FREE, LAB_FRAME_QUEUED, LAB_FRAME_CONSUMING };
+
+struct LabFrameCapture {
+    // GL thread only
+    GLuint pbo[LAB_CAPTURE_READBACKS];
+    LabGLsync fence[LAB_CAPTURE_READBACKS];     // NULL if the buffer is free
+    size_t pboSize[LAB_CAPTURE_READBACKS];
+    int pboWidth[LAB_CAPTURE_READBACKS], pboHeight[LAB_CAPTURE_READBACKS];
+    unsigned long long pboFrame[LAB_CAPTURE_READBACKS];
+    unsigned int next;                          // the buffer the next frame is read into, also the oldest in flight
+    unsigned long long frame;
+
+    LabGenBuffersFunc genBuffers;
+    LabDeleteBuffersFunc deleteBuffers;
+    LabBindBufferFunc bindBuffer;
+    LabBufferDataFunc bufferData;
+    LabMapBufferRangeFunc mapBufferRange;
+    LabUnmapBufferFunc unmapBuffer;
+    LabFenceSyncFunc fenceSync;
+    LabClientWaitSyncFunc clientWaitSync;
+    LabDeleteSyncFunc deleteSync;
+
+    // shared with the consumer thread
+    LabMutex lock;
+    LabCond changed;
+    LabCapturedFrame frames[LAB_CAPTURE_FRAMES];
+    unsigned int queue[LAB_CAPTURE_FRAMES];     // indices into frames, oldest first
+    unsigned int queueHead, queueCount;
+    unsigned long long dropped;
+    int lossless;
+    int quit;
+
+    LabFrameFunc consumer;
+    void* user;
+    LabThread thread;
+};
+
+static void* LabFrameCaptureThread(void* arg) {
+    LabFrameCapture* c = (LabFrameCapture*)arg;
+
+    LabMutexLock(&c->lock);
+    for (;;) {
+        while (c->queueCount == 0 && !c->quit)
+            LabCondWait(&c->changed, &c->lock);
+
+        if (c->queueCount == 0)
+            break;
+
+        LabCapturedFrame* f = &c->frames[c->queue[c->queueHead]];
+        c->queueHead = (c->queueHead + 1) % LAB_CAPTURE_FRAMES;
+        c->queueCount--;
+        f->state = LAB_FRAME_CONSUMING;
+        LabMutexUnlock(&c->lock);
+
+        c->consumer(f->pixels, f->width, f->height, f->frame, c->user);
+
+        LabMutexLock(&c->lock);
+        f->state = LAB_FRAME_FREE;
+        LabCondBroadcast(&c->changed);
+    }
+    LabMutexUnlock(&c->lock);
+    return NULL;
+}
+
+LabFrameCapture* LabFrameCaptureCreate(LabGLLoader load, LabFrameFunc consumer, void* user) {
+    if (load == NULL || consumer == NULL)
+        return NULL;
+
+    LabFrameCapture* c = (LabFrameCapture*)calloc(1, sizeof(LabFrameCapture));
+    if (c == NULL)
+        return NULL;
+
+    c->genBuffers = (LabGenBuffersFunc)load("glGenBuffers");
+    c->deleteBuffers = (LabDeleteBuffersFunc)load("glDeleteBuffers");
+    c->bindBuffer = (LabBindBufferFunc)load("glBindBuffer");
+    c->bufferData = (LabBufferDataFunc)load("glBufferData");
+    c->mapBufferRange = (LabMapBufferRangeFunc)load("glMapBufferRange");
+    c->unmapBuffer = (LabUnmapBufferFunc)load("glUnmapBuffer");
+    c->fenceSync = (LabFenceSyncFunc)load("glFenceSync");
+    c->clientWaitSync = (LabClientWaitSyncFunc)load("glClientWaitSync");
+    c->deleteSync = (LabDeleteSyncFunc)load("glDeleteSync");
+
+    if (!c->genBuffers || !c->deleteBuffers || !c->bindBuffer || !c->bufferData || !c->mapBufferRange ||
+        !c->unmapBuffer || !c->fenceSync || !c->clientWaitSync || !c->deleteSync) {
+        free(c);
+        return NULL;
+    }
+
+    c->consumer = consumer;
+    c->user = user;
+    c->genBuffers(LAB_CAPTURE_READBACKS, c->pbo);
+
+    LabMutexInit(&c->lock);
+    LabCondInit(&c->changed);
+
+    if (!LabThreadCreate(&c->thread, LabFrameCaptureThread, c)) {
+        c->deleteBuffers(LAB_CAPTURE_READBACKS, c->pbo);
+        LabCondDestroy(&c->changed);
+        LabMutexDestroy(&c->lock);
+        free(c);
+        return NULL;
+    }
+
+    return c;
+}
+
+// copies a finished readback out of its pixel buffer for the consumer, returns 0 if the GPU isn't done with it
+static int LabFrameCaptureCollect(LabFrameCapture* c, unsigned int slot, int wait) {
+    if (c->fence[slot] == NULL)
+        return 1;
+
+    GLenum status = c->clientWaitSync(c->fence[slot], wait ? LAB_GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                      wait ? 1000000000ull : 0);
+    if (status == LAB_GL_TIMEOUT_EXPIRED)
+        return 0;
+
+    c->deleteSync(c->fence[slot]);
+    c->fence[slot] = NULL;
+
+    if (status == LAB_GL_WAIT_FAILED)
+        return 1;
+
+    int width = c->pboWidth[slot], height = c->pboHeight[slot];
+    size_t size = (size_t)width * (size_t)height * 4;
+
+    // a free copy, or the frame is dropped so the render loop never waits on the consumer
+    LabMutexLock(&c->lock);
+    LabCapturedFrame* f = NULL;
+    for (;;) {
+        for (int i = 0; i < LAB_CAPTURE_FRAMES; i++)
+            if (c->frames[i].state == LAB_FRAME_FREE) {
+                f = &c->frames[i];
+                break;
+            }
+
+        if (f != NULL || !c->lossless)
+            break;
+
+        LabCondWait(&c->changed, &c->lock);
+    }
+    if (f == NULL)
+        c->dropped++;
+    LabMutexUnlock(&c->lock);
+
+    if (f == NULL)
+        return 1;
+
+    if (f->capacity < size) {
+        unsigned char* pixels = (unsigned char*)realloc(f->pixels, size);
+        if (pixels == NULL)
+            return 1;
+        f->pixels = pixels;
+        f->capacity = size;
+    }
+
+    c->bindBuffer(LAB_GL_PIXEL_PACK_BUFFER, c->pbo[slot]);
+    const void* mapped = c->mapBufferRange(LAB_GL_PIXEL_PACK_BUFFER, 0, (ptrdiff_t)size, LAB_GL_MAP_READ_BIT);
+    if (mapped != NULL) {
+        memcpy(f->pixels, mapped, size);
+        c->unmapBuffer(LAB_GL_PIXEL_PACK_BUFFER);
+    }
+    c->bindBuffer(LAB_GL_PIXEL_PACK_BUFFER, 0);
+
+    if (mapped == NULL)
+        return 1;
+
+    f->width = width;
+    f->height = height;
+    f->frame = c->pboFrame[slot];
+
+    LabMutexLock(&c->lock);
+    f->state = LAB_FRAME_QUEUED;
+    c->queue[(c->queueHead + c->queueCount) % LAB_CAPTURE_FRAMES] = (unsigned int)(f - c->frames);
+    c->queueCount++;
+    LabCondBroadcast(&c->changed);
+    LabMutexUnlock(&c->lock);
+    return 1;
+}
+
+void LabFrameCaptureFrame(LabFrameCapture* c, int width, int height) {
+    if (c == NULL || width <= 0 || height <= 0)
+        return;
+
+    // hand over everything the GPU already finished, oldest first
+    unsigned int i;
+    for (i = 0; i < LAB_CAPTURE_READBACKS; i++)
+        if (!LabFrameCaptureCollect(c, (c->next + i) % LAB_CAPTURE_READBACKS, 0))
+            break;
+
+    // the ring is full, the oldest readback has to finish before its buffer is reused.
+    // If the GPU still hasn't got to it, this frame is dropped instead of reading over it
+    unsigned int slot = c->next;
+    if (!LabFrameCaptureCollect(c, slot, 1)) {
+        LabMutexLock(&c->lock);
+        c->dropped++;
+        LabMutexUnlock(&c->lock);
+        c->frame++;
+        return;
+    }
+
+    size_t size = (size_t)width * (size_t)height * 4;
+    c->bindBuffer(LAB_GL_PIXEL_PACK_BUFFER, c->pbo[slot]);
+    if (c->pboSize[slot] < size) {
+        c->bufferData(LAB_GL_PIXEL_PACK_BUFFER, (ptrdiff_t)size, NULL, LAB_GL_STREAM_READ);
+        c->pboSize[slot] = size;
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    c->bindBuffer(LAB_GL_PIXEL_PACK_BUFFER, 0);
+
+    c->fence[slot] = c->fenceSync(LAB_GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    c->pboWidth[slot] = width;
+    c->pboHeight[slot] = height;
+    c->pboFrame[slot] = c->frame++;
+    c->next = (slot + 1) % LAB_CAPTURE_READBACKS;
+}
+
+void LabFrameCaptureFinish(LabFrameCapture* c) {
+    if (c == NULL)
+        return;
+
+    unsigned int i;
+    for (i = 0; i < LAB_CAPTURE_READBACKS; i++)
+        LabFrameCaptureCollect(c, (c->next + i) % LAB_CAPTURE_READBACKS, 1);
+
+    LabMutexLock(&c->lock);
+    for (;;) {
+        int busy = c->queueCount != 0;
+        for (i = 0; i < LAB_CAPTURE_FRAMES; i++)
+            busy |= (c->frames[i].state == LAB_FRAME_CONSUMING);
+
+        if (!busy)
+            break;
+
+        LabCondWait(&c->changed, &c->lock);
+    }
+    LabMutexUnlock(&c->lock);
+}
+
+unsigned long long LabFrameCaptureDropped(const LabFrameCapture* c) {
+    return c ? c->dropped : 0;
+}
+
+void LabFrameCaptureSetLossless(LabFrameCapture* c, int lossless) {
+    if (c == NULL)
+        return;
+
+    LabMutexLock(&c->lock);
+    c->lossless = lossless;
+    LabMutexUnlock(&c->lock);
+}
+
+void LabFrameCaptureDestroy(LabFrameCapture* c) {
+    if (c == NULL)
+        return;
+
+    LabFrameCaptureFinish(c);
+
+    LabMutexLock(&c->lock);
+    c->quit = 1;
+    LabCondBroadcast(&c->changed);
+    LabMutexUnlock(&c->lock);
+    LabThreadJoin(c->thread);
+
+    // readbacks Finish gave up waiting on
+    for (int i = 0; i < LAB_CAPTURE_READBACKS; i++)
+        if (c->fence[i] != NULL)
+            c->deleteSync(c->fence[i]);
+
+    c->deleteBuffers(LAB_CAPTURE_READBACKS, c->pbo);
+
+    for (int i = 0; i < LAB_CAPTURE_FRAMES; i++)
+        free(c->frames[i].pixels);
+
+    LabCondDestroy(&c->changed);
+    LabMutexDestroy(&c->lock);
+    free(c);
+}
+
+/*
+ writer
+ */
+
+typedef struct LabWriteJob {
+    unsigned char* pixels;
+    int width, height;
+    unsigned long long frame;
+} LabWriteJob;
+
+struct LabFrameWriter {
+    char* pattern;
+    LabFrameFormat format;
+
+    LabMutex lock;
+    LabCond changed;
+    LabWriteJob queue[LAB_WRITER_QUEUE];
+    unsigned int queueHead, queueCount;
+    int quit;
+
+    LabThread threads[LAB_WRITER_MAX_THREADS];
+    int threadCount;
+};
+
+static void LabWriteRaw(FILE* file, const LabWriteJob* job) {
+    size_t stride = (size_t)job->width * 4;
+    for (int y = job->height - 1; y >= 0; y--)
+        fwrite(job->pixels + (size_t)y * stride, 1, stride, file);
+}
+
+static void LabWriteU32BE(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+// https://qoiformat.org/qoi-specification.pdf
+static void LabWriteQOI(FILE* file, const LabWriteJob* job) {
+    unsigned char header[14] = { 'q', 'o', 'i', 'f' };
+    LabWriteU32BE(header + 4, (uint32_t)job->width);
+    LabWriteU32BE(header + 8, (uint32_t)job->height);
+    header[12] = 4; // RGBA
+    header[13] = 0; // sRGB with linear alpha
+    fwrite(header, 1, sizeof(header), file);
+
+    // worst case is 5 bytes a pixel, written a row at a time
+    unsigned char* out = (unsigned char*)malloc((size_t)job->width * 5 + 8);
+    if (out == NULL)
+        return;
+
+    unsigned char index[64][4];
+    memset(index, 0, sizeof(index));
+    unsigned char prev[4] = { 0, 0, 0, 255 };
+    int run = 0;
+
+    for (int y = job->height - 1; y >= 0; y--) {
+        const unsigned char* row = job->pixels + (size_t)y * (size_t)job->width * 4;
+        size_t n = 0;
+
+        for (int x = 0; x < job->width; x++) {
+            const unsigned char* px = row + x * 4;
+            int last = (y == 0 && x == job->width - 1);
+
+            if (memcmp(px, prev, 4) == 0) {
+                run++;
+                if (run == 62 || last) {
+                    out[n++] = (unsigned char)(0xC0 | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0) {
+                out[n++] = (unsigned char)(0xC0 | (run - 1));
+                run = 0;
+            }
+
+            int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+            if (memcmp(index[hash], px, 4) == 0) {
+                out[n++] = (unsigned char)hash;
+            }
+            else {
+                memcpy(index[hash], px, 4);
+
+                if (px[3] == prev[3]) {
+                    signed char dr = (signed char)(px[0] - prev[0]);
+                    signed char dg = (signed char)(px[1] - prev[1]);
+                    signed char db = (signed char)(px[2] - prev[2]);
+                    signed char drdg = (signed char)(dr - dg);
+                    signed char dbdg = (signed char)(db - dg);
+
+                    if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2) {
+                        out[n++] = (unsigned char)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                    }
+                    else if (drdg > -9 && drdg < 8 && dg > -33 && dg < 32 && dbdg > -9 && dbdg < 8) {
+                        out[n++] = (unsigned char)(0x80 | (dg + 32));
+                        out[n++] = (unsigned char)((drdg + 8) << 4 | (dbdg + 8));
+                    }
+                    else {
+                        out[n++] = 0xFE;
+                        out[n++] = px[0];
+                        out[n++] = px[1];
+                        out[n++] = px[2];
+                    }
+                }
+                else {
+                    out[n++] = 0xFF;
+                    memcpy(out + n, px, 4);
+                    n += 4;
+                }
+            }
+
+            memcpy(prev, px, 4);
+        }
+
+        fwrite(out, 1, n, file);
+    }
+
+    static const unsigned char end[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    fwrite(end, 1, sizeof(end), file);
+    free(out);
+}
+
+// the reflected 0xEDB88320 polynomial, precomputed so the writer threads share it without setting it up
+static const uint32_t LabCRC32Table[256] = {
+    0x00000000u, 0x77073096u, 0xee0e612cu, 0x990951bau, 0x076dc419u, 0x706af48fu,
+    0xe963a535u, 0x9e6495a3u, 0x0edb8832u, 0x79dcb8a4u, 0xe0d5e91eu, 0x97d2d988u,
+    0x09b64c2bu, 0x7eb17cbdu, 0xe7b82d07u, 0x90bf1d91u, 0x1db71064u, 0x6ab020f2u,
+    0xf3b97148u, 0x84be41deu, 0x1adad47du, 0x6ddde4ebu, 0xf4d4b551u, 0x83d385c7u,
+    0x136c9856u, 0x646ba8c0u, 0xfd62f97au, 0x8a65c9ecu, 0x14015c4fu, 0x63066cd9u,
+    0xfa0f3d63u, 0x8d080df5u, 0x3b6e20c8u, 0x4c69105eu, 0xd56041e4u, 0xa2677172u,
+    0x3c03e4d1u, 0x4b04d447u, 0xd20d85fdu, 0xa50ab56bu, 0x35b5a8fau, 0x42b2986cu,
+    0xdbbbc9d6u, 0xacbcf940u, 0x32d86ce3u, 0x45df5c75u, 0xdcd60dcfu, 0xabd13d59u,
+    0x26d930acu, 0x51de003au, 0xc8d75180u, 0xbfd06116u, 0x21b4f4b5u, 0x56b3c423u,
+    0xcfba9599u, 0xb8bda50fu, 0x2802b89eu, 0x5f058808u, 0xc60cd9b2u, 0xb10be924u,
+    0x2f6f7c87u, 0x58684c11u, 0xc1611dabu, 0xb6662d3du, 0x76dc4190u, 0x01db7106u,
+    0x98d220bcu, 0xefd5102au, 0x71b18589u, 0x06b6b51fu, 0x9fbfe4a5u, 0xe8b8d433u,
+    0x7807c9a2u, 0x0f00f934u, 0x9609a88eu, 0xe10e9818u, 0x7f6a0dbbu, 0x086d3d2du,
+    0x91646c97u, 0xe6635c01u, 0x6b6b51f4u, 0x1c6c6162u, 0x856530d8u, 0xf262004eu,
+    0x6c0695edu, 0x1b01a57bu, 0x8208f4c1u, 0xf50fc457u, 0x65b0d9c6u, 0x12b7e950u,
+    0x8bbeb8eau, 0xfcb9887cu, 0x62dd1ddfu, 0x15da2d49u, 0x8cd37cf3u, 0xfbd44c65u,
+    0x4db26158u, 0x3ab551ceu, 0xa3bc0074u, 0xd4bb30e2u, 0x4adfa541u, 0x3dd895d7u,
+    0xa4d1c46du, 0xd3d6f4fbu, 0x4369e96au, 0x346ed9fcu, 0xad678846u, 0xda60b8d0u,
+    0x44042d73u, 0x33031de5u, 0xaa0a4c5fu, 0xdd0d7cc9u, 0x5005713cu, 0x270241aau,
+    0xbe0b1010u, 0xc90c2086u, 0x5768b525u, 0x206f85b3u, 0xb966d409u, 0xce61e49fu,
+    0x5edef90eu, 0x29d9c998u, 0xb0d09822u, 0xc7d7a8b4u, 0x59b33d17u, 0x2eb40d81u,
+    0xb7bd5c3bu, 0xc0ba6cadu, 0xedb88320u, 0x9abfb3b6u, 0x03b6e20cu, 0x74b1d29au,
+    0xead54739u, 0x9dd277afu, 0x04db2615u, 0x73dc1683u, 0xe3630b12u, 0x94643b84u,
+    0x0d6d6a3eu, 0x7a6a5aa8u, 0xe40ecf0bu, 0x9309ff9du, 0x0a00ae27u, 0x7d079eb1u,
+    0xf00f9344u, 0x8708a3d2u, 0x1e01f268u, 0x6906c2feu, 0xf762575du, 0x806567cbu,
+    0x196c3671u, 0x6e6b06e7u, 0xfed41b76u, 0x89d32be0u, 0x10da7a5au, 0x67dd4accu,
+    0xf9b9df6fu, 0x8ebeeff9u, 0x17b7be43u, 0x60b08ed5u, 0xd6d6a3e8u, 0xa1d1937eu,
+    0x38d8c2c4u, 0x4fdff252u, 0xd1bb67f1u, 0xa6bc5767u, 0x3fb506ddu, 0x48b2364bu,
+    0xd80d2bdau, 0xaf0a1b4cu, 0x36034af6u, 0x41047a60u, 0xdf60efc3u, 0xa867df55u,
+    0x316e8eefu, 0x4669be79u, 0xcb61b38cu, 0xbc66831au, 0x256fd2a0u, 0x5268e236u,
+    0xcc0c7795u, 0xbb0b4703u, 0x220216b9u, 0x5505262fu, 0xc5ba3bbeu, 0xb2bd0b28u,
+    0x2bb45a92u, 0x5cb36a04u, 0xc2d7ffa7u, 0xb5d0cf31u, 0x2cd99e8bu, 0x5bdeae1du,
+    0x9b64c2b0u, 0xec63f226u, 0x756aa39cu, 0x026d930au, 0x9c0906a9u, 0xeb0e363fu,
+    0x72076785u, 0x05005713u, 0x95bf4a82u, 0xe2b87a14u, 0x7bb12baeu, 0x0cb61b38u,
+    0x92d28e9bu, 0xe5d5be0du, 0x7cdcefb7u, 0x0bdbdf21u, 0x86d3d2d4u, 0xf1d4e242u,
+    0x68ddb3f8u, 0x1fda836eu, 0x81be16cdu, 0xf6b9265bu, 0x6fb077e1u, 0x18b74777u,
+    0x88085ae6u, 0xff0f6a70u, 0x66063bcau, 0x11010b5cu, 0x8f659effu, 0xf862ae69u,
+    0x616bffd3u, 0x166ccf45u, 0xa00ae278u, 0xd70dd2eeu, 0x4e048354u, 0x3903b3c2u,
+    0xa7672661u, 0xd06016f7u, 0x4969474du, 0x3e6e77dbu, 0xaed16a4au, 0xd9d65adcu,
+    0x40df0b66u, 0x37d83bf0u, 0xa9bcae53u, 0xdebb9ec5u, 0x47b2cf7fu, 0x30b5ffe9u,
+    0xbdbdf21cu, 0xcabac28au, 0x53b39330u, 0x24b4a3a6u, 0xbad03605u, 0xcdd70693u,
+    0x54de5729u, 0x23d967bfu, 0xb3667a2eu, 0xc4614ab8u, 0x5d681b02u, 0x2a6f2b94u,
+    0xb40bbe37u, 0xc30c8ea1u, 0x5a05df1bu, 0x2d02ef8du,
+};
+
+static uint32_t LabCRC32(uint32_t crc, const unsigned char* data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+        crc = LabCRC32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void LabWritePNGChunk(FILE* file, const char* type, const unsigned char* data, size_t len) {
+    unsigned char header[8];
+    LabWriteU32BE(header, (uint32_t)len);
+    memcpy(header + 4, type, 4);
+    fwrite(header, 1, 8, file);
+    fwrite(data, 1, len, file);
+
+    unsigned char crc[4];
+    LabWriteU32BE(crc, LabCRC32(LabCRC32(0, (const unsigned char*)type, 4), data, len));
+    fwrite(crc, 1, 4, file);
+}
+
+// scanlines in stored (uncompressed) deflate blocks, valid PNG without a compressor
+static void LabWritePNG(FILE* file, const LabWriteJob* job) {
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(signature, 1, sizeof(signature), file);
+
+    unsigned char ihdr[13];
+    LabWriteU32BE(ihdr, (uint32_t)job->width);
+    LabWriteU32BE(ihdr + 4, (uint32_t)job->height);
+    ihdr[8] = 8;    // bit depth
+    ihdr[9] = 6;    // RGBA
+    ihdr[10] = 0;   // deflate
+    ihdr[11] = 0;   // adaptive filtering
+    ihdr[12] = 0;   // no interlace
+    LabWritePNGChunk(file, "IHDR", ihdr, sizeof(ihdr));
+
+    size_t stride = (size_t)job->width * 4;
+    size_t raw = (stride + 1) * (size_t)job->height;
+    size_t blocks = (raw + 65534) / 65535;
+    size_t size = 2 + raw + blocks * 5 + 4;
+
+    unsigned char* idat = (unsigned char*)malloc(size);
+    if (idat == NULL)
+        return;
+
+    size_t n = 0;
+    idat[n++] = 0x78; // zlib, 32k window
+    idat[n++] = 0x01; // no preset dictionary, fastest
+
+    uint32_t a = 1, b = 0; // adler32
+    size_t left = raw, x = 0;
+    int y = job->height - 1;
+
+    while (left > 0) {
+        size_t len = left < 65535 ? left : 65535;
+        left -= len;
+
+        idat[n++] = (unsigned char)(left == 0);
+        idat[n++] = (unsigned char)len;
+        idat[n++] = (unsigned char)(len >> 8);
+        idat[n++] = (unsigned char)~len;
+        idat[n++] = (unsigned char)(~len >> 8);
+
+        // rows are "filter byte 0, then the pixels", a block can end anywhere in a row
+        while (len > 0) {
+            if (x == 0) {
+                idat[n++] = 0;
+                b = (b + a) % 65521;
+                x = 1;
+                len--;
+                continue;
+            }
+
+            size_t take = stride - (x - 1);
+            if (take > len)
+                take = len;
+
+            const unsigned char* src = job->pixels + (size_t)y * stride + (x - 1);
+            memcpy(idat + n, src, take);
+            for (size_t i = 0; i < take; i++) {
+                a = (a + src[i]) % 65521;
+                b = (b + a) % 65521;
+            }
+
+            n += take;
+            len -= take;
+            x += take;
+            if (x == stride + 1) {
+                x = 0;
+                y--;
+            }
+        }
+    }
+
+    LabWriteU32BE(idat + n, (b << 16) | a);
+    n += 4;
+
+    LabWritePNGChunk(file, "IDAT", idat, n);
+    LabWritePNGChunk(file, "IEND", NULL, 0);
+    free(idat);
+}
+
+static void* LabFrameWriterThread(void* arg) {
+    LabFrameWriter* w = (LabFrameWriter*)arg;
+
+    LabMutexLock(&w->lock);
+    for (;;) {
+        while (w->queueCount == 0 && !w->quit)
+            LabCondWait(&w->changed, &w->lock);
+
+        if (w->queueCount == 0)
+            break;
+
+        LabWriteJob job = w->queue[w->queueHead];
+        w->queueHead = (w->queueHead + 1) % LAB_WRITER_QUEUE;
+        w->queueCount--;
+        LabCondBroadcast(&w->changed);
+        LabMutexUnlock(&w->lock);
+
+        char path[1024];
+        snprintf(path, sizeof(path), w->pattern, job.frame);
+
+        FILE* file = fopen(path, "wb");
+        if (file != NULL) {
+            switch (w->format) {
+                case LAB_FRAME_QOI: LabWriteQOI(file, &job); break;
+                case LAB_FRAME_PNG: LabWritePNG(file, &job); break;
+                default: LabWriteRaw(file, &job); break;
+            }
+            fclose(file);
+        }
+        else
+            fprintf(stderr, "FrameCapture: could not write %s\n", path);
+
+        free(job.pixels);
+        LabMutexLock(&w->lock);
+    }
+    LabMutexUnlock(&w->lock);
+    return NULL;
+}
+
+LabFrameWriter* LabFrameWriterCreate(const char* pattern, LabFrameFormat format, int threads) {
+    if (pattern == NULL)
+        return NULL;
+
+    LabFrameWriter* w = (LabFrameWriter*)calloc(1, sizeof(LabFrameWriter));
+    if (w == NULL)
+        return NULL;
+
+    w->pattern = (char*)malloc(strlen(pattern) + 1);
+    if (w->pattern == NULL) {
+        free(w);
+        return NULL;
+    }
+    strcpy(w->pattern, pattern);
+    w->format = format;
+
+    LabMutexInit(&w->lock);
+    LabCondInit(&w->changed);
+
+    if (threads < 1)
+        threads = 1;
+    if (threads > LAB_WRITER_MAX_THREADS)
+        threads = LAB_WRITER_MAX_THREADS;
+
+    while (w->threadCount < threads && LabThreadCreate(&w->threads[w->threadCount], LabFrameWriterThread, w))
+        w->threadCount++;
+
+    if (w->threadCount == 0) {
+        LabFrameWriterDestroy(w);
+        return NULL;
+    }
+
+    return w;
+}
+
+void LabFrameWriterWrite(const unsigned char* pixels, int width, int height, unsigned long long frame, void* user) {
+    LabFrameWriter* w = (LabFrameWriter*)user;
+
+    size_t size = (size_t)width * (size_t)height * 4;
+    LabWriteJob job = { (unsigned char*)malloc(size), width, height, frame };
+    if (job.pixels == NULL)
+        return;
+    memcpy(job.pixels, pixels, size);
+
+    LabMutexLock(&w->lock);
+    while (w->queueCount == LAB_WRITER_QUEUE)
+        LabCondWait(&w->changed, &w->lock);
+
+    w->queue[(w->queueHead + w->queueCount) % LAB_WRITER_QUEUE] = job;
+    w->queueCount++;
+    LabCondBroadcast(&w->changed);
+    LabMutexUnlock(&w->lock);
+}
+
+void LabFrameWriterDestroy(LabFrameWriter* w) {
+    if (w == NULL)
+        return;
+
+    LabMutexLock(&w->lock);
+    w->quit = 1;
+    LabCondBroadcast(&w->changed);
+    LabMutexUnlock(&w->lock);
+
+    for (int i = 0; i < w->threadCount; i++)
+        LabThreadJoin(w->threads[i]);
+
+    LabCondDestroy(&w->changed);
+    LabMutexDestroy(&w->lock);
+    free(w->pattern);
+    free(w);
+}
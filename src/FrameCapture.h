@@ -0,0 +1,81 @@
+//
+//  FrameCapture.h
+//  LabExcelsior
+//
+//  Asynchronous pixel readback, and a writer that saves the frames to disk.
+//
+
+
+/*
+ LabFrameCaptureFrame is called on the GL thread after a frame is drawn (before
+ the swap, it reads the current read buffer). It queues a glReadPixels into a
+ ring of pixel buffer objects guarded by fences, and returns without waiting.
+ A frame or two later, once its fence has signalled, the pixels are copied out
+ and the consumer function is called with them on the capture's own thread.
+
+ If the consumer falls behind, frames are dropped rather than stalling the
+ render loop (see LabFrameCaptureDropped).
+
+ LabFrameWriterWrite can be the consumer. It hands each frame to a pool of
+ worker threads that encode it (raw RGBA, QOI, or PNG) and write it to a file
+ named from a printf pattern, e.g. "capture/frame_%05llu.png".
+
+ The GL functions past 1.1 are loaded through the given loader, e.g.
+ RGFW_getProcAddress or LabHeadlessGetProcAddress.
+ */
+
+#ifndef FrameCapture_h
+#define FrameCapture_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct LabFrameCapture LabFrameCapture;
+typedef struct LabFrameWriter LabFrameWriter;
+
+// pixels are RGBA8, bottom row first, and only valid during the call
+typedef void (*LabFrameFunc)(const unsigned char* pixels, int width, int height,
+                             unsigned long long frame, void* user);
+
+#ifndef LabGLLoader_defined
+#define LabGLLoader_defined
+typedef void* (*LabGLLoader)(const char* name);
+#endif
+
+// call on the GL thread, NULL if pixel buffers or fences aren't supported
+LabFrameCapture* LabFrameCaptureCreate(LabGLLoader load, LabFrameFunc consumer, void* user);
+void             LabFrameCaptureDestroy(LabFrameCapture*);
+
+// queues a readback of the current frame, width and height may change between frames
+void LabFrameCaptureFrame(LabFrameCapture*, int width, int height);
+
+// waits until every queued frame has reached the consumer
+void LabFrameCaptureFinish(LabFrameCapture*);
+
+unsigned long long LabFrameCaptureDropped(const LabFrameCapture*);
+
+// wait for the consumer instead of dropping frames, for offline rendering where every frame counts
+void LabFrameCaptureSetLossless(LabFrameCapture*, int lossless);
+
+typedef enum LabFrameFormat {
+    LAB_FRAME_RAW,  // RGBA8 rows, top row first, no header
+    LAB_FRAME_QOI,
+    LAB_FRAME_PNG,  // uncompressed deflate, fast to write rather than small
+} LabFrameFormat;
+
+// pattern is a printf format taking the frame number as an unsigned long long
+LabFrameWriter* LabFrameWriterCreate(const char* pattern, LabFrameFormat format, int threads);
+
+// waits for the queued frames to be written
+void LabFrameWriterDestroy(LabFrameWriter*);
+
+// a LabFrameFunc, user is the LabFrameWriter. Blocks if too many frames are queued.
+void LabFrameWriterWrite(const unsigned char* pixels, int width, int height,
+                         unsigned long long frame, void* user);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* FrameCapture_h */
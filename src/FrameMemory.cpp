@@ -0,0 +1,232 @@
+//
+//  FrameMemory.cpp
+//  LabExcelsior
+//
+//  Per-frame, per-thread linear allocation, see FrameMemory.hpp
+//
+
+#include "FrameMemory.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define LAB_FRAME_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define LAB_FRAME_ASAN 1
+#endif
+#endif
+
+#ifdef LAB_FRAME_ASAN
+#include <sanitizer/asan_interface.h>
+#define LAB_FRAME_ASAN_POISON(p, n) ASAN_POISON_MEMORY_REGION(p, n)
+#define LAB_FRAME_ASAN_UNPOISON(p, n) ASAN_UNPOISON_MEMORY_REGION(p, n)
+#else
+#define LAB_FRAME_ASAN_POISON(p, n) ((void)(p), (void)(n))
+#define LAB_FRAME_ASAN_UNPOISON(p, n) ((void)(p), (void)(n))
+#endif
+
+namespace lab
+{
+
+namespace {
+
+std::atomic<uint64_t> gNextId { 1 };
+
+struct Block {
+    Block* next;
+    size_t size;
+
+    unsigned char* begin() { return reinterpret_cast<unsigned char*>(this + 1); }
+    unsigned char* end() { return begin() + size; }
+};
+
+// blocks come from operator new, so a replaced global allocator (the
+// allocation count in FrameMemoryBench, a leak checker) sees the arenas grow
+Block* NewBlock(size_t size) {
+    Block* b = static_cast<Block*>(::operator new(sizeof(Block) + size));
+    b->next = nullptr;
+    b->size = size;
+    LAB_FRAME_ASAN_POISON(b->begin(), size);
+    return b;
+}
+
+void FreeBlocks(Block* b) {
+    while (b) {
+        Block* next = b->next;
+        LAB_FRAME_ASAN_UNPOISON(b->begin(), b->size);
+        ::operator delete(b);
+        b = next;
+    }
+}
+
+// one thread's allocator. Blocks before the current one are full, and are
+// only kept until the next Reset
+class Arena final : public std::pmr::memory_resource
+{
+public:
+    Arena* next = nullptr;          // FrameMemory's list of arenas
+
+    explicit Arena(size_t blockSize)
+    : _block(NewBlock(blockSize)), _ptr(_block->begin()) {}
+
+    ~Arena() override {
+        FreeBlocks(_full);
+        FreeBlocks(_block);
+    }
+
+    void Reset() {
+        if (_full) {
+            // the frame needed all of these, next time it gets them as one block
+            size_t total = _block->size;
+            for (Block* b = _full; b; b = b->next)
+                total += b->size;
+
+            FreeBlocks(_full);
+            FreeBlocks(_block);
+            _full = nullptr;
+            _block = NewBlock(total);
+            _ptr = _block->begin();
+            _used = 0;
+            return;
+        }
+
+        size_t used = (size_t)(_ptr - _block->begin());
+#if LAB_FRAME_POISON
+        // alignment padding between allocations is still poisoned
+        LAB_FRAME_ASAN_UNPOISON(_block->begin(), used);
+        std::memset(_block->begin(), 0xdd, used);
+#endif
+        LAB_FRAME_ASAN_POISON(_block->begin(), used);
+        _ptr = _block->begin();
+        _used = 0;
+    }
+
+    size_t Used() const { return _used; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        uintptr_t p = ((uintptr_t)_ptr + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+
+        if (p + bytes > (uintptr_t)_block->end()) {
+            // chain on a block at least twice the last, big enough for this one
+            size_t size = _block->size * 2;
+            if (size < bytes + alignment)
+                size = bytes + alignment;
+
+            _block->next = _full;
+            _full = _block;
+            _block = NewBlock(size);
+
+            p = ((uintptr_t)_block->begin() + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+        }
+
+        _ptr = (unsigned char*)(p + bytes);
+        _used += bytes;
+        LAB_FRAME_ASAN_UNPOISON((void*)p, bytes);
+        return (void*)p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    Block* _block;
+    Block* _full = nullptr;
+    unsigned char* _ptr;
+    size_t _used = 0;
+};
+
+// the arena the current thread used last, and whose it is
+struct ThreadArena {
+    uint64_t owner = 0;
+    Arena* arena = nullptr;
+};
+thread_local ThreadArena tArena;
+
+} // anon
+
+struct FrameMemory::data {
+    uint64_t id = gNextId.fetch_add(1);
+    size_t blockSize;
+
+    std::mutex lock;
+    Arena* arenas = nullptr;        // one per thread that has allocated, guarded by lock
+
+    // which thread each arena belongs to, looked up when the thread's cached
+    // arena is another FrameMemory's
+    struct Owner {
+        Owner* next;
+        std::thread::id thread;
+        Arena* arena;
+    };
+    Owner* owners = nullptr;
+};
+
+FrameMemory::FrameMemory(size_t blockSize)
+: _self(new data())
+{
+    _self->blockSize = blockSize ? blockSize : 4096;
+}
+
+FrameMemory::~FrameMemory() {
+    while (_self->owners) {
+        auto next = _self->owners->next;
+        delete _self->owners;
+        _self->owners = next;
+    }
+    while (_self->arenas) {
+        Arena* next = _self->arenas->next;
+        delete _self->arenas;
+        _self->arenas = next;
+    }
+    delete _self;
+}
+
+std::pmr::memory_resource* FrameMemory::Resource() {
+    if (tArena.owner == _self->id)
+        return tArena.arena;
+
+    std::lock_guard<std::mutex> guard(_self->lock);
+    std::thread::id thread = std::this_thread::get_id();
+
+    Arena* arena = nullptr;
+    for (auto o = _self->owners; o && !arena; o = o->next)
+        if (o->thread == thread)
+            arena = o->arena;
+
+    if (!arena) {
+        arena = new Arena(_self->blockSize);
+        arena->next = _self->arenas;
+        _self->arenas = arena;
+        _self->owners = new data::Owner { _self->owners, thread, arena };
+    }
+
+    tArena = { _self->id, arena };
+    return arena;
+}
+
+void FrameMemory::Reset() {
+    std::lock_guard<std::mutex> guard(_self->lock);
+    for (Arena* a = _self->arenas; a; a = a->next)
+        a->Reset();
+}
+
+size_t FrameMemory::Used() const {
+    std::lock_guard<std::mutex> guard(_self->lock);
+    size_t used = 0;
+    for (Arena* a = _self->arenas; a; a = a->next)
+        used += a->Used();
+    return used;
+}
+
+} // lab
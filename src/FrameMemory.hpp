@@ -0,0 +1,63 @@
+//
+//  FrameMemory.hpp
+//  LabExcelsior
+//
+//  Per-frame, per-thread linear allocation for transient data.
+//
+
+
+/*
+ FrameMemory hands every thread its own bump allocator, as a
+ std::pmr::memory_resource, so modes can build draw lists, hit-test buffers
+ and strings for the frame with std::pmr containers and no heap traffic:
+
+     std::pmr::vector<Vertex> verts(mm->FrameMemory());
+
+ Everything allocated is released at once by Reset, which ModeManager calls
+ at the top of UpdateTransactionQueueAndModes; deallocate does nothing. If a
+ frame outgrows a thread's block, more blocks are chained on, and the next
+ Reset folds them into one block big enough for the whole frame, so steady
+ state frames never touch the heap.
+
+ Nothing allocated here may be used after the frame. With LAB_FRAME_POISON
+ (on by default in debug builds) Reset fills the released memory with 0xdd,
+ and under AddressSanitizer it is also poisoned, so stale use faults at once.
+ */
+
+#ifndef FrameMemory_h
+#define FrameMemory_h
+
+#include <cstddef>
+#include <memory_resource>
+
+#if !defined(LAB_FRAME_POISON) && !defined(NDEBUG)
+#define LAB_FRAME_POISON 1
+#endif
+
+namespace lab {
+
+class FrameMemory
+{
+    struct data;
+    data* _self;
+
+public:
+    explicit FrameMemory(size_t blockSize = 64 * 1024);
+    ~FrameMemory();
+
+    FrameMemory(const FrameMemory&) = delete;
+    FrameMemory& operator=(const FrameMemory&) = delete;
+
+    // the calling thread's allocator, valid until the FrameMemory goes away
+    std::pmr::memory_resource* Resource();
+
+    // releases every thread's allocations, no thread may be allocating meanwhile
+    void Reset();
+
+    // bytes handed out since the last Reset, over all threads
+    size_t Used() const;
+};
+
+} // lab
+
+#endif /* FrameMemory_h */
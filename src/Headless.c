@@ -0,0 +1,263 @@
+//
+//  Headless.c
+//  LabExcelsior
+//
+//  Offscreen OpenGL rendering without a window or a display server, see Headless.h
+//
+
+#include "Headless.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) && !defined(__APPLE__)
+#define LAB_HEADLESS_EGL
+
+#include <dlfcn.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+#ifdef LAB_HEADLESS_EGL
+
+// shared by every context, for LabHeadlessGetProcAddress. Only set while a
+// context is alive, the pointer goes stale once libEGL is closed
+static PFNEGLGETPROCADDRESSPROC lab_headless_getProcAddress;
+static int lab_headless_live;
+
+struct LabHeadless {
+    int width, height;
+
+    void* egl;
+    EGLDisplay display;
+    EGLContext context;
+    EGLSurface surface;     // EGL_NO_SURFACE on the surfaceless platform
+    int live;               // counted in lab_headless_live
+
+    GLuint fbo, color, depth;
+
+    PFNEGLGETPROCADDRESSPROC getProcAddress;
+    PFNEGLTERMINATEPROC terminate;
+    PFNEGLMAKECURRENTPROC makeCurrent;
+    PFNEGLDESTROYCONTEXTPROC destroyContext;
+    PFNEGLDESTROYSURFACEPROC destroySurface;
+
+    PFNGLGENFRAMEBUFFERSPROC genFramebuffers;
+    PFNGLDELETEFRAMEBUFFERSPROC deleteFramebuffers;
+    PFNGLBINDFRAMEBUFFERPROC bindFramebuffer;
+    PFNGLFRAMEBUFFERRENDERBUFFERPROC framebufferRenderbuffer;
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC checkFramebufferStatus;
+    PFNGLGENRENDERBUFFERSPROC genRenderbuffers;
+    PFNGLDELETERENDERBUFFERSPROC deleteRenderbuffers;
+    PFNGLBINDRENDERBUFFERPROC bindRenderbuffer;
+    PFNGLRENDERBUFFERSTORAGEPROC renderbufferStorage;
+};
+
+static int LabHeadlessCreateContext(LabHeadless* h) {
+    h->egl = dlopen("libEGL.so.1", RTLD_LAZY | RTLD_LOCAL);
+    if (h->egl == NULL)
+        h->egl = dlopen("libEGL.so", RTLD_LAZY | RTLD_LOCAL);
+    if (h->egl == NULL)
+        return 0;
+
+    PFNEGLGETPROCADDRESSPROC getProcAddress = h->getProcAddress = (PFNEGLGETPROCADDRESSPROC)dlsym(h->egl, "eglGetProcAddress");
+    PFNEGLGETDISPLAYPROC getDisplay = (PFNEGLGETDISPLAYPROC)dlsym(h->egl, "eglGetDisplay");
+    PFNEGLQUERYSTRINGPROC queryString = (PFNEGLQUERYSTRINGPROC)dlsym(h->egl, "eglQueryString");
+    PFNEGLINITIALIZEPROC initialize = (PFNEGLINITIALIZEPROC)dlsym(h->egl, "eglInitialize");
+    PFNEGLBINDAPIPROC bindAPI = (PFNEGLBINDAPIPROC)dlsym(h->egl, "eglBindAPI");
+    PFNEGLCHOOSECONFIGPROC chooseConfig = (PFNEGLCHOOSECONFIGPROC)dlsym(h->egl, "eglChooseConfig");
+    PFNEGLCREATECONTEXTPROC createContext = (PFNEGLCREATECONTEXTPROC)dlsym(h->egl, "eglCreateContext");
+    PFNEGLCREATEPBUFFERSURFACEPROC createPbufferSurface = (PFNEGLCREATEPBUFFERSURFACEPROC)dlsym(h->egl, "eglCreatePbufferSurface");
+    h->terminate = (PFNEGLTERMINATEPROC)dlsym(h->egl, "eglTerminate");
+    h->makeCurrent = (PFNEGLMAKECURRENTPROC)dlsym(h->egl, "eglMakeCurrent");
+    h->destroyContext = (PFNEGLDESTROYCONTEXTPROC)dlsym(h->egl, "eglDestroyContext");
+    h->destroySurface = (PFNEGLDESTROYSURFACEPROC)dlsym(h->egl, "eglDestroySurface");
+
+    if (!getProcAddress || !getDisplay || !queryString || !initialize || !bindAPI || !chooseConfig ||
+        !createContext || !createPbufferSurface || !h->terminate || !h->makeCurrent || !h->destroyContext || !h->destroySurface)
+        return 0;
+
+    // the surfaceless platform needs no display server at all
+    int surfaceless = 0;
+    const char* clientExtensions = queryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)getProcAddress("eglGetPlatformDisplayEXT");
+
+    h->display = EGL_NO_DISPLAY;
+    if (clientExtensions != NULL && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && getPlatformDisplay != NULL) {
+        h->display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        surfaceless = (h->display != EGL_NO_DISPLAY && initialize(h->display, NULL, NULL));
+    }
+
+    if (!surfaceless) {
+        h->display = getDisplay(EGL_DEFAULT_DISPLAY);
+        if (h->display == EGL_NO_DISPLAY || !initialize(h->display, NULL, NULL))
+            return 0;
+    }
+
+    if (!bindAPI(EGL_OPENGL_API))
+        return 0;
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!chooseConfig(h->display, configAttribs, &config, 1, &configCount) || configCount == 0)
+        return 0;
+
+    // a compatibility context, so immediate mode drawing (as in main.c) works too
+    h->context = createContext(h->display, config, EGL_NO_CONTEXT, NULL);
+    if (h->context == EGL_NO_CONTEXT)
+        return 0;
+
+    h->surface = EGL_NO_SURFACE;
+    if (!surfaceless) {
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        h->surface = createPbufferSurface(h->display, config, pbufferAttribs);
+        if (h->surface == EGL_NO_SURFACE)
+            return 0;
+    }
+
+    if (!h->makeCurrent(h->display, h->surface, h->surface, h->context))
+        return 0;
+
+    #define LAB_HEADLESS_LOAD(field, type, name) \
+        if ((h->field = (type)getProcAddress(name)) == NULL) return 0;
+
+    LAB_HEADLESS_LOAD(genFramebuffers, PFNGLGENFRAMEBUFFERSPROC, "glGenFramebuffers");
+    LAB_HEADLESS_LOAD(deleteFramebuffers, PFNGLDELETEFRAMEBUFFERSPROC, "glDeleteFramebuffers");
+    LAB_HEADLESS_LOAD(bindFramebuffer, PFNGLBINDFRAMEBUFFERPROC, "glBindFramebuffer");
+    LAB_HEADLESS_LOAD(framebufferRenderbuffer, PFNGLFRAMEBUFFERRENDERBUFFERPROC, "glFramebufferRenderbuffer");
+    LAB_HEADLESS_LOAD(checkFramebufferStatus, PFNGLCHECKFRAMEBUFFERSTATUSPROC, "glCheckFramebufferStatus");
+    LAB_HEADLESS_LOAD(genRenderbuffers, PFNGLGENRENDERBUFFERSPROC, "glGenRenderbuffers");
+    LAB_HEADLESS_LOAD(deleteRenderbuffers, PFNGLDELETERENDERBUFFERSPROC, "glDeleteRenderbuffers");
+    LAB_HEADLESS_LOAD(bindRenderbuffer, PFNGLBINDRENDERBUFFERPROC, "glBindRenderbuffer");
+    LAB_HEADLESS_LOAD(renderbufferStorage, PFNGLRENDERBUFFERSTORAGEPROC, "glRenderbufferStorage");
+
+    #undef LAB_HEADLESS_LOAD
+    return 1;
+}
+
+LabHeadless* LabHeadlessCreate(int width, int height) {
+    LabHeadless* h = (LabHeadless*)calloc(1, sizeof(LabHeadless));
+    if (h == NULL)
+        return NULL;
+
+    h->width = width;
+    h->height = height;
+    h->display = EGL_NO_DISPLAY;
+    h->context = EGL_NO_CONTEXT;
+    h->surface = EGL_NO_SURFACE;
+
+    if (!LabHeadlessCreateContext(h)) {
+        LabHeadlessDestroy(h);
+        return NULL;
+    }
+
+    h->genRenderbuffers(1, &h->color);
+    h->bindRenderbuffer(GL_RENDERBUFFER, h->color);
+    h->renderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    h->genRenderbuffers(1, &h->depth);
+    h->bindRenderbuffer(GL_RENDERBUFFER, h->depth);
+    h->renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    h->genFramebuffers(1, &h->fbo);
+    h->bindFramebuffer(GL_FRAMEBUFFER, h->fbo);
+    h->framebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, h->color);
+    h->framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, h->depth);
+
+    if (h->checkFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        LabHeadlessDestroy(h);
+        return NULL;
+    }
+
+    glViewport(0, 0, width, height);
+
+    h->live = 1;
+    lab_headless_live++;
+    lab_headless_getProcAddress = h->getProcAddress;
+    return h;
+}
+
+void* LabHeadlessGetProcAddress(const char* name) {
+    return lab_headless_getProcAddress ? (void*)lab_headless_getProcAddress(name) : NULL;
+}
+
+void LabHeadlessBeginFrame(LabHeadless* h) {
+    h->bindFramebuffer(GL_FRAMEBUFFER, h->fbo);
+    glViewport(0, 0, h->width, h->height);
+}
+
+void LabHeadlessEndFrame(LabHeadless* h) {
+    (void)h;
+    glFlush();
+}
+
+void LabHeadlessResize(LabHeadless* h, int width, int height) {
+    if (width <= 0 || height <= 0 || (width == h->width && height == h->height))
+        return;
+
+    // new storage for the same renderbuffers, the framebuffer keeps them attached
+    h->bindRenderbuffer(GL_RENDERBUFFER, h->color);
+    h->renderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    h->bindRenderbuffer(GL_RENDERBUFFER, h->depth);
+    h->renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    h->width = width;
+    h->height = height;
+}
+
+void LabHeadlessFinish(LabHeadless* h) {
+    (void)h;
+    glFinish();
+}
+
+void LabHeadlessDestroy(LabHeadless* h) {
+    if (h == NULL)
+        return;
+
+    if (h->live && --lab_headless_live == 0)
+        lab_headless_getProcAddress = NULL;
+
+    if (h->context != EGL_NO_CONTEXT && h->deleteRenderbuffers != NULL) {
+        h->deleteFramebuffers(1, &h->fbo);
+        h->deleteRenderbuffers(1, &h->color);
+        h->deleteRenderbuffers(1, &h->depth);
+    }
+
+    if (h->display != EGL_NO_DISPLAY) {
+        h->makeCurrent(h->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (h->surface != EGL_NO_SURFACE)
+            h->destroySurface(h->display, h->surface);
+        if (h->context != EGL_NO_CONTEXT)
+            h->destroyContext(h->display, h->context);
+        h->terminate(h->display);
+    }
+
+    if (h->egl != NULL)
+        dlclose(h->egl);
+
+    free(h);
+}
+
+#else
+
+// only EGL is supported for now
+
+LabHeadless* LabHeadlessCreate(int width, int height) { (void)width; (void)height; return NULL; }
+void LabHeadlessDestroy(LabHeadless* h) { (void)h; }
+void* LabHeadlessGetProcAddress(const char* name) { (void)name; return NULL; }
+void LabHeadlessBeginFrame(LabHeadless* h) { (void)h; }
+void LabHeadlessEndFrame(LabHeadless* h) { (void)h; }
+void LabHeadlessResize(LabHeadless* h, int width, int height) { (void)h; (void)width; (void)height; }
+void LabHeadlessFinish(LabHeadless* h) { (void)h; }
+
+#endif
@@ -0,0 +1,50 @@
+//
+//  Headless.h
+//  LabExcelsior
+//
+//  Offscreen OpenGL rendering without a window or a display server.
+//
+
+
+/*
+ LabHeadlessCreate makes an OpenGL context through EGL, on Mesa's surfaceless
+ platform when it's there (no X server, no GPU needed with llvmpipe), or with a
+ 1x1 pbuffer on the default display otherwise. libEGL is loaded at runtime.
+
+ Frames are drawn into a framebuffer object. Between LabHeadlessBeginFrame and
+ LabHeadlessEndFrame, draw the same way as into a window, e.g.
+ ModeManager::RunModeRendering. To get the pixels back, call
+ LabFrameCaptureFrame (FrameCapture.h) before LabHeadlessEndFrame, with
+ LabHeadlessGetProcAddress as its loader.
+ */
+
+#ifndef Headless_h
+#define Headless_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct LabHeadless LabHeadless;
+
+// returns NULL if no EGL / OpenGL context could be made, the context is current on return
+LabHeadless* LabHeadlessCreate(int width, int height);
+void         LabHeadlessDestroy(LabHeadless*);
+
+// GL entry points of the headless context, NULL while there is none
+void* LabHeadlessGetProcAddress(const char* name);
+
+void LabHeadlessBeginFrame(LabHeadless*);
+void LabHeadlessEndFrame(LabHeadless*);
+
+// the size frames are drawn at, like a window being resized. Call outside a frame
+void LabHeadlessResize(LabHeadless*, int width, int height);
+
+// waits for the GPU to finish every frame
+void LabHeadlessFinish(LabHeadless*);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* Headless_h */
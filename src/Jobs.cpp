@@ -0,0 +1,283 @@
+//
+//  Jobs.cpp
+//  LabExcelsior
+//
+//  A work-stealing job system, see Jobs.hpp
+//
+
+#include "Jobs.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lab
+{
+
+namespace {
+
+constexpr size_t kPoolSize = 1024;      // jobs each worker can have outstanding, a power of two
+constexpr int kSpins = 64;              // empty looks before a worker sleeps
+
+// Chase-Lev, with the memory orders of Lê et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models", PPoPP 2013. Fixed size, a full
+// deque makes Push fail and the caller runs the job itself.
+class WorkDeque
+{
+    std::atomic<int64_t> _top { 0 };
+    std::atomic<int64_t> _bottom { 0 };
+    std::atomic<Job*> _buffer[kPoolSize];
+
+public:
+    // owner only
+    bool Push(Job* job) {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        if (b - t >= (int64_t)kPoolSize)
+            return false;
+
+        _buffer[b & (kPoolSize - 1)].store(job, std::memory_order_relaxed);
+        _bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // owner only, newest first
+    Job* Pop() {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job* job = _buffer[b & (kPoolSize - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // the last one, a thief may be taking it too
+            if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+            _bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    // any thread, oldest first
+    Job* Steal() {
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        Job* job = _buffer[t & (kPoolSize - 1)].load(std::memory_order_relaxed);
+        if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return job;
+    }
+};
+
+struct Worker {
+    WorkDeque deque;
+    Job pool[kPoolSize];
+    size_t next = 0;
+    uint32_t random = 0;
+};
+
+// which worker of which system the current thread is
+struct ThreadWorker {
+    const void* system = nullptr;
+    unsigned int index = 0;
+};
+thread_local ThreadWorker tWorker;
+
+} // anon
+
+struct JobSystem::data {
+    unsigned int count = 0;
+    std::unique_ptr<Worker[]> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<Job*> injected;              // from threads that aren't workers, guarded by lock
+
+    std::atomic<int64_t> queued { 0 };      // submitted and not yet taken
+    std::atomic<int> sleeping { 0 };
+    std::atomic<bool> quit { false };
+
+    Worker* Current() {
+        return tWorker.system == this ? &workers[tWorker.index] : nullptr;
+    }
+
+    Job* Take() {
+        Worker* self = Current();
+        Job* job = self ? self->deque.Pop() : nullptr;
+
+        if (!job && queued.load(std::memory_order_relaxed) > 0) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!injected.empty()) {
+                    job = injected.front();
+                    injected.pop_front();
+                }
+            }
+
+            // a random victim first, then everyone, so thieves don't all pile onto worker 0
+            uint32_t start = 0;
+            if (self) {
+                self->random = self->random * 1664525u + 1013904223u;
+                start = self->random >> 8;
+            }
+            for (unsigned int i = 0; !job && i < count; i++) {
+                Worker& victim = workers[(start + i) % count];
+                if (&victim != self)
+                    job = victim.deque.Steal();
+            }
+        }
+
+        if (job)
+            queued.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    static void Run(Job* job) {
+        JobCounter* counter = job->counter;
+        job->run(job);
+        Finish(job, counter);
+    }
+
+    static void Finish(Job* job, JobCounter* counter) {
+        // the counter may be gone as soon as it reaches zero, it's the last thing touched
+        if (job->heap)
+            delete job;
+        else
+            job->busy.store(false, std::memory_order_release);
+        counter->_pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void Loop(unsigned int index) {
+        tWorker = { this, index };
+        workers[index].random = 0x9E3779B9u * (index + 1);
+
+        int idle = 0;
+        while (!quit.load(std::memory_order_acquire)) {
+            if (Job* job = Take()) {
+                Run(job);
+                idle = 0;
+                continue;
+            }
+
+            if (++idle < kSpins) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> guard(lock);
+            sleeping.fetch_add(1, std::memory_order_seq_cst);
+            wake.wait(guard, [this]() {
+                return quit.load(std::memory_order_acquire) || queued.load(std::memory_order_seq_cst) > 0;
+            });
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+            idle = 0;
+        }
+    }
+};
+
+JobSystem::JobSystem(unsigned int workers)
+: _self(new data())
+{
+    if (workers == 0)
+        workers = std::thread::hardware_concurrency();
+    if (workers == 0)
+        workers = 1;
+
+    _self->count = workers;
+    _self->workers.reset(new Worker[workers]);
+
+    // the creating thread is worker 0, it works while it waits
+    tWorker = { _self, 0 };
+    _self->workers[0].random = 0x9E3779B9u;
+
+    for (unsigned int i = 1; i < workers; i++)
+        _self->threads.emplace_back([this, i]() { _self->Loop(i); });
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> guard(_self->lock);
+        _self->quit.store(true, std::memory_order_release);
+    }
+    _self->wake.notify_all();
+
+    for (auto& t : _self->threads)
+        t.join();
+
+    if (tWorker.system == _self)
+        tWorker = ThreadWorker();
+
+    delete _self;
+}
+
+unsigned int JobSystem::Workers() const {
+    return _self->count;
+}
+
+Job* JobSystem::_allocate() {
+    Worker* self = _self->Current();
+    if (!self) {
+        Job* job = new Job();
+        job->heap = true;
+        return job;
+    }
+
+    Job* job = &self->pool[self->next++ & (kPoolSize - 1)];
+    if (job->busy.load(std::memory_order_acquire))
+        return nullptr;
+
+    job->busy.store(true, std::memory_order_relaxed);
+    return job;
+}
+
+void JobSystem::_submit(Job* job) {
+    Worker* self = _self->Current();
+    if (self) {
+        if (!self->deque.Push(job)) {
+            data::Run(job);
+            return;
+        }
+    }
+    else {
+        std::lock_guard<std::mutex> guard(_self->lock);
+        _self->injected.push_back(job);
+    }
+
+    _self->queued.fetch_add(1, std::memory_order_seq_cst);
+    if (_self->sleeping.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> guard(_self->lock);
+        _self->wake.notify_one();
+    }
+}
+
+bool JobSystem::RunOne() {
+    Job* job = _self->Take();
+    if (!job)
+        return false;
+    data::Run(job);
+    return true;
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    int idle = 0;
+    while (!counter.Done()) {
+        if (RunOne())
+            idle = 0;
+        else if (++idle > kSpins)
+            std::this_thread::yield();
+    }
+}
+
+} // lab
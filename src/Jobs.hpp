@@ -0,0 +1,158 @@
+//
+//  Jobs.hpp
+//  LabExcelsior
+//
+//  A work-stealing job system shared by the modes and the frame loop.
+//
+
+
+/*
+ Every worker thread owns a Chase-Lev deque. A thread pushes and pops jobs at
+ the bottom of its own deque, and when it runs dry it steals from the top of
+ someone else's, so forked work spreads out without a shared queue. The thread
+ that creates the JobSystem (the frame loop) is worker 0 and runs jobs too
+ while it waits. Any other thread can submit as well, its jobs go through a
+ small locked queue the workers also take from.
+
+ A JobCounter counts the jobs spawned against it that haven't finished;
+ Wait runs jobs until it reaches zero, so fork/join nests freely:
+
+     lab::JobCounter done;
+     jobs.Spawn(done, [&]() { left(); });
+     right();
+     jobs.Wait(done);
+
+     jobs.ParallelFor(0, count, 1024, [&](size_t begin, size_t end) { ... });
+
+ Jobs live in a fixed pool per thread, their closures are stored inline and
+ must fit in Job::kInline bytes; capture by reference, or a pointer to the
+ state. ModeManager::Jobs() is the one the modes use, and FrameJobs() counts
+ work that only has to be done by the start of the next frame.
+ */
+
+#ifndef Jobs_h
+#define Jobs_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace lab {
+
+class JobSystem;
+
+class JobCounter
+{
+    friend class JobSystem;
+    std::atomic<int> _pending { 0 };
+
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool Done() const { return _pending.load(std::memory_order_acquire) == 0; }
+};
+
+struct Job {
+    static constexpr size_t kInline = 48;
+
+    void (*run)(Job*) = nullptr;
+    JobCounter* counter = nullptr;
+    std::atomic<bool> busy { false };    // the slot is in use until the job has run
+    bool heap = false;                   // submitted from outside the workers, deleted once run
+    alignas(std::max_align_t) unsigned char data[kInline];
+};
+
+class JobSystem
+{
+    struct data;
+    data* _self;
+
+    Job* _allocate();
+    void _submit(Job*);
+
+    template <typename F>
+    static void _trampoline(Job* job) {
+        F* f = reinterpret_cast<F*>(job->data);
+        (*f)();
+        f->~F();
+    }
+
+    template <typename F>
+    struct Range {
+        JobSystem* jobs;
+        JobCounter* counter;
+        size_t begin, end, grain;
+        const F* f;
+
+        // splits off the upper half until the range is grain sized, then runs it
+        void operator()() const {
+            size_t b = begin, e = end;
+            while (e - b > grain) {
+                size_t mid = b + (e - b) / 2;
+                jobs->Spawn(*counter, Range { jobs, counter, mid, e, grain, f });
+                e = mid;
+            }
+            (*f)(b, e);
+        }
+    };
+
+public:
+    // workers counts the calling thread, 0 picks one per hardware thread
+    explicit JobSystem(unsigned int workers = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned int Workers() const;
+
+    template <typename F>
+    void Spawn(JobCounter& counter, F&& f) {
+        using Fn = typename std::decay<F>::type;
+        static_assert(sizeof(Fn) <= Job::kInline, "job closure too large, capture a pointer to the state instead");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "job closure over-aligned");
+
+        counter._pending.fetch_add(1, std::memory_order_relaxed);
+        Job* job = _allocate();
+        if (!job) {
+            // the pool is full of jobs that haven't run yet, don't queue more
+            f();
+            counter._pending.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+
+        new (job->data) Fn(std::forward<F>(f));
+        job->run = &_trampoline<Fn>;
+        job->counter = &counter;
+        _submit(job);
+    }
+
+    // runs jobs until counter reaches zero
+    void Wait(JobCounter& counter);
+
+    // f(begin, end) over [begin, end) in chunks of at most grain, returns when all are done
+    template <typename F>
+    void ParallelFor(size_t begin, size_t end, size_t grain, const F& f) {
+        if (begin >= end)
+            return;
+        if (grain == 0)
+            grain = 1;
+
+        JobCounter counter;
+        Range<F> { this, &counter, begin, end, grain, &f }();
+        Wait(counter);
+    }
+
+    // runs one pending job if there is one, for loops that poll
+    bool RunOne();
+};
+
+} // lab
+
+#endif /* Jobs_h */
@@ -0,0 +1,241 @@
+//
+//  Latency.c
+//  LabExcelsior
+//
+//  Input to photon latency harness, see Latency.h
+//
+
+#include "Latency.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(__unix__) && !defined(__APPLE__)
+#define LAB_LATENCY_XTEST
+#include <X11/Xlib.h>
+#include <dlfcn.h>
+#endif
+
+// bucket b holds latencies in [2^b, 2^(b+1)) microseconds, the last one is open ended
+#define LAB_LATENCY_BUCKETS 24
+#define LAB_LATENCY_TIMEOUT 1000000000ull // ns before an in-flight probe is given up on
+
+typedef struct LabLatencyHistogram {
+    unsigned int count;
+    uint64_t sum, min, max; // ns
+    unsigned int buckets[LAB_LATENCY_BUCKETS];
+} LabLatencyHistogram;
+
+static const char* LabLatencyStageNames[LAB_LATENCY_STAGE_COUNT] = {
+    "inject", "event", "dispatch", "render", "swap", "finish"
+};
+
+static struct {
+    int enabled;
+    unsigned int remaining;     // probes left to inject
+    unsigned int next;          // id of the next probe
+    unsigned int inFlight;      // 0 if none
+    unsigned int lost;
+    int pending;                // the in-flight probe's event hasn't been seen yet
+    uint64_t stamps[LAB_LATENCY_STAGE_COUNT];
+    LabLatencyHistogram histograms[LAB_LATENCY_STAGE_COUNT];
+
+#ifdef LAB_LATENCY_XTEST
+    Display* display;
+    void* xtst;
+    int (*fakeMotion)(Display*, int, int, int, unsigned long);
+#endif
+} lab_latency;
+
+static uint64_t LabLatencyNow(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+int LabLatencyBegin(unsigned int probes) {
+    memset(&lab_latency, 0, sizeof(lab_latency));
+
+#ifdef LAB_LATENCY_XTEST
+    // a connection of its own, the same as any other client sending input
+    lab_latency.display = XOpenDisplay(NULL);
+    if (lab_latency.display == NULL)
+        return 0;
+
+    lab_latency.xtst = dlopen("libXtst.so.6", RTLD_LAZY | RTLD_LOCAL);
+    if (lab_latency.xtst == NULL)
+        lab_latency.xtst = dlopen("libXtst.so", RTLD_LAZY | RTLD_LOCAL);
+
+    if (lab_latency.xtst != NULL)
+        *(void**)&lab_latency.fakeMotion = dlsym(lab_latency.xtst, "XTestFakeMotionEvent");
+
+    if (lab_latency.fakeMotion == NULL) {
+        LabLatencyEnd();
+        return 0;
+    }
+
+    lab_latency.enabled = 1;
+    lab_latency.remaining = probes;
+    lab_latency.next = 1;
+    return 1;
+#else
+    (void)probes;
+    return 0;
+#endif
+}
+
+int LabLatencyActive(void) {
+    return lab_latency.enabled && (lab_latency.remaining || lab_latency.inFlight);
+}
+
+unsigned int LabLatencyInject(int x, int y) {
+    if (!lab_latency.enabled)
+        return 0;
+
+    if (lab_latency.inFlight) {
+        if (LabLatencyNow() - lab_latency.stamps[LAB_LATENCY_INJECT] < LAB_LATENCY_TIMEOUT)
+            return 0;
+
+        lab_latency.lost++;
+        lab_latency.inFlight = 0;
+    }
+
+    if (lab_latency.remaining == 0)
+        return 0;
+
+#ifdef LAB_LATENCY_XTEST
+    unsigned int probe = lab_latency.next++;
+    lab_latency.remaining--;
+
+    memset(lab_latency.stamps, 0, sizeof(lab_latency.stamps));
+    lab_latency.inFlight = probe;
+    lab_latency.pending = 1;
+
+    // every other probe is a pixel over, so the pointer always moves
+    lab_latency.fakeMotion(lab_latency.display, -1, x + (int)(probe & 1), y, 0);
+    XFlush(lab_latency.display);
+    lab_latency.stamps[LAB_LATENCY_INJECT] = LabLatencyNow();
+    return probe;
+#else
+    (void)x; (void)y;
+    return 0;
+#endif
+}
+
+unsigned int LabLatencyPending(void) {
+    return lab_latency.pending ? lab_latency.inFlight : 0;
+}
+
+void LabLatencyStamp(unsigned int probe, LabLatencyStage stage) {
+    if (probe == 0 || probe != lab_latency.inFlight)
+        return;
+
+    if (stage == LAB_LATENCY_EVENT)
+        lab_latency.pending = 0;
+
+    lab_latency.stamps[stage] = LabLatencyNow();
+}
+
+void LabLatencyFinish(unsigned int probe) {
+    if (probe == 0 || probe != lab_latency.inFlight)
+        return;
+
+    uint64_t injected = lab_latency.stamps[LAB_LATENCY_INJECT];
+
+    int stage;
+    for (stage = LAB_LATENCY_EVENT; stage < LAB_LATENCY_STAGE_COUNT; stage++) {
+        if (lab_latency.stamps[stage] == 0)
+            continue; // the application doesn't go through this stage
+
+        LabLatencyHistogram* h = &lab_latency.histograms[stage];
+        uint64_t ns = lab_latency.stamps[stage] - injected;
+
+        uint64_t us = ns / 1000;
+        int bucket = 0;
+        while (us > 1 && bucket < LAB_LATENCY_BUCKETS - 1) {
+            us >>= 1;
+            bucket++;
+        }
+
+        if (h->count == 0 || ns < h->min)
+            h->min = ns;
+        if (ns > h->max)
+            h->max = ns;
+
+        h->sum += ns;
+        h->count++;
+        h->buckets[bucket]++;
+    }
+
+    lab_latency.inFlight = 0;
+    lab_latency.pending = 0;
+}
+
+// upper bound (in us) of the bucket holding the given fraction of the samples
+static uint64_t LabLatencyPercentile(const LabLatencyHistogram* h, double fraction) {
+    unsigned int target = (unsigned int)((double)h->count * fraction);
+    unsigned int seen = 0;
+
+    int b;
+    for (b = 0; b < LAB_LATENCY_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen > target)
+            break;
+    }
+
+    return 1ull << (b + 1);
+}
+
+void LabLatencyEnd(void) {
+    if (lab_latency.enabled) {
+        printf("latency from injection, %u probes lost\n", lab_latency.lost);
+
+        int stage;
+        for (stage = LAB_LATENCY_EVENT; stage < LAB_LATENCY_STAGE_COUNT; stage++) {
+            const LabLatencyHistogram* h = &lab_latency.histograms[stage];
+            if (h->count == 0)
+                continue;
+
+            printf("%-9s n %-6u min %8.3f ms  mean %8.3f ms  p50 < %8.3f ms  p99 < %8.3f ms  max %8.3f ms\n",
+                   LabLatencyStageNames[stage], h->count,
+                   (double)h->min / 1e6, (double)h->sum / (double)h->count / 1e6,
+                   (double)LabLatencyPercentile(h, 0.5) / 1e3, (double)LabLatencyPercentile(h, 0.99) / 1e3,
+                   (double)h->max / 1e6);
+
+            int b;
+            for (b = 0; b < LAB_LATENCY_BUCKETS; b++) {
+                if (h->buckets[b] == 0)
+                    continue;
+
+                int width = (int)(50.0 * h->buckets[b] / h->count) + 1;
+                printf("    < %9.3f ms %6u %.*s\n", (double)(1ull << (b + 1)) / 1e3, h->buckets[b],
+                       width, "##################################################");
+            }
+        }
+    }
+
+#ifdef LAB_LATENCY_XTEST
+    if (lab_latency.xtst != NULL)
+        dlclose(lab_latency.xtst);
+    if (lab_latency.display != NULL)
+        XCloseDisplay(lab_latency.display);
+#endif
+
+    memset(&lab_latency, 0, sizeof(lab_latency));
+}
@@ -0,0 +1,67 @@
+//
+//  Latency.h
+//  LabExcelsior
+//
+//  Input to photon latency harness.
+//
+
+
+/*
+ The harness injects synthetic pointer motion with XTest (so it runs under
+ Xvfb / llvmpipe without a user), and the application stamps the probe as it
+ moves through the frame. Only one probe is in flight at a time, so the first
+ mouse move seen after an injection belongs to it.
+
+     LabLatencyBegin(n)              once, after the window exists
+     LabLatencyInject(x, y)          each frame, it does nothing while a probe is in flight
+     LabLatencyPending()             on a mouse move, the probe it belongs to
+     LabLatencyStamp(probe, stage)   as the probe passes each stage
+     LabLatencyFinish(probe)         after the last stage, records the histograms
+     LabLatencyEnd()                 prints the histograms
+
+ Every stage is measured from the injection. libXtst is loaded at runtime,
+ LabLatencyBegin returns 0 if it, or an X display, isn't available.
+ */
+
+#ifndef Latency_h
+#define Latency_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum LabLatencyStage {
+    LAB_LATENCY_INJECT,     // the XTest request was flushed to the server
+    LAB_LATENCY_EVENT,      // the mouse move came out of the event queue
+    LAB_LATENCY_DISPATCH,   // the interaction reached the modes (RunViewportDragging)
+    LAB_LATENCY_RENDER,     // the frame using it was submitted (RunModeRendering)
+    LAB_LATENCY_SWAP,       // RGFW_window_swapBuffers returned
+    LAB_LATENCY_FINISH,     // glFinish returned, the frame is done on the GPU
+    LAB_LATENCY_STAGE_COUNT
+} LabLatencyStage;
+
+// probes is how many samples to take, returns 1 if input can be injected
+int  LabLatencyBegin(unsigned int probes);
+
+// 1 while there are probes left to inject or one is in flight
+int  LabLatencyActive(void);
+
+// moves the pointer to x, y (root window coordinates) and returns the new
+// probe, or 0 if a probe is still in flight or none are left.
+// A probe that hasn't finished after a second is counted as lost.
+unsigned int LabLatencyInject(int x, int y);
+
+// the in-flight probe, if its input event hasn't been stamped yet
+unsigned int LabLatencyPending(void);
+
+void LabLatencyStamp(unsigned int probe, LabLatencyStage stage);
+void LabLatencyFinish(unsigned int probe);
+
+// prints a histogram per stage and releases the XTest connection
+void LabLatencyEnd(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* Latency_h */
@@ -7,42 +7,174 @@
 //
 
 #include "Modes.hpp"
+#include "FrameMemory.hpp"
+#include "Jobs.hpp"
+#include "Plugins.hpp"
 #include "concurrentqueue.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <set>
+#include <vector>
+
+// The C modes of a ModeManager. Each phase has a contiguous array of the
+// active modes that implement it, rebuilt when a mode is activated or
+// deactivated, so running a phase is one loop over plain function pointers
+// instead of a virtual call through a shared_ptr per mode.
+struct CModeManager {
+    struct Call {
+        void (*fn)(CMode*, const CViewInteraction*);
+        CMode* mode;
+    };
+    struct Bid {
+        int (*bid)(CMode*, const CViewInteraction*);
+        void (*fn)(CMode*, const CViewInteraction*);
+        CMode* mode;
+    };
+
+    lab::ModeManager* mm = nullptr;
+    bool ownsManager = false;           // made by ExcelsiorCreateModeManager
+
+    std::vector<CMode*> modes;          // registered, in registration order
+    std::vector<CMode*> update;         // every registered mode, as C++ minor modes are all updated
+    std::vector<Call> render;
+    std::vector<Bid> hover, drag;
+    bool dirty = false;
+
+    void Rebuild() {
+        if (!dirty)
+            return;
+
+        update.clear();
+        render.clear();
+        hover.clear();
+        drag.clear();
+
+        for (CMode* m : modes) {
+            if (m->update)
+                update.push_back(m);
+            if (!m->active)
+                continue;
+            if (m->render)
+                render.push_back({ m->render, m });
+            if (m->hoverBid && m->hovering)
+                hover.push_back({ m->hoverBid, m->hovering, m });
+            if (m->dragBid && m->dragging)
+                drag.push_back({ m->dragBid, m->dragging, m });
+        }
+        dirty = false;
+    }
+
+    void Update() {
+        Rebuild();
+        for (CMode* m : update)
+            m->update(m, this);
+    }
+
+    void Render(const CViewInteraction& vi) {
+        Rebuild();
+        for (const Call& c : render)
+            c.fn(c.mode, &vi);
+    }
+
+    // the C mode bidding higher than highest, which is raised to its bid; nullptr if none did
+    static const Bid* Bidder(const std::vector<Bid>& bids, const CViewInteraction& vi, int& highest) {
+        const Bid* winner = nullptr;
+        for (const Bid& b : bids) {
+            int bid = b.bid(b.mode, &vi);
+            if (bid > highest) {
+                winner = &b;
+                highest = bid;
+            }
+        }
+        return winner;
+    }
+};
 
 namespace lab
 {
 using namespace std;
 
+ViewInteraction::ViewInteraction(const CViewInteraction& c) {
+    view = { c.w, c.h, c.wx, c.wy, c.ww, c.wh };
+    x = c.x;
+    y = c.y;
+    dt = c.dt;
+    start = c.start != 0;
+    end = c.end != 0;
+    samples = c.samples;
+    sampleCount = c.sampleCount;
+    probe = c.probe;
+    stream = c.stream;
+}
+
+CViewInteraction ViewInteraction::C() const {
+    CViewInteraction c;
+    c.w = view.w;
+    c.h = view.h;
+    c.wx = view.wx;
+    c.wy = view.wy;
+    c.ww = view.ww;
+    c.wh = view.wh;
+    c.x = x;
+    c.y = y;
+    c.dt = dt;
+    c.start = start;
+    c.end = end;
+    c.samples = samples;
+    c.sampleCount = sampleCount;
+    c.probe = probe;
+    c.stream = stream;
+    return c;
+}
+
 
 // static
 int JournalNode::count = 0;
 
-// recursively delete all the nodes after this one
-// making this node the end of the journal
+// delete all the nodes after this one
+// making this node the end of the journal.
+// A long session is far deeper than the stack, so this doesn't recurse;
+// each node is unlinked before it is deleted, so its destructor has
+// nothing left to do
 void JournalNode::Truncate(JournalNode* node) {
     if (!node)
         return;
-    if (node->next) {
-        Truncate(node->next);
-        delete node->next;
-        node->next = nullptr;
-    }
-    if (node->sibling) {
-        Truncate(node->sibling);
-        delete node->sibling;
-        node->sibling = nullptr;
+
+    std::vector<JournalNode*> doomed;
+    if (node->next)
+        doomed.push_back(node->next);
+    if (node->sibling)
+        doomed.push_back(node->sibling);
+    node->next = nullptr;
+    node->sibling = nullptr;
+
+    while (!doomed.empty()) {
+        JournalNode* n = doomed.back();
+        doomed.pop_back();
+        if (n->next)
+            doomed.push_back(n->next);
+        if (n->sibling)
+            doomed.push_back(n->sibling);
+        n->next = nullptr;
+        n->sibling = nullptr;
+        delete n;
     }
 }
 
 void Journal::CountHelper(JournalNode* node, int& total) {
-    // recurse the next list, and the sibling lists to count the nodes
-    if (node->next)
-        CountHelper(node->next, total);
-    if (node->sibling)
-        CountHelper(node->sibling, total);
-    ++total;
+    // walk the next list, and the sibling lists to count the nodes
+    std::vector<JournalNode*> pending { node };
+    while (!pending.empty()) {
+        JournalNode* n = pending.back();
+        pending.pop_back();
+        if (n->next)
+            pending.push_back(n->next);
+        if (n->sibling)
+            pending.push_back(n->sibling);
+        ++total;
+    }
 }
 
 Journal::Journal() : _curr(&root) {
@@ -136,6 +268,15 @@ void Journal::Remove(JournalNode* node) {
 struct ModeManager::data {
     moodycamel::ConcurrentQueue<Transaction> work_queue;
     MajorMode* current_major_mode = nullptr;
+    std::atomic<bool> redraw_requested { true }; // the first frame always draws
+    std::function<void()> wake;
+    std::function<void(unsigned int, ModeManager::ProbeStage)> probe;
+    std::function<void(const Transaction&)> executed;
+    CModeManager cmodes;
+    std::unique_ptr<PluginHost> plugins;    // after cmodes, it frees its modes first
+    std::unique_ptr<JobSystem> jobs;
+    JobCounter frame_jobs;
+    lab::FrameMemory frame_memory;
 };
 
 namespace {
@@ -144,14 +285,43 @@ namespace {
 
 ModeManager::ModeManager() {
     _self = new data();
+    _self->cmodes.mm = this;
     gCanonical = this;
 }
 
 ModeManager::~ModeManager() {
+    if (_self->jobs)
+        _self->jobs->Wait(_self->frame_jobs);
+    for (CMode* m : _self->cmodes.modes)
+        m->cmm = nullptr;
     delete _self;
     gCanonical = nullptr;
 }
 
+CModeManager* ModeManager::CModes() const {
+    return &_self->cmodes;
+}
+
+JobSystem& ModeManager::Jobs() {
+    if (!_self->jobs)
+        _self->jobs.reset(new JobSystem());
+    return *_self->jobs;
+}
+
+JobCounter& ModeManager::FrameJobs() {
+    return _self->frame_jobs;
+}
+
+std::pmr::memory_resource* ModeManager::FrameMemory() {
+    return _self->frame_memory.Resource();
+}
+
+bool ModeManager::LoadPlugins(const std::string& directory) {
+    if (!_self->plugins)
+        _self->plugins.reset(new PluginHost(&_self->cmodes, [this]() { RequestRedraw(); }));
+    return _self->plugins->Watch(directory);
+}
+
 //static
 ModeManager* ModeManager::Canonical() {
     return gCanonical;
@@ -163,16 +333,62 @@ MajorMode* ModeManager::CurrentMajorMode() const {
 
 void ModeManager::EnqueueTransaction(Transaction&& work) {
     _self->work_queue.enqueue(work);
+    if (_self->wake)
+        _self->wake();
+}
+
+void ModeManager::RequestRedraw() {
+    _self->redraw_requested.store(true);
+    if (_self->wake)
+        _self->wake();
+}
+
+bool ModeManager::NeedsRedraw() {
+    bool redraw = _self->redraw_requested.exchange(false);
+    // C modes ask for frames with ExcelsiorRequestRedraw
+    for (auto& i : _minor_modes)
+        if (i.second->IsActive() && i.second->IsAnimating())
+            redraw = true;
+    for (auto& i : _major_modes)
+        if (i.second->IsActive() && i.second->IsAnimating())
+            redraw = true;
+    return redraw;
+}
+
+void ModeManager::SetWakeCallback(std::function<void()> wake) {
+    _self->wake = wake;
+}
+
+void ModeManager::SetProbeCallback(std::function<void(unsigned int, ProbeStage)> probe) {
+    _self->probe = probe;
+}
+
+void ModeManager::SetTransactionCallback(std::function<void(const Transaction&)> executed) {
+    _self->executed = executed;
 }
 
 void ModeManager::UpdateTransactionQueueAndModes() {
+    // the previous frame's jobs are done before this frame starts
+    if (_self->jobs)
+        _self->jobs->Wait(_self->frame_jobs);
+
+    // and nothing can still be holding on to its frame memory
+    _self->frame_memory.Reset();
+
+    // swap in any plugins rebuilt since the last frame
+    if (_self->plugins)
+        _self->plugins->Apply();
+
     // complete any pending work
     Transaction work;
     while (_self->work_queue.try_dequeue(work)) {
         if (work.exec) {
             std::cout << "> " << work.message << std::endl;
             work.exec();
+            if (_self->executed)
+                _self->executed(work);
             _journal.Append(std::move(work));
+            _self->redraw_requested.store(true);
         }
     }
 
@@ -185,10 +401,11 @@ void ModeManager::UpdateTransactionQueueAndModes() {
         _activate_major_mode("Empty");
     }
 
-    for (auto i : _minor_modes)
+    for (auto& i : _minor_modes)
         i.second->Update();
-    for (auto i : _major_modes)
+    for (auto& i : _major_modes)
         i.second->Update();
+    _self->cmodes.Update();
 }
 
 std::shared_ptr<Mode> ModeManager::FindMode(const std::string & m)
@@ -241,19 +458,25 @@ void ModeManager::_activate_major_mode(const std::string& name)
     if (maj->MustDeactivateUnrelatedModesOnActivation()) {
         std::vector<std::string> deactivated;
         
-        for (auto minor : _minor_modes) {
+        for (auto& minor : _minor_modes) {
             if (modes.find(minor.first) == modes.end()) {
                 deactivated.push_back(minor.first);
             }
         }
         
-        for (auto i : deactivated) {
+        for (auto& i : deactivated) {
             auto m = FindMode(i);
             if (m) {
                 std::cout << "Deactivating" << m->Name() << std::endl;
                 m->Deactivate();
             }
         }
+
+        for (CMode* m : _self->cmodes.modes)
+            if (m->active && modes.find(m->nameStr) == modes.end()) {
+                std::cout << "Deactivating" << m->nameStr << std::endl;
+                ExcelsiorDeactivateMode(m);
+            }
     }
     
     for (auto& mode : modes) {
@@ -262,6 +485,10 @@ void ModeManager::_activate_major_mode(const std::string& name)
             std::cout << "Activating " << m->Name() << std::endl;
             m->Activate();
         }
+        else if (CMode* cm = ExcelsiorFindMode(&_self->cmodes, mode.c_str())) {
+            std::cout << "Activating " << cm->nameStr << std::endl;
+            ExcelsiorActivateMode(cm);
+        }
         else {
             std::cerr << "Could not find Minor mode: " << mode << std::endl;
         }
@@ -294,56 +521,254 @@ void ModeManager::_deactivate_major_mode(const std::string& name)
 }
 
 void ModeManager::RunModeUIs(const ViewInteraction& vi) {
-    for (auto i : _minor_modes)
+    for (auto& i : _minor_modes)
         if (i.second->IsActive())
             i.second->RunUI(vi);
 }
 
 void ModeManager::RunViewportHovering(const ViewInteraction& vi) {
-    std::shared_ptr<MinorMode> dragger;
+    MinorMode* dragger = nullptr;
     int highest_bidder = -1;
 
-    for (auto i : _minor_modes)
+    for (auto& i : _minor_modes)
         if (i.second->IsActive()) {
             int bid = i.second->ViewportHoverBid(vi);
             if (bid > highest_bidder) {
-                dragger = i.second;
+                dragger = i.second.get();
                 highest_bidder = bid;
             }
         }
 
-    if (dragger)
+    const CModeManager::Bid* cdragger = nullptr;
+    CViewInteraction cvi;
+    if (!_self->cmodes.modes.empty()) {
+        _self->cmodes.Rebuild();
+        cvi = vi.C();
+        cdragger = CModeManager::Bidder(_self->cmodes.hover, cvi, highest_bidder);
+    }
+
+    if (cdragger)
+        cdragger->fn(cdragger->mode, &cvi);
+    else if (dragger)
         dragger->ViewportHovering(vi);
+
+    if (vi.probe && _self->probe)
+        _self->probe(vi.probe, ProbeStage::Dispatch);
 }
 
 void ModeManager::RunViewportDragging(const ViewInteraction& vi) {
-    std::shared_ptr<MinorMode> dragger;
+    MinorMode* dragger = nullptr;
     int highest_bidder = -1;
 
-    for (auto i : _minor_modes)
+    for (auto& i : _minor_modes)
         if (i.second->IsActive()) {
             int bid = i.second->ViewportDragBid(vi);
             if (bid > highest_bidder) {
-                dragger = i.second;
+                dragger = i.second.get();
                 highest_bidder = bid;
             }
         }
 
-    if (dragger)
+    const CModeManager::Bid* cdragger = nullptr;
+    CViewInteraction cvi;
+    if (!_self->cmodes.modes.empty()) {
+        _self->cmodes.Rebuild();
+        cvi = vi.C();
+        cdragger = CModeManager::Bidder(_self->cmodes.drag, cvi, highest_bidder);
+    }
+
+    if (cdragger)
+        cdragger->fn(cdragger->mode, &cvi);
+    else if (dragger)
         dragger->ViewportDragging(vi);
+
+    if (vi.probe && _self->probe)
+        _self->probe(vi.probe, ProbeStage::Dispatch);
 }
 
 void ModeManager::RunModeRendering(const ViewInteraction& vi) {
-    for (auto i : _minor_modes)
+    for (auto& i : _minor_modes)
         if (i.second->IsActive())
             i.second->Render(vi);
+
+    if (!_self->cmodes.modes.empty())
+        _self->cmodes.Render(vi.C());
+
+    if (vi.probe && _self->probe)
+        _self->probe(vi.probe, ProbeStage::Render);
 }
 
 void ModeManager::RunMainMenu() {
-    for (auto i : _minor_modes)
+    for (auto& i : _minor_modes)
         if (i.second->IsActive()) {
             i.second->Menu();
         }
 }
 
 } // lab
+
+
+/*
+ C mode ABI
+ */
+
+extern "C" {
+
+CMode* ExcelsiorCreateMode(const char* name) {
+    CMode* m = (CMode*)calloc(1, sizeof(CMode));
+    if (!m)
+        return nullptr;
+
+    size_t len = strlen(name);
+    m->nameStr = (char*)malloc(len + 1);
+    if (!m->nameStr) {
+        free(m);
+        return nullptr;
+    }
+    memcpy(m->nameStr, name, len + 1);
+    return m;
+}
+
+void ExcelsiorFreeNode(CMode* m) {
+    if (!m)
+        return;
+    if (m->cmm)
+        ExcelsiorUnregisterMode(m->cmm, m);
+    free(m->nameStr);
+    free(m);
+}
+
+CModeManager* ExcelsiorCreateModeManager(void) {
+    auto mm = new lab::ModeManager();
+    mm->CModes()->ownsManager = true;
+    return mm->CModes();
+}
+
+void ExcelsiorFreeModeManager(CModeManager* cmm) {
+    if (cmm && cmm->ownsManager)
+        delete cmm->mm;
+}
+
+CModeManager* ExcelsiorCanonicalModeManager(void) {
+    lab::ModeManager* mm = lab::ModeManager::Canonical();
+    return mm ? mm->CModes() : nullptr;
+}
+
+void ExcelsiorRegisterMode(CModeManager* cmm, CMode* m) {
+    if (m->cmm == cmm)
+        return;
+    if (m->cmm)
+        ExcelsiorUnregisterMode(m->cmm, m);
+
+    m->cmm = cmm;
+    cmm->modes.push_back(m);
+    cmm->dirty = true;
+}
+
+void ExcelsiorUnregisterMode(CModeManager* cmm, CMode* m) {
+    for (auto i = cmm->modes.begin(); i != cmm->modes.end(); ++i)
+        if (*i == m) {
+            cmm->modes.erase(i);
+            cmm->dirty = true;
+            m->cmm = nullptr;
+            return;
+        }
+}
+
+CMode* ExcelsiorFindMode(CModeManager* cmm, const char* name) {
+    for (CMode* m : cmm->modes)
+        if (strcmp(m->nameStr, name) == 0)
+            return m;
+    return nullptr;
+}
+
+void ExcelsiorActivateMode(CMode* m) {
+    if (m->active)
+        return;
+    m->active = 1;
+    if (m->activate)
+        m->activate(m, m->cmm);
+    if (m->cmm)
+        m->cmm->dirty = true;
+}
+
+void ExcelsiorDeactivateMode(CMode* m) {
+    if (!m->active)
+        return;
+    m->active = 0;
+    if (m->deactivate)
+        m->deactivate(m, m->cmm);
+    if (m->cmm)
+        m->cmm->dirty = true;
+}
+
+void ExcelsiorModeChanged(CMode* m) {
+    if (m->cmm)
+        m->cmm->dirty = true;
+}
+
+void ExcelsiorSetWakeCallback(CModeManager* cmm, void (*wake)(void)) {
+    if (wake)
+        cmm->mm->SetWakeCallback(wake);
+    else
+        cmm->mm->SetWakeCallback(nullptr);
+}
+
+void ExcelsiorRequestRedraw(CModeManager* cmm) {
+    cmm->mm->RequestRedraw();
+}
+
+int ExcelsiorNeedsRedraw(CModeManager* cmm) {
+    return cmm->mm->NeedsRedraw();
+}
+
+void ExcelsiorUpdateTransactionQueueAndModes(CModeManager* cmm) {
+    cmm->mm->UpdateTransactionQueueAndModes();
+}
+
+void ExcelsiorEnqueueTransaction(CModeManager* cmm, const char* message, void (*exec)(void* user), void* user) {
+    cmm->mm->EnqueueTransaction(lab::Transaction(message ? message : "", [exec, user]() { exec(user); }));
+}
+
+void ExcelsiorSetTransactionCallback(CModeManager* cmm, void (*executed)(void* user, const char* message), void* user) {
+    if (executed)
+        cmm->mm->SetTransactionCallback([executed, user](const lab::Transaction& t) { executed(user, t.message.c_str()); });
+    else
+        cmm->mm->SetTransactionCallback(nullptr);
+}
+
+void ExcelsiorSetProbeCallback(CModeManager* cmm, void (*probe)(void* user, unsigned int probe, int stage), void* user) {
+    if (probe)
+        cmm->mm->SetProbeCallback([probe, user](unsigned int p, lab::ModeManager::ProbeStage stage) {
+            probe(user, p, stage == lab::ModeManager::ProbeStage::Dispatch ? EXCELSIOR_PROBE_DISPATCH : EXCELSIOR_PROBE_RENDER);
+        });
+    else
+        cmm->mm->SetProbeCallback(nullptr);
+}
+
+int ExcelsiorLoadPlugins(CModeManager* cmm, const char* directory) {
+    return cmm->mm->LoadPlugins(directory);
+}
+
+void* ExcelsiorFrameAlloc(CModeManager* cmm, size_t size, size_t align) {
+    return cmm->mm->FrameMemory()->allocate(size ? size : 1, align ? align : alignof(std::max_align_t));
+}
+
+void ExcelsiorParallelFor(CModeManager* cmm, size_t count, size_t grain,
+                          void (*fn)(void* user, size_t begin, size_t end), void* user) {
+    cmm->mm->Jobs().ParallelFor(0, count, grain, [fn, user](size_t begin, size_t end) { fn(user, begin, end); });
+}
+
+void ExcelsiorRunViewportHovering(CModeManager* cmm, const CViewInteraction* vi) {
+    cmm->mm->RunViewportHovering(lab::ViewInteraction(*vi));
+}
+
+void ExcelsiorRunViewportDragging(CModeManager* cmm, const CViewInteraction* vi) {
+    cmm->mm->RunViewportDragging(lab::ViewInteraction(*vi));
+}
+
+void ExcelsiorRunModeRendering(CModeManager* cmm, const CViewInteraction* vi) {
+    cmm->mm->RunModeRendering(lab::ViewInteraction(*vi));
+}
+
+} // extern "C"
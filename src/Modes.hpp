@@ -27,7 +27,10 @@
 #ifdef __cplusplus
 #include <functional>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <vector>
 
 #ifndef HAVE_NO_USD
 #include <pxr/usd/usd/prim.h>
@@ -36,38 +39,179 @@
 extern "C" {
 #endif
 
+/*
+ The C mode ABI lets modes be written in C, e.g. by plugins. A CMode is a
+ minor mode made of function pointers; any callback left NULL is skipped.
+ The mode manager keeps the active C modes in contiguous arrays, one per
+ phase, and runs each phase for all of them in one batched call, alongside
+ the C++ minor modes. C modes bid for hovering and dragging against the C++
+ ones, and a major mode's configuration can name them.
+
+     CModeManager* cmm = ExcelsiorCreateModeManager();
+     CMode* mode = ExcelsiorCreateMode("Cursor");
+     mode->render = cursorRender;
+     ExcelsiorRegisterMode(cmm, mode);
+     ExcelsiorActivateMode(mode);
+ */
+
 struct CModeManager;
+struct LabStreamBuffer; // StreamBuffer.h
+
+typedef struct CViewSample {
+    float x, y;     // same space as CViewInteraction::x, y
+    double t;       // seconds, only meaningful relative to other samples
+} CViewSample;
+
+// lab::ViewInteraction for C, see there
+typedef struct CViewInteraction {
+    float w, h;             // view full width and height
+    float wx, wy, ww, wh;   // window within the view
+    float x, y, dt;
+    int start, end;         // start and end of a drag
+    const CViewSample* samples;
+    size_t sampleCount;
+    unsigned int probe;
+    struct LabStreamBuffer* stream;
+} CViewInteraction;
 
 typedef struct CMode
 {
-    bool active = false;
-    CModeManager* cmm = NULL;   // CMode does not own the mode manager; the mode manager must outlive all nodes
-    char* nameStr = NULL;       // name string is internally owned.
-
-    // Mode callbacks will be filled in by ExcelsiorCreateMode.
-    void (*activate)(CMode*, CModeManager*) = NULL;
-    void (*deactivate)(CMode*, CModeManager*) = NULL;
-    void (*update)(CMode*, CModeManager*) = NULL;
+    int active;
+    struct CModeManager* cmm;   // CMode does not own the mode manager; the mode manager must outlive all nodes
+    char* nameStr;              // name string is internally owned.
+    void* user;                 // the mode's own state
+
+    // ExcelsiorCreateMode leaves every callback NULL, fill in the ones the mode needs
+    void (*activate)(struct CMode*, struct CModeManager*);
+    void (*deactivate)(struct CMode*, struct CModeManager*);
+    void (*update)(struct CMode*, struct CModeManager*);
+
+    void (*render)(struct CMode*, const CViewInteraction*);
+    int  (*hoverBid)(struct CMode*, const CViewInteraction*);  // -1 to not bid, as MinorMode::ViewportHoverBid
+    void (*hovering)(struct CMode*, const CViewInteraction*);
+    int  (*dragBid)(struct CMode*, const CViewInteraction*);
+    void (*dragging)(struct CMode*, const CViewInteraction*);
 } CMode;
 
 CMode* ExcelsiorCreateMode(const char* name);
-void   ExcelsiorFreeNode(CMode*);
+void   ExcelsiorFreeNode(CMode*);  // unregisters the mode first if needed
+
+// a new lab::ModeManager, which becomes the canonical one, and its C side
+struct CModeManager* ExcelsiorCreateModeManager(void);
+void                 ExcelsiorFreeModeManager(struct CModeManager*);
+
+// the C side of the canonical lab::ModeManager, NULL if there isn't one
+struct CModeManager* ExcelsiorCanonicalModeManager(void);
+
+// the manager does not own the mode, it must stay registered only while it lives
+void ExcelsiorRegisterMode(struct CModeManager*, CMode*);
+void ExcelsiorUnregisterMode(struct CModeManager*, CMode*);
+CMode* ExcelsiorFindMode(struct CModeManager*, const char* name);
+
+void ExcelsiorActivateMode(CMode*);
+void ExcelsiorDeactivateMode(CMode*);
+
+// call after changing the callbacks of a registered mode
+void ExcelsiorModeChanged(CMode*);
+
+// lab::ModeManager's loop functions, for applications written in C
+void ExcelsiorSetWakeCallback(struct CModeManager*, void (*wake)(void));
+void ExcelsiorRequestRedraw(struct CModeManager*);
+int  ExcelsiorNeedsRedraw(struct CModeManager*);
+void ExcelsiorUpdateTransactionQueueAndModes(struct CModeManager*);
+void ExcelsiorRunViewportHovering(struct CModeManager*, const CViewInteraction*);
+void ExcelsiorRunViewportDragging(struct CModeManager*, const CViewInteraction*);
+void ExcelsiorRunModeRendering(struct CModeManager*, const CViewInteraction*);
+
+// queues exec(user) as a transaction, run and journaled by the next
+// ExcelsiorUpdateTransactionQueueAndModes. It can't be undone
+void ExcelsiorEnqueueTransaction(struct CModeManager*, const char* message, void (*exec)(void* user), void* user);
+
+// executed(user, message) after each transaction runs, e.g. LabRecorderTransaction
+void ExcelsiorSetTransactionCallback(struct CModeManager*, void (*executed)(void* user, const char* message), void* user);
+
+// lab::ModeManager::SetProbeCallback, stage is one of these
+enum { EXCELSIOR_PROBE_DISPATCH, EXCELSIOR_PROBE_RENDER };
+void ExcelsiorSetProbeCallback(struct CModeManager*, void (*probe)(void* user, unsigned int probe, int stage), void* user);
+
+/*
+ A mode plugin is a shared library exporting ExcelsiorPluginEntry. The
+ manager loads every plugin in a directory and watches it; when a library is
+ rebuilt it is loaded again on a background thread, and swapped in between
+ frames. The CMode keeps its active state, its user pointer, and its place
+ in the manager, only the callbacks change.
+
+ Old builds stay loaded, so transactions in the journal that point into
+ their code remain valid.
+ */
+
+#define EXCELSIOR_PLUGIN_VERSION 1
+
+typedef struct ExcelsiorPlugin {
+    int version;                // EXCELSIOR_PLUGIN_VERSION
+    const char* name;           // of the mode, unique among the manager's modes
+    int activate;               // activate the mode when it is first loaded
+
+    // fills in the callbacks. reloading is 0 for a new mode, 1 when replacing an
+    // earlier build, in which case mode->user is what that build left there
+    void (*bind)(CMode*, int reloading);
+
+    // before a newer build is bound (reloading 1), or when the manager goes away (0)
+    void (*unbind)(CMode*, int reloading);
+} ExcelsiorPlugin;
+
+typedef const ExcelsiorPlugin* (*ExcelsiorPluginEntryFunc)(void);
+
+// loads the plugins in directory and reloads them as they change, 0 if
+// plugins aren't supported on this platform or the directory can't be watched
+int ExcelsiorLoadPlugins(struct CModeManager*, const char* directory);
+
+// size bytes from the calling thread's frame memory, released by the next
+// ExcelsiorUpdateTransactionQueueAndModes; align 0 is the malloc alignment
+void* ExcelsiorFrameAlloc(struct CModeManager*, size_t size, size_t align);
+
+// fn(user, begin, end) over [0, count) on the manager's job system (see
+// Jobs.hpp), in chunks of at most grain. Returns when every chunk is done
+void ExcelsiorParallelFor(struct CModeManager*, size_t count, size_t grain,
+                          void (*fn)(void* user, size_t begin, size_t end), void* user);
 
 #ifdef __cplusplus
 } // extern "C"
 
 namespace lab {
 class ModeManager;
+class JobSystem;
+class JobCounter;
 
 struct ViewDimensions {
     float w, h;             // view full width and height
     float wx, wy, ww, wh;   // window within the view
 };
 
+typedef CViewSample ViewSample;
+
 struct ViewInteraction {
     ViewDimensions view;
     float x = 0, y = 0, dt = 0;
     bool start = false, end = false;  // start and end of a drag
+
+    // every pointer position since the previous interaction, oldest first;
+    // x, y is the last one. Precise manipulators should integrate these
+    // instead of x, y alone. Only valid for the duration of the call.
+    const ViewSample* samples = nullptr;
+    size_t sampleCount = 0;
+
+    // latency probe carried from the input that produced this interaction,
+    // 0 if there isn't one (see Latency.h)
+    unsigned int probe = 0;
+
+    // per-frame geometry for Render, a bump allocator over a persistently
+    // mapped buffer (see StreamBuffer.h). nullptr if the application has none
+    LabStreamBuffer* stream = nullptr;
+
+    ViewInteraction() = default;
+    explicit ViewInteraction(const CViewInteraction&);
+    CViewInteraction C() const;
 };
 
 struct Transaction {
@@ -117,7 +261,7 @@ struct JournalNode {
     // if it differs, there's a bug in the journal.
     static int count;
 
-    // recursively delete all the nodes after this one
+    // delete all the nodes after this one
     // making this node the end of the journal
     static void Truncate(JournalNode* node);
     
@@ -171,6 +315,11 @@ public:
 
     virtual void Update() {}
 
+    // a mode that is mid-animation returns true so that the application
+    // keeps rendering continuously; otherwise frames are only drawn when
+    // input arrives or a redraw is requested.
+    virtual bool IsAnimating() const { return false; }
+
     virtual void Activate()   final { _active = true;  _activate();   }
     virtual void Deactivate() final { _active = false; _deactivate(); }
 
@@ -224,7 +373,7 @@ class ModeManager
     struct data;
     data* _self;
     
-    Journal _journal;
+    lab::Journal _journal;
 
     std::map< std::string, std::shared_ptr<MinorMode> > _minor_modes;
     std::map< std::string, std::shared_ptr<MajorMode> > _major_modes;
@@ -247,7 +396,7 @@ public:
     
     static ModeManager* Canonical();
 
-    const std::map< std::string, std::shared_ptr<MinorMode> > MinorModes() const {
+    const std::map< std::string, std::shared_ptr<MinorMode> >& MinorModes() const {
         return _minor_modes;
     }
     const std::vector<std::string>& MinorModeNames() const {
@@ -310,7 +459,47 @@ public:
     void EnqueueTransaction(Transaction&&);
     void UpdateTransactionQueueAndModes();
 
-    Journal& Journal() { return _journal; }
+    // RequestRedraw may be called from any thread. It marks the next frame
+    // as needed, and calls the wake callback so that a render loop blocked
+    // waiting for input can come around. EnqueueTransaction also wakes the
+    // loop, since the transaction must be run by UpdateTransactionQueueAndModes.
+    void RequestRedraw();
+
+    // true if a redraw was requested since the last call, or if an active
+    // mode is animating. Clears the pending request.
+    bool NeedsRedraw();
+
+    // the wake callback is typically RGFW_stopCheckEvents
+    void SetWakeCallback(std::function<void()> wake);
+
+    // called when an interaction carrying a latency probe has been
+    // dispatched to the hovering or dragging mode, and once the modes have rendered it
+    enum class ProbeStage { Dispatch, Render };
+    void SetProbeCallback(std::function<void(unsigned int probe, ProbeStage)> probe);
+
+    // called by UpdateTransactionQueueAndModes after each transaction runs,
+    // before it goes into the journal, so a session can be recorded (Record.h)
+    void SetTransactionCallback(std::function<void(const Transaction&)> executed);
+
+    // the C modes' side of this manager, see CMode
+    CModeManager* CModes() const;
+
+    // loads mode plugins from directory and hot-reloads them, see ExcelsiorPlugin
+    bool LoadPlugins(const std::string& directory);
+
+    // the job system the modes and the frame loop share, made on first use,
+    // which must be on the frame loop's thread (it becomes worker 0)
+    JobSystem& Jobs();
+
+    // jobs spawned against this only have to finish by the next frame,
+    // UpdateTransactionQueueAndModes waits for them before anything else
+    JobCounter& FrameJobs();
+
+    // the calling thread's allocator for data that only lives until the next
+    // frame, for std::pmr containers. See FrameMemory.hpp
+    std::pmr::memory_resource* FrameMemory();
+
+    lab::Journal& Journal() { return _journal; }
 };
 
 } // lab
@@ -0,0 +1,283 @@
+//
+//  Plugins.cpp
+//  LabExcelsior
+//
+//  Hot-reloadable mode plugins, see Plugins.hpp
+//
+
+#include "Plugins.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#define LAB_PLUGINS_INOTIFY
+#include <dirent.h>
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace lab
+{
+
+struct PluginHost::data {
+    // a build loaded by the loader thread, waiting for Apply
+    struct Loaded {
+        std::string file;
+        void* handle;
+        const ExcelsiorPlugin* entry;
+    };
+
+    struct Plugin {
+        CMode* mode = nullptr;
+        const ExcelsiorPlugin* entry = nullptr;
+    };
+
+    CModeManager* cmm;
+    std::function<void()> wake;
+    std::string directory;
+
+    std::mutex lock;
+    std::vector<Loaded> ready;              // guarded by lock
+
+    std::map<std::string, Plugin> plugins;  // by file name, main thread only
+
+    std::thread thread;
+    int inotify = -1;
+    int stop[2] = { -1, -1 };               // written to when the host goes away
+    unsigned int copies = 0;
+
+    void Load(const std::string& file);
+    void Run();
+};
+
+namespace {
+    bool IsPlugin(const std::string& file) {
+        return file.size() > 3 && file.compare(file.size() - 3, 3, ".so") == 0;
+    }
+}
+
+#ifdef LAB_PLUGINS_INOTIFY
+
+// loader thread. The library is loaded from a copy, dlopen would otherwise
+// hand back the handle of the build already loaded from the same path
+void PluginHost::data::Load(const std::string& file) {
+    std::string path = directory + "/" + file;
+
+    const char* tmp = getenv("TMPDIR");
+    std::string copy = std::string(tmp ? tmp : "/tmp") + "/excelsior-" + std::to_string(getpid()) +
+                       "-" + std::to_string(copies++) + "-" + file;
+
+    FILE* src = fopen(path.c_str(), "rb");
+    if (!src)
+        return;
+    FILE* dst = fopen(copy.c_str(), "wb");
+    if (!dst) {
+        fclose(src);
+        std::cerr << "Could not copy plugin " << path << " to " << copy << std::endl;
+        return;
+    }
+
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), src)) > 0)
+        fwrite(buffer, 1, n, dst);
+    fclose(src);
+    fclose(dst);
+
+    void* handle = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+    unlink(copy.c_str()); // the mapping outlives the name
+    if (!handle) {
+        std::cerr << "Could not load plugin " << path << ": " << dlerror() << std::endl;
+        return;
+    }
+
+    auto entryFunc = (ExcelsiorPluginEntryFunc)dlsym(handle, "ExcelsiorPluginEntry");
+    const ExcelsiorPlugin* entry = entryFunc ? entryFunc() : nullptr;
+    if (!entry || entry->version != EXCELSIOR_PLUGIN_VERSION || !entry->name || !entry->bind) {
+        std::cerr << "Not a mode plugin, or built for another version: " << path << std::endl;
+        dlclose(handle);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ready.push_back({ file, handle, entry });
+    }
+    if (wake)
+        wake();
+}
+
+void PluginHost::data::Run() {
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (struct dirent* e = readdir(dir))
+            if (IsPlugin(e->d_name))
+                Load(e->d_name);
+        closedir(dir);
+    }
+
+    struct pollfd fds[2] = { { inotify, POLLIN, 0 }, { stop[0], POLLIN, 0 } };
+    std::set<std::string> changed;
+
+    for (;;) {
+        // a linker can write a library in several goes, so changes are
+        // collected until the directory has been quiet for a moment
+        int timeout = changed.empty() ? -1 : 100;
+        int count = poll(fds, 2, timeout);
+        if (count < 0)
+            continue;
+
+        if (fds[1].revents)
+            return;
+
+        if (count == 0) {
+            for (auto& file : changed)
+                Load(file);
+            changed.clear();
+            continue;
+        }
+
+        alignas(struct inotify_event) char events[4096];
+        ssize_t len = read(inotify, events, sizeof(events));
+        for (ssize_t i = 0; i < len; ) {
+            auto event = (const struct inotify_event*)(events + i);
+            if (event->len && IsPlugin(event->name))
+                changed.insert(event->name);
+            i += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+bool PluginHost::Watch(const std::string& directory) {
+    if (_self->thread.joinable())
+        return false;
+
+    _self->inotify = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (_self->inotify < 0)
+        return false;
+
+    if (inotify_add_watch(_self->inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        pipe(_self->stop) != 0) {
+        std::cerr << "Could not watch plugin directory " << directory << std::endl;
+        close(_self->inotify);
+        _self->inotify = -1;
+        return false;
+    }
+
+    _self->directory = directory;
+    _self->thread = std::thread([this]() { _self->Run(); });
+    return true;
+}
+
+#else
+
+void PluginHost::data::Load(const std::string&) {}
+void PluginHost::data::Run() {}
+
+bool PluginHost::Watch(const std::string&) {
+    std::cerr << "Mode plugins are only supported on Linux for now" << std::endl;
+    return false;
+}
+
+#endif
+
+PluginHost::PluginHost(CModeManager* cmm, std::function<void()> wake)
+: _self(new data())
+{
+    _self->cmm = cmm;
+    _self->wake = wake;
+}
+
+PluginHost::~PluginHost() {
+#ifdef LAB_PLUGINS_INOTIFY
+    if (_self->thread.joinable()) {
+        char quit = 0;
+        if (write(_self->stop[1], &quit, 1) == 1)
+            _self->thread.join();
+        else
+            _self->thread.detach();
+    }
+    if (_self->inotify >= 0)
+        close(_self->inotify);
+    if (_self->stop[0] >= 0) {
+        close(_self->stop[0]);
+        close(_self->stop[1]);
+    }
+#endif
+
+    // the libraries themselves stay loaded, see ExcelsiorPlugin
+    for (auto& i : _self->plugins) {
+        if (i.second.entry->unbind)
+            i.second.entry->unbind(i.second.mode, 0);
+        ExcelsiorFreeNode(i.second.mode);
+    }
+}
+
+void PluginHost::Apply() {
+    std::vector<data::Loaded> ready;
+    {
+        std::lock_guard<std::mutex> guard(_self->lock);
+        if (_self->ready.empty())
+            return;
+        ready.swap(_self->ready);
+    }
+
+    for (auto& l : ready) {
+        auto& plugin = _self->plugins[l.file];
+
+        if (!plugin.mode) {
+            if (ExcelsiorFindMode(_self->cmm, l.entry->name)) {
+                std::cerr << "Plugin " << l.file << ": there is already a mode named " << l.entry->name << std::endl;
+                _self->plugins.erase(l.file);
+                continue;
+            }
+
+            plugin.mode = ExcelsiorCreateMode(l.entry->name);
+            plugin.entry = l.entry;
+            l.entry->bind(plugin.mode, 0);
+            ExcelsiorRegisterMode(_self->cmm, plugin.mode);
+            if (l.entry->activate)
+                ExcelsiorActivateMode(plugin.mode);
+
+            std::cout << "Loaded plugin " << plugin.mode->nameStr << std::endl;
+            continue;
+        }
+
+        if (strcmp(l.entry->name, plugin.mode->nameStr) != 0)
+            std::cerr << "Plugin " << l.file << " was renamed to " << l.entry->name
+                      << ", it keeps the name " << plugin.mode->nameStr << " until restarted" << std::endl;
+
+        // active, cmm, nameStr and user carry over, only the code changes
+        CMode* m = plugin.mode;
+        if (plugin.entry->unbind)
+            plugin.entry->unbind(m, 1);
+
+        m->activate = nullptr;
+        m->deactivate = nullptr;
+        m->update = nullptr;
+        m->render = nullptr;
+        m->hoverBid = nullptr;
+        m->hovering = nullptr;
+        m->dragBid = nullptr;
+        m->dragging = nullptr;
+
+        plugin.entry = l.entry;
+        l.entry->bind(m, 1);
+        ExcelsiorModeChanged(m);
+
+        std::cout << "Reloaded plugin " << m->nameStr << std::endl;
+    }
+
+    ExcelsiorRequestRedraw(_self->cmm);
+}
+
+} // lab
@@ -0,0 +1,47 @@
+//
+//  Plugins.hpp
+//  LabExcelsior
+//
+//  Hot-reloadable mode plugins, see ExcelsiorPlugin in Modes.hpp
+//
+
+
+/*
+ PluginHost is owned by ModeManager. A background thread loads the shared
+ libraries in the plugin directory and then waits on inotify; each time a
+ library is rewritten it is copied to a private path (so dlopen gives a
+ fresh handle), loaded and checked there. The main thread only swaps the
+ callbacks over, in Apply, which ModeManager calls between frames.
+ */
+
+#ifndef Plugins_h
+#define Plugins_h
+
+#include "Modes.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace lab {
+
+class PluginHost
+{
+    struct data;
+    std::unique_ptr<data> _self;
+
+public:
+    // wake is called from the loader thread when a plugin is ready to swap in
+    PluginHost(CModeManager* cmm, std::function<void()> wake);
+    ~PluginHost();
+
+    // starts loading and watching directory, false if it can't be watched
+    bool Watch(const std::string& directory);
+
+    // binds every plugin loaded since the last call, main thread only
+    void Apply();
+};
+
+} // lab
+
+#endif /* Plugins_h */
@@ -0,0 +1,326 @@
+//
+//  Present.c
+//  LabExcelsior
+//
+//  Refresh-rate-aware frame pacing, see Present.h
+//
+
+#include "Present.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(__unix__) && !defined(__APPLE__)
+#define LAB_PRESENT_GLX
+#include <X11/Xlib.h>
+#endif
+
+#define LAB_PRESENT_HISTORY 128                 // frames the render budget is taken over, a second or two
+#define LAB_PRESENT_BINS 256                    // latency histogram, 0.25 ms per bin, the last is open ended
+#define LAB_PRESENT_BIN_NS 250000ull
+#define LAB_PRESENT_MARGIN_MIN 500000ull        // ns of slack every frame gets
+#define LAB_PRESENT_MARGIN_STEP 1000000ull      // added after a miss
+#define LAB_PRESENT_SPIN 1000000ull             // the last stretch of a wait spins, sleeps overshoot
+
+#ifdef LAB_PRESENT_GLX
+/* the GLX bits used here, so no glx.h is needed */
+typedef const char* (*LabQueryExtensionsStringFunc)(Display*, int);
+typedef void (*LabSwapIntervalEXTFunc)(Display*, XID, int);
+typedef Bool (*LabGetSyncValuesOMLFunc)(Display*, XID, int64_t*, int64_t*, int64_t*);
+typedef Bool (*LabGetMscRateOMLFunc)(Display*, XID, int32_t*, int32_t*);
+#endif
+
+struct LabPresent {
+    LabPresentMode mode;
+    int flags;
+
+    uint64_t period;            // ns per refresh
+    uint64_t anchor;            // a vblank, the others are anchor + k * period
+    uint64_t target;            // the vblank the current frame is aimed at
+    uint64_t start;             // when the current frame started, 0 if there isn't one
+    uint64_t lastTarget;
+
+    uint64_t durations[LAB_PRESENT_HISTORY];
+    unsigned int durationNext;
+    uint64_t margin;
+
+    unsigned int frames, missed;
+    uint64_t latencySum, latencyMax;
+    unsigned int latencies[LAB_PRESENT_BINS];
+
+#ifdef LAB_PRESENT_GLX
+    Display* display;
+    XID drawable;
+    LabGetSyncValuesOMLFunc getSyncValues;
+#endif
+};
+
+static uint64_t LabPresentNow(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// sleeps most of the way, the scheduler can only wake a thread to within a
+// fraction of a millisecond, then spins the rest
+static void LabPresentSleepUntil(uint64_t when) {
+    uint64_t now = LabPresentNow();
+
+    if (when > now + LAB_PRESENT_SPIN) {
+        uint64_t ns = when - now - LAB_PRESENT_SPIN;
+#ifdef _WIN32
+        Sleep((DWORD)(ns / 1000000ull));
+#else
+        struct timespec ts;
+        ts.tv_sec = (time_t)(ns / 1000000000ull);
+        ts.tv_nsec = (long)(ns % 1000000000ull);
+        nanosleep(&ts, NULL);
+#endif
+    }
+
+    while (LabPresentNow() < when) {
+#ifdef _WIN32
+        YieldProcessor();
+#endif
+    }
+}
+
+#ifdef LAB_PRESENT_GLX
+static int LabPresentHasExtension(const char* extensions, const char* name) {
+    size_t len = strlen(name);
+    const char* s = extensions;
+
+    while (s != NULL && (s = strstr(s, name)) != NULL) {
+        if ((s == extensions || s[-1] == ' ') && (s[len] == ' ' || s[len] == '\0'))
+            return 1;
+        s += len;
+    }
+
+    return 0;
+}
+
+// the time of the last vblank from the driver, 0 if it can't say.
+// UST is microseconds on the monotonic clock on Mesa and NVIDIA alike
+static uint64_t LabPresentLastVblank(LabPresent* p) {
+    int64_t ust = 0, msc = 0, sbc = 0;
+    if (p->getSyncValues == NULL || !p->getSyncValues(p->display, p->drawable, &ust, &msc, &sbc) || ust <= 0)
+        return 0;
+
+    uint64_t vblank = (uint64_t)ust * 1000ull, now = LabPresentNow();
+
+    // anything else is on some other clock
+    if (vblank > now || now - vblank > 1000000000ull)
+        return 0;
+    return vblank;
+}
+#endif
+
+LabPresent* LabPresentCreate(LabGLLoader load, void* display, unsigned long drawable, double hz, int flags) {
+    LabPresent* p = (LabPresent*)calloc(1, sizeof(LabPresent));
+    if (p == NULL)
+        return NULL;
+
+    p->mode = LAB_PRESENT_PACER;
+    p->flags = flags;
+    p->margin = LAB_PRESENT_MARGIN_MIN;
+    LabPresentSetRate(p, hz);
+
+#ifdef LAB_PRESENT_GLX
+    if (load == NULL || display == NULL || drawable == 0 || (flags & LAB_PRESENT_SOFTWARE))
+        return p;
+
+    p->display = (Display*)display;
+    p->drawable = (XID)drawable;
+
+    LabQueryExtensionsStringFunc queryExtensions = (LabQueryExtensionsStringFunc)load("glXQueryExtensionsString");
+    const char* extensions = queryExtensions ? queryExtensions(p->display, DefaultScreen(p->display)) : NULL;
+    if (extensions == NULL)
+        return p;
+
+    LabSwapIntervalEXTFunc swapInterval = NULL;
+    if (LabPresentHasExtension(extensions, "GLX_EXT_swap_control"))
+        swapInterval = (LabSwapIntervalEXTFunc)load("glXSwapIntervalEXT");
+
+    if (LabPresentHasExtension(extensions, "GLX_OML_sync_control")) {
+        p->getSyncValues = (LabGetSyncValuesOMLFunc)load("glXGetSyncValuesOML");
+
+        // the rate the display actually runs at, 59.94 rather than 60
+        LabGetMscRateOMLFunc getMscRate = (LabGetMscRateOMLFunc)load("glXGetMscRateOML");
+        int32_t numerator = 0, denominator = 0;
+        if (getMscRate != NULL && getMscRate(p->display, p->drawable, &numerator, &denominator) &&
+            numerator > 0 && denominator > 0)
+            LabPresentSetRate(p, (double)numerator / (double)denominator);
+
+        if (p->getSyncValues != NULL && LabPresentLastVblank(p) != 0) {
+            p->mode = LAB_PRESENT_OML;
+            if (swapInterval != NULL)
+                swapInterval(p->display, p->drawable, 1);
+        }
+        else
+            p->getSyncValues = NULL;
+    }
+
+    if (swapInterval != NULL && LabPresentHasExtension(extensions, "GLX_EXT_swap_control_tear")) {
+        p->mode = LAB_PRESENT_TEAR;
+        swapInterval(p->display, p->drawable, -1);
+    }
+#else
+    (void)load; (void)display; (void)drawable;
+#endif
+
+    return p;
+}
+
+void LabPresentDestroy(LabPresent* p) {
+    free(p);
+}
+
+LabPresentMode LabPresentGetMode(const LabPresent* p) {
+    return p->mode;
+}
+
+void LabPresentSetRate(LabPresent* p, double hz) {
+    if (hz <= 1.0)
+        hz = 60.0;
+    p->period = (uint64_t)(1e9 / hz);
+}
+
+// the longest of the recent frames, and the margin
+static uint64_t LabPresentBudget(const LabPresent* p) {
+    uint64_t longest = 0;
+    unsigned int i;
+    for (i = 0; i < LAB_PRESENT_HISTORY; i++)
+        if (p->durations[i] > longest)
+            longest = p->durations[i];
+    return longest + p->margin;
+}
+
+uint64_t LabPresentWait(LabPresent* p) {
+    uint64_t now = LabPresentNow();
+
+#ifdef LAB_PRESENT_GLX
+    uint64_t vblank = LabPresentLastVblank(p);
+    if (vblank != 0)
+        p->anchor = vblank;
+#endif
+    if (p->anchor == 0)
+        p->anchor = now;
+
+    // the first vblank after now, and after the one the last frame was aimed at
+    uint64_t target = p->anchor + ((now - p->anchor) / p->period + 1) * p->period;
+    if (target <= p->lastTarget)
+        target += ((p->lastTarget - target) / p->period + 1) * p->period;
+
+    uint64_t start;
+    if (p->flags & LAB_PRESENT_EARLY) {
+        // what plain vsync does, render straight after the previous vblank
+        start = target - p->period;
+    }
+    else {
+        // as late as possible, or the vblank after if it's too late for this one
+        uint64_t budget = LabPresentBudget(p);
+        if (budget > p->period)
+            budget = p->period;
+        while (target - budget < now)
+            target += p->period;
+        start = target - budget;
+    }
+
+    LabPresentSleepUntil(start);
+
+    p->target = target;
+    p->start = LabPresentNow();
+    return target;
+}
+
+void LabPresentDone(LabPresent* p) {
+    if (p->start == 0)
+        return;
+
+    uint64_t done = LabPresentNow();
+    uint64_t duration = done - p->start;
+    p->durations[p->durationNext] = duration;
+    p->durationNext = (p->durationNext + 1) % LAB_PRESENT_HISTORY;
+
+    // a frame shows at the vblank it was aimed at, or the first after it was
+    // done, except when tearing, which shows it straight away
+    uint64_t shown = p->target;
+    if (done > p->target) {
+        p->missed++;
+        p->margin += LAB_PRESENT_MARGIN_STEP;
+
+        if (p->mode == LAB_PRESENT_TEAR)
+            shown = done;
+        else
+            shown = p->target + ((done - p->target) / p->period + 1) * p->period;
+    }
+    else if (p->margin > LAB_PRESENT_MARGIN_MIN) {
+        p->margin -= (p->margin - LAB_PRESENT_MARGIN_MIN) / 64 + 1;
+    }
+
+    uint64_t latency = shown - p->start;
+    uint64_t bin = latency / LAB_PRESENT_BIN_NS;
+    p->latencies[bin < LAB_PRESENT_BINS ? bin : LAB_PRESENT_BINS - 1]++;
+    p->latencySum += latency;
+    if (latency > p->latencyMax)
+        p->latencyMax = latency;
+
+    p->frames++;
+    p->lastTarget = shown > p->target ? shown : p->target;
+    p->start = 0;
+}
+
+static double LabPresentPercentile(const LabPresent* p, double fraction) {
+    unsigned int wanted = (unsigned int)(fraction * p->frames), seen = 0, i;
+    for (i = 0; i < LAB_PRESENT_BINS; i++) {
+        seen += p->latencies[i];
+        if (seen > wanted)
+            break;
+    }
+    return (double)((i + 1) * LAB_PRESENT_BIN_NS) / 1e6; // the top of the bin
+}
+
+void LabPresentGetStats(const LabPresent* p, LabPresentStats* stats) {
+    memset(stats, 0, sizeof(LabPresentStats));
+    stats->frames = p->frames;
+    stats->missed = p->missed;
+    stats->hz = 1e9 / (double)p->period;
+    stats->budgetMs = (p->flags & LAB_PRESENT_EARLY) ? (double)p->period / 1e6 : (double)LabPresentBudget(p) / 1e6;
+
+    if (p->frames == 0)
+        return;
+
+    stats->latencyMeanMs = (double)p->latencySum / (double)p->frames / 1e6;
+    stats->latencyP50Ms = LabPresentPercentile(p, 0.5);
+    stats->latencyP99Ms = LabPresentPercentile(p, 0.99);
+    stats->latencyMaxMs = (double)p->latencyMax / 1e6;
+}
+
+void LabPresentPrint(const LabPresent* p, const char* label) {
+    static const char* modes[] = { "pacer", "tear", "oml" };
+
+    LabPresentStats s;
+    LabPresentGetStats(p, &s);
+
+    printf("%s : %u frames at %.2f hz (%s, %s start), %u missed (%.1f%%), latency mean %.2f p50 %.2f p99 %.2f max %.2f ms, budget %.2f ms\n",
+           label, s.frames, s.hz, modes[p->mode], (p->flags & LAB_PRESENT_EARLY) ? "early" : "late",
+           s.missed, s.frames ? 100.0 * s.missed / s.frames : 0.0,
+           s.latencyMeanMs, s.latencyP50Ms, s.latencyP99Ms, s.latencyMaxMs, s.budgetMs);
+}
@@ -0,0 +1,97 @@
+//
+//  Present.h
+//  LabExcelsior
+//
+//  Refresh-rate-aware frame pacing.
+//
+
+
+/*
+ LabPresent paces continuous rendering to the display. It predicts the next
+ vblank, and sleeps until the latest moment a frame can start and still be
+ submitted before it, so the input a frame uses is as fresh as it can be:
+
+     present = LabPresentCreate(loader, display, drawable, monitor.refreshRate, 0);
+
+     loop:
+         LabPresentWait(present);        sleep until it's time to start
+         poll input, update, render, swap
+         LabPresentDone(present);        the frame is submitted
+
+ How the vblanks are known depends on what the driver offers (GLX only for
+ now, anywhere else it's the software pacer):
+
+     LAB_PRESENT_OML     GLX_OML_sync_control gives the time of the last vblank
+                         and the exact refresh rate, swap interval 1
+     LAB_PRESENT_TEAR    GLX_EXT_swap_control_tear, swap interval -1: on time
+                         frames wait for vblank, late ones tear rather than
+                         stall for a whole refresh. Also uses OML when present
+     LAB_PRESENT_PACER   a software clock at the given rate, the swap interval
+                         isn't touched. This is also how a display-less run
+                         (llvmpipe, Xvfb) simulates a refresh rate
+
+ How long to leave for a frame is the longest of the recent frames, plus a
+ margin that grows after every missed vblank and slowly shrinks back. A frame
+ misses when LabPresentDone comes after the vblank it started for; if the
+ caller waits on the GPU before calling it (glFinish), GPU time counts too.
+ */
+
+#ifndef Present_h
+#define Present_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LabGLLoader_defined
+#define LabGLLoader_defined
+typedef void* (*LabGLLoader)(const char* name);
+#endif
+
+typedef enum LabPresentMode {
+    LAB_PRESENT_PACER,
+    LAB_PRESENT_TEAR,
+    LAB_PRESENT_OML,
+} LabPresentMode;
+
+enum {
+    LAB_PRESENT_SOFTWARE = 1 << 0,  // use the software pacer even if the driver could do better
+    LAB_PRESENT_EARLY    = 1 << 1,  // start right after the previous vblank instead of as late as possible, for comparison
+};
+
+typedef struct LabPresentStats {
+    unsigned int frames, missed;
+    double hz;
+    double budgetMs;                // what the next frame is given
+    double latencyMeanMs;           // from the start of a frame to the vblank that shows it
+    double latencyP50Ms, latencyP99Ms, latencyMaxMs;
+} LabPresentStats;
+
+typedef struct LabPresent LabPresent;
+
+// display and drawable are the GLX Display* and window, NULL and 0 for the
+// software pacer alone. hz <= 0 is 60 unless the driver knows better
+LabPresent* LabPresentCreate(LabGLLoader load, void* display, unsigned long drawable, double hz, int flags);
+void        LabPresentDestroy(LabPresent*);
+
+LabPresentMode LabPresentGetMode(const LabPresent*);
+
+// for when the window moves to a monitor with another refresh rate
+void LabPresentSetRate(LabPresent*, double hz);
+
+// sleeps until the next frame should start, returns the vblank (ns, monotonic) it is aimed at
+uint64_t LabPresentWait(LabPresent*);
+
+// call once the frame is submitted
+void LabPresentDone(LabPresent*);
+
+void LabPresentGetStats(const LabPresent*, LabPresentStats*);
+void LabPresentPrint(const LabPresent*, const char* label);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* Present_h */
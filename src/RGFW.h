@@ -48,10 +48,15 @@
 	#define RGFW_WGL_LOAD (optional) (windows only) if WGL should be loaded dynamically during runtime
 	#define RGFW_NO_X11_CURSOR (optional) (unix only) don't use XCursor
 	#define RGFW_NO_X11_CURSOR_PRELOAD (optional) (unix only) Use XCursor, but don't link it in code, (you'll have to link it with -lXcursor)
+	#define RGFW_NO_X11_SHM (optional) (unix only) present RGFW_BUFFER / RGFW_OSMESA frames with XPutImage instead of MIT-SHM
+	#define RGFW_NO_X11_SHM_PRELOAD (optional) (unix only) Use MIT-SHM, but don't link it in code, (you'll have to link it with -lXext)
+	#define RGFW_X11_DONT_CONVERT_BGR (optional) (unix only) present the RGFW_BUFFER as is, render in BGRA yourself and RGFW skips the RGBA -> BGRA conversion
+	#define RGFW_NO_SIMD (optional) only use the scalar version of RGFW_swizzleBGRA
+	#define RGFW_SWIZZLE_IMPLEMENTATION (optional) build only RGFW_swizzleBGRA and its kernels, without a windowing backend (for benchmarks)
 
 	#define RGFW_NO_DPI - Do not include calculate DPI (no XRM nor libShcore included)
 
-	#define RGFW_ALLOC_DROPFILES (optional) if room should be allocating for drop files (by default it's global data)
+	#define RGFW_ALLOC_DROPFILES (deprecated) dropped files are always kept in a per-window heap arena now, this does nothing
 	#define RGFW_MALLOC x - choose what function to use to allocate, by default the standard malloc is used
 	#define RGFW_CALLOC x - choose what function to use to allocate (calloc), by default the standard calloc is used
 	#define RGFW_FREE x - choose what function to use to allocated memory, by default the standard free is used
@@ -293,6 +298,11 @@
 	#endif
 #endif
 
+#if defined(RGFW_X11) && (defined(RGFW_OSMESA) || defined(RGFW_BUFFER)) && !defined(RGFW_NO_X11_SHM)
+	#define RGFW_X11_SHM /* share the pixel buffer with the X server */
+	#include <X11/extensions/XShm.h>
+#endif
+
 #if defined(RGFW_OPENGL) && defined(RGFW_X11)
 	#ifndef GLX_MESA_swap_control
 		#define  GLX_MESA_swap_control
@@ -347,6 +357,8 @@ typedef RGFW_ENUM(u8, RGFW_event_types) {
 	RGFW_jsButtonPressed, /*!< a joystick button was pressed */
 	RGFW_jsButtonReleased, /*!< a joystick button was released */
 	RGFW_jsAxisMove, /*!< an axis of a joystick was moved*/
+	RGFW_jsConnected, /*!< a joystick was plugged in and registered (linux only) */
+	RGFW_jsDisconnected, /*!< a registered joystick was unplugged, its slot is free again (linux only) */
 	/*! joystick event note
 		RGFW_Event.joystick holds which joystick was altered, if any
 		RGFW_Event.button holds which joystick button was pressed
@@ -368,7 +380,8 @@ typedef RGFW_ENUM(u8, RGFW_event_types) {
 	*/
 	RGFW_quit, /*!< the user clicked the quit button*/ 
 	RGFW_dnd, /*!< a file has been dropped into the window*/
-	RGFW_dnd_init /*!< the start of a dnd event, when the place where the file drop is known */
+	RGFW_dnd_init, /*!< the start of a dnd event, when the place where the file drop is known */
+	RGFW_clipboardReady /*!< the window's RGFW_window_readClipboardAsync request finished (check its status) */
 	/* dnd data note
 		The x and y coords of the drop are stored in the vector RGFW_Event.point
 
@@ -376,6 +389,9 @@ typedef RGFW_ENUM(u8, RGFW_event_types) {
 
 		This is also the size of the array which stores all the dropped file string,
 		RGFW_Event.droppedFiles
+
+		the strings are owned by the window and stay valid until its next drop (or until it's closed),
+		there is no limit on how many files or how long the paths are
 	*/
 };
 
@@ -389,8 +405,14 @@ typedef RGFW_ENUM(u8, RGFW_event_types) {
 #ifndef RGFW_MAX_PATH
 #define RGFW_MAX_PATH 260 /* max length of a path (for dnd) */
 #endif
-#ifndef RGFW_MAX_DROPS
-#define RGFW_MAX_DROPS 260 /* max items you can drop at once */
+#ifndef RGFW_MAX_MOTION_SAMPLES
+#define RGFW_MAX_MOTION_SAMPLES 256 /* max mouse positions kept per RGFW_window_drainEvents call */
+#endif
+#ifndef RGFW_MAX_DAMAGE_RECTS
+#define RGFW_MAX_DAMAGE_RECTS 8 /* max damaged rects kept per frame, more are merged into the closest one */
+#endif
+#ifndef RGFW_MAX_KEY_CHANGES
+#define RGFW_MAX_KEY_CHANGES 32 /* max keys kept in a window's per-frame change list, the reset clears the whole table past that */
 #endif
 
 
@@ -424,6 +446,12 @@ typedef RGFW_ENUM(u8, RGFW_event_types) {
 	typedef struct { i32 x, y; } RGFW_point;
 #endif
 
+/*! one mouse position, sub-pixel when the window is in raw mouse mode (RGFW_window_setRawMouse) */
+typedef struct RGFW_pointerSample {
+	double x, y; /*!< window coordinates, or the raw device delta while the mouse is held */
+	u64 time; /*!< timestamp in milliseconds (the device's on X11), only meant for comparing samples */
+} RGFW_pointerSample;
+
 /*! basic rect type, if there's not already a rect type of choice */
 #ifndef RGFW_rect
 	typedef struct { i32 x, y, w, h; } RGFW_rect;
@@ -451,14 +479,21 @@ typedef RGFW_ENUM(u8, RGFW_event_types) {
 		RGFW_rect rect; /*!< monitor Workarea */
 		float scaleX, scaleY; /*!< monitor content scale*/
 		float physW, physH; /*!< monitor physical size */
+		float refreshRate; /*!< refresh rate in hz, 0 if unknown */
 	} RGFW_monitor;
 
 	/*
 		NOTE : Monitor functions should be ran only as many times as needed (not in a loop)
+		on X11 the topology is cached and refreshed from RandR change events instead,
+		so the monitor functions are cheap to call every frame there
+
+		the DPI of a monitor is its scale * 96
 	*/
 
-	/*! get an array of all the monitors (max 6) */
+	/*! get an array of all the monitors (max 6), on X11 it's the calling thread's copy, valid until its next call */
 	RGFWDEF RGFW_monitor* RGFW_getMonitors(void);
+	/*! the number of monitors in the array RGFW_getMonitors returns */
+	RGFWDEF u32 RGFW_getMonitorCount(void);
 	/*! get the primary monitor */
 	RGFWDEF RGFW_monitor RGFW_getPrimaryMonitor(void);
 #endif
@@ -469,12 +504,7 @@ typedef struct RGFW_Event {
 	char keyName[16]; /*!< key name of event*/
 
 	/*! drag and drop data */
-	/* 260 max paths with a max length of 260 */
-#ifdef RGFW_ALLOC_DROPFILES
-	char** droppedFiles;
-#else
-	char droppedFiles[RGFW_MAX_DROPS][RGFW_MAX_PATH]; /*!< dropped files*/
-#endif
+	char** droppedFiles; /*!< dropped files (points into the window's drop arena) */
 	u32 droppedFilesCount; /*!< house many files were dropped */
 
 	u32 type; /*!< which event has been sent?*/
@@ -494,7 +524,8 @@ typedef struct RGFW_Event {
 	u8 axisesCount; /*!< number of axises */
 	RGFW_point axis[2]; /*!< x, y of axises (-100 to 100) */
 
-	u64 frameTime, frameTime2; /*!< this is used for counting the fps */
+	u16 motionSample; /*!< first index into RGFW_window.motionSamples for a coalesced RGFW_mousePosChanged (RGFW_window_drainEvents only) */
+	u16 motionSampleCount; /*!< how many mouse positions were coalesced into this event */
 } RGFW_Event;
 
 /*! source data for the window (used by the APIs) */
@@ -525,6 +556,10 @@ typedef struct RGFW_window_src {
 #elif defined(RGFW_X11)
 	Display* display; /*!< source display */
 	Window window; /*!< source window */
+	struct RGFW_clipboardRequest* clipboard; /*!< pending RGFW_window_readClipboardAsync request */
+	b8 clipboardIncr; /*!< the clipboard owner is sending the data in INCR chunks */
+	u64 clipboardTime; /*!< when the clipboard owner last answered (ns), for RGFW_CLIPBOARD_TIMEOUT */
+	int wake[2]; /*!< pipe RGFW_window_stopCheckEvents writes to, so only the thread waiting on this window wakes up */
 	#if (defined(RGFW_OPENGL)) && !defined(RGFW_OSMESA) && !defined(RGFW_EGL)
 		GLXContext ctx; /*!< source graphics context */
 	#elif defined(RGFW_OSMESA)
@@ -538,6 +573,15 @@ typedef struct RGFW_window_src {
 #if defined(RGFW_OSMESA) || defined(RGFW_BUFFER) 
 		XImage* bitmap;
 		GC gc;
+	#ifdef RGFW_X11_SHM
+		XShmSegmentInfo shm[2]; /*!< segments backing the window buffer, one is drawn into while the server reads the other (shm[0].shmaddr is NULL if MIT-SHM isn't used) */
+		XImage* shmBitmap[2]; /*!< the images over them, bitmap is the one being drawn into */
+		u32 shmPending[2]; /*!< XShmPutImage requests the server hasn't sent an XShmCompletionEvent for */
+		u8 shmCurrent; /*!< the segment being drawn into */
+		u8 shmDrawn; /*!< bit per segment, it holds a frame (for RGFW_window_getBufferAge) */
+		b8 shmStale; /*!< swaps skipped the copy, so the segments hold different frames */
+		int shmCompletion; /*!< the XShmCompletionEvent type */
+	#endif
 #endif
 #elif defined(RGFW_WAYLAND)
 	struct wl_display* display;
@@ -551,6 +595,7 @@ typedef struct RGFW_window_src {
 	RGFW_Event events[20];
 		i32 eventLen;
 		size_t eventIndex;
+	int wake[2]; /*!< pipe RGFW_window_stopCheckEvents writes to, so only the thread waiting on this window wakes up */
 	#if defined(RGFW_EGL)
 			struct wl_egl_window* window;
 			EGLSurface EGL_surface;
@@ -597,7 +642,7 @@ typedef struct RGFW_window {
 	RGFW_window_src src; /*!< src window data */
 
 #if defined(RGFW_OSMESA) || defined(RGFW_BUFFER) 
-	u8* buffer; /*!< buffer for non-GPU systems (OSMesa, basic software rendering) */
+	u8* buffer; /*!< buffer for non-GPU systems (OSMesa, basic software rendering), with MIT-SHM it changes on every RGFW_window_swapBuffers */
 	/* when rendering using RGFW_BUFFER, the buffer is in the RGBA format */
 #endif
 	void* userPtr; /* ptr for usr data */
@@ -607,6 +652,35 @@ typedef struct RGFW_window {
 	RGFW_rect r; /*!< the x, y, w and h of the struct */
 	
 	RGFW_point _lastMousePoint; /*!< last cusor point (for raw mouse data) */
+
+	/*! every mouse position seen by the last RGFW_window_drainEvents call, in order */
+	RGFW_pointerSample motionSamples[RGFW_MAX_MOTION_SAMPLES];
+	u16 motionSampleCount;
+	RGFW_pointerSample _rawMotion; /*!< precise data of the mouse move in event (if _hasRawMotion is set) */
+	b8 _hasRawMotion;
+
+	RGFW_rect damage[RGFW_MAX_DAMAGE_RECTS]; /*!< areas changed since the last RGFW_window_swapBuffers (none means the whole window) */
+	u8 damageCount;
+	u8 _swapExts; /*!< the swap extensions of this window's context, RGFW_swapExtsChecked | ... (EGL, GLX) */
+	void* _swapWithDamage; /*!< eglSwapBuffersWithDamage, NULL if the driver doesn't have it */
+
+	/*! keyboard state, one bit per key code, (the previous state only holds keys that changed this frame) */
+	u8 _keys[32], _keysPrev[32];
+	u8 _keyChanged[32]; /*!< bitset of the keys in _keyChanges */
+	u8 _keyChanges[RGFW_MAX_KEY_CHANGES]; /*!< keys that changed this frame, in order */
+	u8 _keyChangeCount;
+	b8 _keyChangesFull; /*!< more keys changed than _keyChanges can hold */
+	b8 _queueEmptied; /*!< the last checkEvent found no events, the next one starts a new frame (X11) */
+	b8 _jsPolled; /*!< the joysticks and the hotplug watch were polled this frame (linux) */
+	u16 _mouse, _mousePrev, _mouseChanged; /*!< mouse button state, one bit per button */
+
+	/*! the last drop's paths, back to back and '\0' separated, with the table RGFW_Event.droppedFiles points to */
+	char* _dropArena;
+	size_t _dropArenaLen, _dropArenaCap;
+	char** _dropFiles;
+	u32 _dropFilesCap;
+
+	u64 _frameTime, _frameTime2; /*!< this is used for counting the fps */
 	
 	u32 _winArgs; /*!< windows args (for RGFW to check) */
 } RGFW_window; /*!< Window structure for managing the window */
@@ -674,10 +748,25 @@ RGFWDEF void RGFW_window_eventWait(RGFW_window* win, i32 waitMS);
 */
 RGFWDEF void RGFW_window_checkEvents(RGFW_window* win, i32 waitMS);
 
+/*!
+	drains every pending event into `events` (up to maxEvents) and returns how many were written
+
+	consecutive RGFW_mousePosChanged events are coalesced into one event holding the latest point,
+	the positions it replaced are kept in win->motionSamples[event.motionSample ... + event.motionSampleCount]
+	(when the mouse is held, the coalesced point is the sum of the raw deltas)
+	key, button and every other event is kept as is and in order
+
+	the motion samples are only valid until the next call
+*/
+RGFWDEF u32 RGFW_window_drainEvents(RGFW_window* win, RGFW_Event* events, u32 maxEvents);
+
 /*! 
 	Tell RGFW_window_eventWait to stop waiting, to be ran from another thread
+	(this wakes up RGFW_root, the first window that was made)
 */
 RGFWDEF void RGFW_stopCheckEvents(void);
+/*! wake up RGFW_window_eventWait on win, from any thread, win must stay open until it returns */
+RGFWDEF void RGFW_window_stopCheckEvents(RGFW_window* win);
 
 /*! window managment functions*/
 RGFWDEF void RGFW_window_close(RGFW_window* win); /*!< close the window and free leftover data */
@@ -745,6 +834,13 @@ RGFWDEF void RGFW_window_mouseHold(RGFW_window* win, RGFW_area area);
 /*! stop holding the mouse and let it move freely */
 RGFWDEF void RGFW_window_mouseUnhold(RGFW_window* win);
 
+/*
+	opt-in precise mouse input, the window's motion samples (RGFW_window_drainEvents) keep sub-pixel positions and device timestamps
+	on X11 mouse moves come from XInput2 (XI_Motion) instead of core MotionNotify events, 
+	other platforms keep using integer points and RGFW's clock
+*/
+RGFWDEF void RGFW_window_setRawMouse(RGFW_window* win, b8 raw);
+
 /*! hide the window */
 RGFWDEF void RGFW_window_hide(RGFW_window* win);
 /*! show the window */
@@ -809,7 +905,10 @@ RGFWDEF char RGFW_keyCodeToChar(u32 keycode, b8 shift);
 /*! get char from RGFW keycode (using a LUT), uses lockState for shouldShift) */
 RGFWDEF char RGFW_keyCodeToCharAuto(u32 keycode, u8 lockState);
 
-/*! if window == NULL, it checks if the key is pressed globally. Otherwise, it checks only if the key is pressed while the window in focus.*/
+/*! 
+	input state is kept per window, it's only touched by the thread that checks that window's events
+	if window == NULL, it checks the first window (RGFW_root) whether or not it's in focus. Otherwise, it checks only if the key is pressed while the window in focus.
+*/
 RGFWDEF b8 RGFW_isPressed(RGFW_window* win, u8 key); /*!< if key is pressed (key code)*/
 
 RGFWDEF b8 RGFW_wasPressed(RGFW_window* win, u8 key); /*!< if key was pressed (checks previous state only) (key code)*/
@@ -828,6 +927,14 @@ RGFWDEF b8 RGFW_isMouseHeld(RGFW_window* win, u8 button /*!< mouse button code *
 RGFWDEF b8 RGFW_isMouseReleased(RGFW_window* win, u8 button /*!< mouse button code */ );
 /*! if a mouse button was pressed (checks previous state only) */
 RGFWDEF b8 RGFW_wasMousePressed(RGFW_window* win, u8 button /*!< mouse button code */ );
+
+/*! 
+	the keys that were pressed or released since the window's event queue was last emptied, in order, each key is listed once
+	the list is cut at RGFW_MAX_KEY_CHANGES keys
+*/
+RGFWDEF const u8* RGFW_window_getKeyChanges(RGFW_window* win, size_t* count);
+/*! bit (1 << button) is set for each mouse button that was pressed or released since the window's event queue was last emptied */
+RGFWDEF u16 RGFW_window_getMouseChanges(RGFW_window* win);
 /** @} */ 
 
 /** * @defgroup Clipboard
@@ -836,6 +943,33 @@ RGFWDEF char* RGFW_readClipboard(size_t* size); /*!< read clipboard data */
 RGFWDEF void RGFW_clipboardFree(char* str); /*!< the string returned from RGFW_readClipboard must be freed */
 
 RGFWDEF void RGFW_writeClipboard(const char* text, u32 textLen); /*!< write text to the clipboard */
+
+typedef RGFW_ENUM(u8, RGFW_clipboardStatus) {
+	RGFW_clipboardNone = 0, /*!< not started */
+	RGFW_clipboardPending, /*!< waiting on the clipboard's owner */
+	RGFW_clipboardDone, /*!< data and size hold the clipboard text */
+	RGFW_clipboardTruncated, /*!< the text didn't fit in the caller's buffer, size is how much was kept */
+	RGFW_clipboardFailed /*!< there was no text on the clipboard (or the owner didn't answer) */
+};
+
+/*! an asynchronous clipboard read, the caller owns it and it's the request's handle */
+typedef struct RGFW_clipboardRequest {
+	char* data; /*!< the caller's buffer, or NULL to let RGFW allocate one (free it with RGFW_clipboardFree) */
+	size_t cap; /*!< size of the caller's buffer */
+	size_t size; /*!< bytes received, the text is '\0' terminated if there's room */
+	u8 status; /*!< RGFW_clipboardStatus */
+	b8 _owned, _overflow;
+} RGFW_clipboardRequest;
+
+/*!
+	start reading the clipboard without blocking, req has to stay alive until it's finished
+	it's finished by RGFW_window_checkEvent on win, which sends RGFW_clipboardReady 
+	(on X11 this also handles INCR transfers for large selections, the other backends finish before this returns)
+	an X11 owner that stops answering for RGFW_CLIPBOARD_TIMEOUT ms fails the request
+
+	only one request per window can be pending, returns RGFW_FALSE if it couldn't be started
+*/
+RGFWDEF b8 RGFW_window_readClipboardAsync(RGFW_window* win, RGFW_clipboardRequest* req);
 /** @} */ 
 
 /**
@@ -876,11 +1010,7 @@ typedef void (* RGFW_jsAxisfunc)(RGFW_window* win, u16 joystick, RGFW_point axis
 
 
 /*!  RGFW_dnd, the window that had the drop, the drop data and the amount files dropped returns previous callback function (if it was set) */
-#ifdef RGFW_ALLOC_DROPFILES
 	typedef void (* RGFW_dndfunc)(RGFW_window* win, char** droppedFiles, u32 droppedFilesCount);
-#else
-	typedef void (* RGFW_dndfunc)(RGFW_window* win, char droppedFiles[RGFW_MAX_DROPS][RGFW_MAX_PATH], u32 droppedFilesCount);
-#endif
 /*! set callback for a window move event returns previous callback function (if it was set)  */
 RGFWDEF RGFW_windowmovefunc RGFW_setWindowMoveCallback(RGFW_windowmovefunc func);
 /*! set callback for a window resize event returns previous callback function (if it was set)  */
@@ -942,6 +1072,10 @@ RGFWDEF RGFW_jsAxisfunc RGFW_setjsAxisCallback(RGFW_jsAxisfunc func);
 
 /*! joystick count starts at 0*/
 /*!< register joystick to window based on a number (the number is based on when it was connected eg. /dev/js0)*/
+/*! 
+	on linux, /dev/input is also watched (inotify), new /dev/input/js* devices are registered on their own (RGFW_jsConnected)
+	and unplugged ones free their slot (RGFW_jsDisconnected)
+*/
 RGFWDEF u16 RGFW_registerJoystick(RGFW_window* win, i32 jsNumber);
 RGFWDEF u16 RGFW_registerJoystickF(RGFW_window* win, char* file);
 
@@ -971,6 +1105,39 @@ RGFWDEF void RGFW_window_swapInterval(RGFW_window* win, i32 swapInterval);
 RGFWDEF void RGFW_window_setGPURender(RGFW_window* win, i8 set);
 RGFWDEF void RGFW_window_setCPURender(RGFW_window* win, i8 set);
 
+/*! 
+	mark part of the window as changed since the last RGFW_window_swapBuffers (in window coords, top left origin)
+	the next swap only presents the damaged rects, then the damage is cleared
+	with no damage the whole window is presented
+
+	everything inside a damaged rect must have been redrawn (for RGFW_BUFFER that's also what gets converted to BGRA)
+
+	X11 uses it for the RGFW_BUFFER / OSMesa upload, and EGL_KHR_swap_buffers_with_damage (or the EXT version) for OpenGL,
+	other backends (GLX included) present the full window
+*/
+RGFWDEF void RGFW_window_addDamage(RGFW_window* win, RGFW_rect r);
+RGFWDEF void RGFW_window_clearDamage(RGFW_window* win);
+
+/*!
+	how many swaps ago the OpenGL back buffer was drawn, so only what changed since has to be redrawn
+	0 if its contents are undefined (redraw everything), from GLX_EXT_buffer_age / EGL_EXT_buffer_age, 0 elsewhere
+	without OpenGL (RGFW_BUFFER / OSMesa) it's the age of win->buffer, see RGFW_window_setBufferPreserved
+*/
+RGFWDEF i32 RGFW_window_getBufferAge(RGFW_window* win);
+
+/*!
+	win->buffer keeps its contents across swaps by default, with X11 MIT-SHM that costs a copy of the damaged rects
+	(the whole window without damage) into the other segment on every swap
+	turn it off if every frame redraws the window, or what RGFW_window_getBufferAge says is stale, and the swap copies nothing
+*/
+RGFWDEF void RGFW_window_setBufferPreserved(RGFW_window* win, b8 preserved);
+
+/*! 
+	swap the red and blue channels of `count` 4 byte pixels in place (RGBA <-> BGRA)
+	uses SSE2 / AVX2 (picked at runtime) or NEON when it can, this is what converts the RGFW_BUFFER for X11 and wayland
+*/
+RGFWDEF void RGFW_swizzleBGRA(u8* pixels, size_t count);
+
 /*! native API functions */
 #if defined(RGFW_OPENGL) || defined(RGFW_EGL)
 	/*! OpenGL init hints */
@@ -1214,6 +1381,125 @@ int main() {
 #endif
 
 
+/*
+	RGBA <-> BGRA swizzle kernels 
+	(each kernel handles as many pixels as its vector width allows and leaves the rest to the scalar loop)
+
+	they don't need a window, define RGFW_SWIZZLE_IMPLEMENTATION instead of RGFW_IMPLEMENTATION to build only them
+*/
+
+#if (defined(RGFW_IMPLEMENTATION) || defined(RGFW_SWIZZLE_IMPLEMENTATION)) && !defined(RGFW_SWIZZLE_DEFINED)
+#define RGFW_SWIZZLE_DEFINED
+
+#if !defined(RGFW_NO_SIMD)
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define RGFW_SIMD_SSE2
+		#include <emmintrin.h>
+	#endif
+
+	#if defined(RGFW_SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		#define RGFW_SIMD_AVX2 /* compiled with the target attribute, only called if the cpu has it */
+		#include <immintrin.h>
+	#endif
+
+	#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+		#define RGFW_SIMD_NEON
+		#include <arm_neon.h>
+	#endif
+#endif
+
+RGFWDEF size_t RGFW_swizzleBGRA_scalar(u8* pixels, size_t count);
+size_t RGFW_swizzleBGRA_scalar(u8* pixels, size_t count) {
+	size_t i;
+	for (i = 0; i < count; i++, pixels += 4) {
+		u8 red = pixels[0];
+		pixels[0] = pixels[2];
+		pixels[2] = red;
+	}
+
+	return count;
+}
+
+#ifdef RGFW_SIMD_SSE2
+RGFWDEF size_t RGFW_swizzleBGRA_SSE2(u8* pixels, size_t count);
+size_t RGFW_swizzleBGRA_SSE2(u8* pixels, size_t count) {
+	const __m128i rbMask = _mm_set1_epi32(0x00FF00FF);
+
+	size_t i;
+	for (i = 0; i + 4 <= count; i += 4, pixels += 16) {
+		__m128i p = _mm_loadu_si128((__m128i*) pixels);
+		__m128i rb = _mm_and_si128(p, rbMask);
+		/* keep g and a, rotate r and b across each 32 bit pixel */
+		p = _mm_or_si128(_mm_andnot_si128(rbMask, p), _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+		_mm_storeu_si128((__m128i*) pixels, p);
+	}
+
+	return i;
+}
+#endif
+
+#ifdef RGFW_SIMD_AVX2
+RGFWDEF size_t RGFW_swizzleBGRA_AVX2(u8* pixels, size_t count);
+__attribute__((target("avx2")))
+size_t RGFW_swizzleBGRA_AVX2(u8* pixels, size_t count) {
+	const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+											 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+	size_t i;
+	for (i = 0; i + 8 <= count; i += 8, pixels += 32) {
+		__m256i p = _mm256_loadu_si256((__m256i*) pixels);
+		_mm256_storeu_si256((__m256i*) pixels, _mm256_shuffle_epi8(p, shuffle));
+	}
+
+	return i;
+}
+#endif
+
+#ifdef RGFW_SIMD_NEON
+RGFWDEF size_t RGFW_swizzleBGRA_NEON(u8* pixels, size_t count);
+size_t RGFW_swizzleBGRA_NEON(u8* pixels, size_t count) {
+	size_t i;
+	for (i = 0; i + 16 <= count; i += 16, pixels += 64) {
+		uint8x16x4_t p = vld4q_u8(pixels);
+		uint8x16_t red = p.val[0];
+		p.val[0] = p.val[2];
+		p.val[2] = red;
+		vst4q_u8(pixels, p);
+	}
+
+	return i;
+}
+#endif
+
+typedef size_t (* RGFW_swizzleFunc)(u8* pixels, size_t count);
+
+RGFWDEF RGFW_swizzleFunc RGFW_getSwizzleFunc(void);
+/* pick the widest kernel this cpu supports */
+RGFW_swizzleFunc RGFW_getSwizzleFunc(void) {
+	#ifdef RGFW_SIMD_AVX2
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return RGFW_swizzleBGRA_AVX2;
+	#endif
+	#if defined(RGFW_SIMD_SSE2)
+		return RGFW_swizzleBGRA_SSE2;
+	#elif defined(RGFW_SIMD_NEON)
+		return RGFW_swizzleBGRA_NEON;
+	#else
+		return RGFW_swizzleBGRA_scalar;
+	#endif
+}
+
+void RGFW_swizzleBGRA(u8* pixels, size_t count) {
+	static RGFW_swizzleFunc swizzle = NULL;
+	if (swizzle == NULL)
+		swizzle = RGFW_getSwizzleFunc();
+
+	size_t done = swizzle(pixels, count);
+	RGFW_swizzleBGRA_scalar(pixels + done * 4, count - done);
+}
+#endif /* RGFW_SWIZZLE_IMPLEMENTATION */
+
 #ifdef RGFW_IMPLEMENTATION
 
 #include <stdio.h>
@@ -1374,13 +1660,6 @@ void RGFW_init_keys(void) {
 #undef RGFW_NEXT
 #undef RGFW_MAP
 
-typedef struct {
-	b8 current  : 1;
-	b8 prev  : 1;
-} RGFW_keyState;
-
-RGFW_keyState RGFW_keyboard[final_key] = { {0, 0} };
-
 RGFWDEF u32 RGFW_apiKeyCodeToRGFW(u32 keycode);
 
 u32 RGFW_apiKeyCodeToRGFW(u32 keycode) {
@@ -1397,15 +1676,6 @@ u32 RGFW_apiKeyCodeToRGFW(u32 keycode) {
 	return RGFW_keycodes[keycode];
 }
 
-RGFWDEF void RGFW_resetKey(void);
-void RGFW_resetKey(void) {
-	size_t len = final_key; /*!< last_key == length */
-	
-	size_t i; /*!< reset each previous state  */
-	for (i = 0; i < len; i++)
-		RGFW_keyboard[i].prev = 0;
-}
-
 b8 RGFW_shouldShift(u32 keycode, u8 lockState) {
     #define RGFW_xor(x, y) (( (x) && (!(y)) ) ||  ((y) && (!(x)) ))
     b8 caps4caps = (lockState & RGFW_CAPSLOCK) && ((keycode >= RGFW_a) && (keycode <= RGFW_z));
@@ -1471,11 +1741,7 @@ void RGFW_mousebuttonfuncEMPTY(RGFW_window* win, u8 button, double scroll, b8 pr
 void RGFW_jsButtonfuncEMPTY(RGFW_window* win, u16 joystick, u8 button, b8 pressed){RGFW_UNUSED(win); RGFW_UNUSED(joystick); RGFW_UNUSED(button); RGFW_UNUSED(pressed); }
 void RGFW_jsAxisfuncEMPTY(RGFW_window* win, u16 joystick, RGFW_point axis[2], u8 axisesCount){RGFW_UNUSED(win); RGFW_UNUSED(joystick); RGFW_UNUSED(axis); RGFW_UNUSED(axisesCount); }
 
-#ifdef RGFW_ALLOC_DROPFILES
 void RGFW_dndfuncEMPTY(RGFW_window* win, char** droppedFiles, u32 droppedFilesCount) {RGFW_UNUSED(win); RGFW_UNUSED(droppedFiles); RGFW_UNUSED(droppedFilesCount);}
-#else
-void RGFW_dndfuncEMPTY(RGFW_window* win, char droppedFiles[RGFW_MAX_DROPS][RGFW_MAX_PATH], u32 droppedFilesCount) {RGFW_UNUSED(win); RGFW_UNUSED(droppedFiles); RGFW_UNUSED(droppedFilesCount);}
-#endif
 
 RGFW_windowmovefunc RGFW_windowMoveCallback = RGFW_windowmovefuncEMPTY;
 RGFW_windowresizefunc RGFW_windowResizeCallback = RGFW_windowresizefuncEMPTY;
@@ -1596,6 +1862,92 @@ void RGFW_setBufferSize(RGFW_area size) {
 }
 
 
+/* 
+	dropped files 
+	each platform calls RGFW_window_beginDrop, then RGFW_window_addDrop per path, then RGFW_window_endDrop
+	the paths are packed into one growing buffer, the char* table is only built at the end (the buffer can move while it grows)
+*/
+
+RGFWDEF void RGFW_window_beginDrop(RGFW_window* win);
+RGFWDEF void RGFW_window_addDrop(RGFW_window* win, const char* path, size_t len);
+RGFWDEF void RGFW_window_endDrop(RGFW_window* win);
+RGFWDEF void RGFW_window_freeDrops(RGFW_window* win);
+
+void RGFW_window_beginDrop(RGFW_window* win) {
+	win->_dropArenaLen = 0;
+	win->event.droppedFilesCount = 0;
+}
+
+void RGFW_window_addDrop(RGFW_window* win, const char* path, size_t len) {
+	if (win->_dropArenaLen + len + 1 > win->_dropArenaCap) {
+		size_t cap = win->_dropArenaCap ? win->_dropArenaCap : 1024;
+		while (cap < win->_dropArenaLen + len + 1)
+			cap *= 2;
+
+		char* arena = (char*) RGFW_MALLOC(cap);
+		if (arena == NULL)
+			return;
+
+		if (win->_dropArena != NULL) {
+			memcpy(arena, win->_dropArena, win->_dropArenaLen);
+			RGFW_FREE(win->_dropArena);
+		}
+
+		win->_dropArena = arena;
+		win->_dropArenaCap = cap;
+	}
+
+	memcpy(win->_dropArena + win->_dropArenaLen, path, len);
+	win->_dropArena[win->_dropArenaLen + len] = '\0';
+	win->_dropArenaLen += len + 1;
+	win->event.droppedFilesCount++;
+}
+
+void RGFW_window_endDrop(RGFW_window* win) {
+	if (win->event.droppedFilesCount > win->_dropFilesCap) {
+		if (win->_dropFiles != NULL)
+			RGFW_FREE(win->_dropFiles);
+
+		win->_dropFilesCap = win->event.droppedFilesCount;
+		win->_dropFiles = (char**) RGFW_MALLOC(sizeof(char*) * win->_dropFilesCap);
+
+		if (win->_dropFiles == NULL) {
+			win->_dropFilesCap = 0;
+			win->event.droppedFilesCount = 0;
+		}
+	}
+
+	char* path = win->_dropArena;
+	u32 i;
+	for (i = 0; i < win->event.droppedFilesCount; i++) {
+		win->_dropFiles[i] = path;
+		path += strlen(path) + 1;
+	}
+
+	win->event.droppedFiles = win->_dropFiles;
+}
+
+void RGFW_window_freeDrops(RGFW_window* win) {
+	if (win->_dropArena != NULL)
+		RGFW_FREE(win->_dropArena);
+	if (win->_dropFiles != NULL)
+		RGFW_FREE(win->_dropFiles);
+
+	win->_dropArena = NULL;
+	win->_dropFiles = NULL;
+	win->_dropArenaLen = win->_dropArenaCap = 0;
+	win->_dropFilesCap = 0;
+	win->event.droppedFiles = NULL;
+	win->event.droppedFilesCount = 0;
+}
+
+#ifdef RGFW_X11
+RGFWDEF void RGFW_loadAtoms(Display* display);
+#ifndef RGFW_NO_MONITOR
+RGFWDEF void RGFW_XSelectMonitorEvents(Display* display);
+#endif
+#endif
+
 RGFWDEF RGFW_window* RGFW_window_basic_init(RGFW_rect rect, u16 args);
 
 /* do a basic initialization for RGFW_window, this is to standard it for each OS */
@@ -1603,12 +1955,23 @@ RGFW_window* RGFW_window_basic_init(RGFW_rect rect, u16 args) {
 	RGFW_window* win = (RGFW_window*) RGFW_MALLOC(sizeof(RGFW_window)); /*!< make a new RGFW struct */
 
 	/* clear out dnd info */
-#ifdef RGFW_ALLOC_DROPFILES
-	win->event.droppedFiles = (char**) RGFW_MALLOC(sizeof(char*) * RGFW_MAX_DROPS);
-	u32 i;
-	for (i = 0; i < RGFW_MAX_DROPS; i++)
-		win->event.droppedFiles[i] = (char*) RGFW_CALLOC(RGFW_MAX_PATH, sizeof(char));
-#endif
+	win->_dropArena = NULL;
+	win->_dropFiles = NULL;
+	win->_dropArenaLen = win->_dropArenaCap = 0;
+	win->_dropFilesCap = 0;
+	win->event.droppedFiles = NULL;
+	win->_frameTime = win->_frameTime2 = 0;
+	win->motionSampleCount = 0;
+	win->_hasRawMotion = RGFW_FALSE;
+
+	memset(win->_keys, 0, sizeof(win->_keys));
+	memset(win->_keysPrev, 0, sizeof(win->_keysPrev));
+	memset(win->_keyChanged, 0, sizeof(win->_keyChanged));
+	win->_keyChangeCount = 0;
+	win->_keyChangesFull = RGFW_FALSE;
+	win->_queueEmptied = RGFW_FALSE;
+	win->_jsPolled = RGFW_FALSE;
+	win->_mouse = win->_mousePrev = win->_mouseChanged = 0;
 
 	/* X11 requires us to have a display to get the screen size */
 	#ifndef RGFW_X11 
@@ -1617,6 +1980,11 @@ RGFW_window* RGFW_window_basic_init(RGFW_rect rect, u16 args) {
 	win->src.display = XOpenDisplay(NULL);
 	assert(win->src.display != NULL);
 
+	RGFW_loadAtoms(win->src.display);
+	#ifndef RGFW_NO_MONITOR
+	RGFW_XSelectMonitorEvents(win->src.display);
+	#endif
+
 	Screen* scrn = DefaultScreenOfDisplay((Display*)win->src.display);
 	RGFW_area screenR = RGFW_AREA((u32)scrn->width, (u32)scrn->height);
 	#endif
@@ -1629,9 +1997,11 @@ RGFW_window* RGFW_window_basic_init(RGFW_rect rect, u16 args) {
 	win->r = rect;
 	win->event.inFocus = 1;
 	win->event.droppedFilesCount = 0;
-	RGFW_joystickCount = 0;
 	win->_winArgs = 0;
 	win->event.lockState = 0;
+	win->damageCount = 0;
+	win->_swapExts = 0;
+	win->_swapWithDamage = NULL;
 
 	return win;
 }
@@ -1649,6 +2019,69 @@ RGFW_window* RGFW_root = NULL;
 
 #define RGFW_HOLD_MOUSE			(1L<<2) /*!< hold the moues still */
 #define RGFW_MOUSE_LEFT 		(1L<<3) /* if mouse left the window */
+#define RGFW_RAW_MOUSE			(1L<<17) /*!< mouse moves are read with sub-pixel precision (RGFW_window_setRawMouse) */
+#define RGFW_BUFFER_DISCARD		(1L<<18) /*!< swaps don't carry win->buffer's contents over (RGFW_window_setBufferPreserved) */
+
+RGFWDEF void RGFW_window_pushDrainedEvent(RGFW_window* win, RGFW_Event* events, u32* count);
+
+/* copy win->event into the drain array, merging it into the previous event if both are mouse moves */
+void RGFW_window_pushDrainedEvent(RGFW_window* win, RGFW_Event* events, u32* count) {
+	RGFW_Event* last = (*count) ? &events[*count - 1] : NULL;
+	b8 sampled = RGFW_FALSE;
+
+	if (win->event.type == RGFW_mousePosChanged && win->motionSampleCount < RGFW_MAX_MOTION_SAMPLES) {
+		RGFW_pointerSample* sample = &win->motionSamples[win->motionSampleCount++];
+
+		if (win->_hasRawMotion)
+			*sample = win->_rawMotion;
+		else {
+			sample->x = win->event.point.x;
+			sample->y = win->event.point.y;
+			sample->time = RGFW_getTimeNS() / 1000000;
+		}
+
+		sampled = RGFW_TRUE;
+	}
+
+	if (win->event.type == RGFW_mousePosChanged && last != NULL && last->type == RGFW_mousePosChanged) {
+		if (win->_winArgs & RGFW_HOLD_MOUSE) { /* raw deltas add up */
+			last->point.x += win->event.point.x;
+			last->point.y += win->event.point.y;
+		} else
+			last->point = win->event.point;
+
+		last->motionSampleCount += sampled;
+		return;
+	}
+
+	events[*count] = win->event;
+	events[*count].motionSample = (u16)(win->motionSampleCount - sampled);
+	events[*count].motionSampleCount = sampled;
+	(*count)++;
+}
+
+#ifndef RGFW_X11
+u32 RGFW_window_drainEvents(RGFW_window* win, RGFW_Event* events, u32 maxEvents) {
+	assert(win != NULL);
+
+	u32 count = 0;
+	win->motionSampleCount = 0;
+
+	while (count < maxEvents && RGFW_window_checkEvent(win) != NULL)
+		RGFW_window_pushDrainedEvent(win, events, &count);
+
+	return count;
+}
+
+void RGFW_window_setRawMouse(RGFW_window* win, b8 raw) {
+	assert(win != NULL);
+
+	if (raw)
+		win->_winArgs |= RGFW_RAW_MOUSE;
+	else
+		win->_winArgs &= ~(u32)RGFW_RAW_MOUSE;
+}
+#endif
 
 #ifdef RGFW_MACOS
 RGFWDEF void RGFW_window_cocoaSetLayer(RGFW_window* win, void* layer);
@@ -1662,15 +2095,175 @@ void RGFW_setClassName(char* name) {
 
 void RGFW_clipboardFree(char* str) { RGFW_FREE(str); }
 
-RGFW_keyState RGFW_mouseButtons[5] = { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0} };
+RGFWDEF void RGFW_clipboardRequest_begin(RGFW_clipboardRequest* req);
+RGFWDEF void RGFW_clipboardRequest_append(RGFW_clipboardRequest* req, const char* data, size_t len);
+RGFWDEF void RGFW_clipboardRequest_finish(RGFW_clipboardRequest* req, u8 status);
+
+void RGFW_clipboardRequest_begin(RGFW_clipboardRequest* req) {
+	req->_owned = (req->data == NULL);
+	if (req->_owned)
+		req->cap = 0;
+
+	req->size = 0;
+	req->_overflow = RGFW_FALSE;
+	req->status = RGFW_clipboardPending;
+}
+
+void RGFW_clipboardRequest_append(RGFW_clipboardRequest* req, const char* data, size_t len) {
+	/* keep room for the '\0' */
+	if (req->_owned && req->size + len + 1 > req->cap) {
+		size_t cap = req->cap ? req->cap : 4096;
+		while (cap < req->size + len + 1)
+			cap *= 2;
+
+		char* buffer = (char*) RGFW_MALLOC(cap);
+		if (buffer == NULL) {
+			req->_overflow = RGFW_TRUE;
+			return;
+		}
+
+		if (req->data != NULL) {
+			memcpy(buffer, req->data, req->size);
+			RGFW_FREE(req->data);
+		}
+
+		req->data = buffer;
+		req->cap = cap;
+	}
+
+	if (req->size + len > req->cap) {
+		len = req->cap - req->size;
+		req->_overflow = RGFW_TRUE;
+	}
+
+	memcpy(req->data + req->size, data, len);
+	req->size += len;
+}
+
+void RGFW_clipboardRequest_finish(RGFW_clipboardRequest* req, u8 status) {
+	if (req->data != NULL && req->size < req->cap)
+		req->data[req->size] = '\0';
+
+	if (status == RGFW_clipboardDone && req->_overflow)
+		status = RGFW_clipboardTruncated;
+
+	req->status = status;
+}
+
+#ifndef RGFW_X11
+/* the other backends read the clipboard right away */
+b8 RGFW_window_readClipboardAsync(RGFW_window* win, RGFW_clipboardRequest* req) {
+	assert(win != NULL && req != NULL);
+
+	RGFW_clipboardRequest_begin(req);
+
+	char* str = RGFW_readClipboard(NULL);
+	if (str == NULL) {
+		RGFW_clipboardRequest_finish(req, RGFW_clipboardFailed);
+		return RGFW_TRUE;
+	}
+
+	RGFW_clipboardRequest_append(req, str, strlen(str));
+	RGFW_clipboardFree(str);
+
+	RGFW_clipboardRequest_finish(req, RGFW_clipboardDone);
+	return RGFW_TRUE;
+}
+#endif
+
+#define RGFW_keyBit(bits, key) ((bits)[(key) >> 3] & (1 << ((key) & 7)))
+
+/* 
+	every window's key events together, what RGFW_isPressed(NULL, key) reads (RGFW_shouldShift's shift state for any window)
+	a byte per key, so windows on different threads don't share the bytes they write
+*/
+typedef struct { b8 current, prev; } RGFW_keyState;
+RGFW_keyState RGFW_keyboard[256];
+
+/* record a key event, the old state becomes the previous state */
+RGFWDEF void RGFW_window_setKey(RGFW_window* win, u8 key, b8 pressed);
+void RGFW_window_setKey(RGFW_window* win, u8 key, b8 pressed) {
+	u8 byte = key >> 3;
+	u8 bit = (u8)(1 << (key & 7));
+
+	RGFW_keyboard[key].prev = RGFW_keyboard[key].current;
+	RGFW_keyboard[key].current = pressed;
+
+	win->_keysPrev[byte] = (u8)((win->_keysPrev[byte] & ~bit) | (win->_keys[byte] & bit));
+	
+	if (pressed)
+		win->_keys[byte] |= bit;
+	else
+		win->_keys[byte] &= (u8)~bit;
+
+	if (win->_keyChanged[byte] & bit)
+		return;
+
+	win->_keyChanged[byte] |= bit;
+
+	if (win->_keyChangeCount < RGFW_MAX_KEY_CHANGES)
+		win->_keyChanges[win->_keyChangeCount++] = key;
+	else
+		win->_keyChangesFull = RGFW_TRUE;
+}
+
+RGFWDEF void RGFW_window_setMouseButton(RGFW_window* win, u8 button, b8 pressed);
+void RGFW_window_setMouseButton(RGFW_window* win, u8 button, b8 pressed) {
+	/* X11 can send buttons past the ones RGFW knows about */
+	if (button >= 16)
+		return;
+
+	u16 bit = (u16)(1 << button);
+	win->_mousePrev = (u16)((win->_mousePrev & ~bit) | (win->_mouse & bit));
+	
+	if (pressed)
+		win->_mouse |= bit;
+	else
+		win->_mouse &= (u16)~bit;
+
+	win->_mouseChanged |= bit;
+}
+
+/* start a new frame, only the keys that changed in the last one have a previous state to clear */
+RGFWDEF void RGFW_window_resetKeys(RGFW_window* win);
+void RGFW_window_resetKeys(RGFW_window* win) {
+	if (win->_keyChangesFull) {
+		memset(win->_keysPrev, 0, sizeof(win->_keysPrev));
+		memset(win->_keyChanged, 0, sizeof(win->_keyChanged));
+	} else {
+		u8 i;
+		for (i = 0; i < win->_keyChangeCount; i++) {
+			u8 key = win->_keyChanges[i];
+			u8 bit = (u8)(1 << (key & 7));
+			win->_keysPrev[key >> 3] &= (u8)~bit;
+			win->_keyChanged[key >> 3] &= (u8)~bit;
+		}
+	}
+
+	win->_keyChangeCount = 0;
+	win->_keyChangesFull = RGFW_FALSE;
+	win->_mouseChanged = 0;
+}
+
+const u8* RGFW_window_getKeyChanges(RGFW_window* win, size_t* count) {
+	assert(win != NULL && count != NULL);
+
+	*count = win->_keyChangeCount;
+	return win->_keyChanges;
+}
+
+u16 RGFW_window_getMouseChanges(RGFW_window* win) {
+	assert(win != NULL);
+	return win->_mouseChanged;
+}
 
 b8 RGFW_isMousePressed(RGFW_window* win, u8 button) {
 	assert(win != NULL);
-	return RGFW_mouseButtons[button].current && (win != NULL) && win->event.inFocus; 
+	return (button < 16) && (win->_mouse & (1 << button)) && win->event.inFocus; 
 }
 b8 RGFW_wasMousePressed(RGFW_window* win, u8 button) {
 	assert(win != NULL); 
-	return RGFW_mouseButtons[button].prev && (win != NULL) && win->event.inFocus; 
+	return (button < 16) && (win->_mousePrev & (1 << button)) && win->event.inFocus; 
 }
 b8 RGFW_isMouseHeld(RGFW_window* win, u8 button) {
 	return (RGFW_isMousePressed(win, button) && RGFW_wasMousePressed(win, button));
@@ -1680,11 +2273,17 @@ b8 RGFW_isMouseReleased(RGFW_window* win, u8 button) {
 }
 
 b8 RGFW_isPressed(RGFW_window* win, u8 key) {
-	return RGFW_keyboard[key].current && (win == NULL || win->event.inFocus);
+	if (win == NULL)
+		return RGFW_keyboard[key].current;
+
+	return RGFW_keyBit(win->_keys, key) && win->event.inFocus;
 }
 
 b8 RGFW_wasPressed(RGFW_window* win, u8 key) {
-	return RGFW_keyboard[key].prev && (win == NULL || win->event.inFocus);
+	if (win == NULL)
+		return RGFW_keyboard[key].prev;
+
+	return RGFW_keyBit(win->_keysPrev, key) && win->event.inFocus;
 }
 
 b8 RGFW_isHeld(RGFW_window* win, u8 key) {
@@ -1733,35 +2332,134 @@ void RGFW_window_setCPURender(RGFW_window* win, i8 set) {
 		win->_winArgs ^= RGFW_NO_CPU_RENDER;
 }
 
-void RGFW_window_maximize(RGFW_window* win) {
-	assert(win != NULL);
-
-	RGFW_area screen = RGFW_getScreenSize();
+RGFWDEF RGFW_rect RGFW_rectUnion(RGFW_rect a, RGFW_rect b);
+RGFW_rect RGFW_rectUnion(RGFW_rect a, RGFW_rect b) {
+	i32 right = (a.x + a.w > b.x + b.w) ? a.x + a.w : b.x + b.w;
+	i32 bottom = (a.y + a.h > b.y + b.h) ? a.y + a.h : b.y + b.h;
 
-	RGFW_window_move(win, RGFW_POINT(0, 0));
-	RGFW_window_resize(win, screen);
+	a.x = (a.x < b.x) ? a.x : b.x;
+	a.y = (a.y < b.y) ? a.y : b.y;
+	return RGFW_RECT(a.x, a.y, right - a.x, bottom - a.y);
 }
 
-b8 RGFW_window_shouldClose(RGFW_window* win) {
+void RGFW_window_addDamage(RGFW_window* win, RGFW_rect r) {
 	assert(win != NULL);
-	return (win->event.type == RGFW_quit || RGFW_isPressed(win, RGFW_Escape));
-}
 
-void RGFW_window_setShouldClose(RGFW_window* win) { win->event.type = RGFW_quit; RGFW_windowQuitCallback(win); }
+	/* clip to the window */
+	i32 right = r.x + r.w, bottom = r.y + r.h;
+	if (r.x < 0) r.x = 0;
+	if (r.y < 0) r.y = 0;
+	if (right > win->r.w) right = win->r.w;
+	if (bottom > win->r.h) bottom = win->r.h;
 
-#ifndef RGFW_NO_MONITOR
-	void RGFW_window_moveToMonitor(RGFW_window* win, RGFW_monitor m) {
-		RGFW_window_move(win, RGFW_POINT(m.rect.x + win->r.x, m.rect.y + win->r.y));
-	}
-#endif
+	if (right <= r.x || bottom <= r.y)
+		return;
 
-RGFWDEF void RGFW_captureCursor(RGFW_window* win, RGFW_rect);
-RGFWDEF void RGFW_releaseCursor(RGFW_window* win);
+	r.w = right - r.x;
+	r.h = bottom - r.y;
 
-void RGFW_window_mouseHold(RGFW_window* win, RGFW_area area) {
-	if ((win->_winArgs & RGFW_HOLD_MOUSE))
-		return;
-	
+	/* 
+		merge r with anything it touches, the merged rect can reach new rects so start over each time
+		(the list stays tiny, so this is cheap) 
+	*/
+	u32 i;
+	for (i = 0; i < win->damageCount; i++) {
+		RGFW_rect d = win->damage[i];
+		if (r.x > d.x + d.w || d.x > r.x + r.w || r.y > d.y + d.h || d.y > r.y + r.h)
+			continue;
+
+		r = RGFW_rectUnion(r, d);
+		win->damage[i] = win->damage[--win->damageCount];
+		i = (u32)-1;
+	}
+
+	if (win->damageCount < RGFW_MAX_DAMAGE_RECTS) {
+		win->damage[win->damageCount++] = r;
+		return;
+	}
+
+	/* out of room, grow the rect that gains the least area */
+	u32 best = 0;
+	i64 bestGrowth = -1;
+	for (i = 0; i < win->damageCount; i++) {
+		RGFW_rect u = RGFW_rectUnion(win->damage[i], r);
+		i64 growth = (i64)u.w * u.h - (i64)win->damage[i].w * win->damage[i].h;
+		if (bestGrowth < 0 || growth < bestGrowth) {
+			best = i;
+			bestGrowth = growth;
+		}
+	}
+
+	win->damage[best] = RGFW_rectUnion(win->damage[best], r);
+}
+
+void RGFW_window_clearDamage(RGFW_window* win) {
+	assert(win != NULL);
+	win->damageCount = 0;
+}
+
+/* RGFW_window._swapExts */
+enum {
+	RGFW_swapExtsChecked = (1 << 0), /* the extension string was read for this window */
+	RGFW_swapBufferAge = (1 << 1)
+};
+
+#if !defined(RGFW_EGL) && !(defined(RGFW_X11) && defined(RGFW_OPENGL))
+i32 RGFW_window_getBufferAge(RGFW_window* win) {
+	assert(win != NULL);
+
+#ifdef RGFW_X11_SHM
+	/* win->buffer alternates between two segments, left alone it holds the frame from two swaps ago */
+	if (win->src.shm[0].shmaddr != NULL && (win->_winArgs & RGFW_BUFFER_DISCARD))
+		return (win->src.shmDrawn & (1 << win->src.shmCurrent)) ? 2 : 0;
+#endif
+
+#if defined(RGFW_OSMESA) || defined(RGFW_BUFFER)
+	return 1;
+#else
+	return 0;
+#endif
+}
+#endif
+
+void RGFW_window_setBufferPreserved(RGFW_window* win, b8 preserved) {
+	assert(win != NULL);
+
+	if (preserved)
+		win->_winArgs &= ~RGFW_BUFFER_DISCARD;
+	else
+		win->_winArgs |= RGFW_BUFFER_DISCARD;
+}
+
+void RGFW_window_maximize(RGFW_window* win) {
+	assert(win != NULL);
+
+	RGFW_area screen = RGFW_getScreenSize();
+
+	RGFW_window_move(win, RGFW_POINT(0, 0));
+	RGFW_window_resize(win, screen);
+}
+
+b8 RGFW_window_shouldClose(RGFW_window* win) {
+	assert(win != NULL);
+	return (win->event.type == RGFW_quit || RGFW_isPressed(win, RGFW_Escape));
+}
+
+void RGFW_window_setShouldClose(RGFW_window* win) { win->event.type = RGFW_quit; RGFW_windowQuitCallback(win); }
+
+#ifndef RGFW_NO_MONITOR
+	void RGFW_window_moveToMonitor(RGFW_window* win, RGFW_monitor m) {
+		RGFW_window_move(win, RGFW_POINT(m.rect.x + win->r.x, m.rect.y + win->r.y));
+	}
+#endif
+
+RGFWDEF void RGFW_captureCursor(RGFW_window* win, RGFW_rect);
+RGFWDEF void RGFW_releaseCursor(RGFW_window* win);
+
+void RGFW_window_mouseHold(RGFW_window* win, RGFW_area area) {
+	if ((win->_winArgs & RGFW_HOLD_MOUSE))
+		return;
+	
 
 	if (!area.w && !area.h)
 		area = RGFW_AREA(win->r.w / 2, win->r.h / 2);
@@ -1780,7 +2478,7 @@ void RGFW_window_mouseUnhold(RGFW_window* win) {
 }
 
 u32 RGFW_window_checkFPS(RGFW_window* win, u32 fpsCap) {
-	u64 deltaTime = RGFW_getTimeNS() - win->event.frameTime;
+	u64 deltaTime = RGFW_getTimeNS() - win->_frameTime;
 
 	u32 output_fps = 0;
 	u64 fps = round(1e+9 / deltaTime);
@@ -1792,18 +2490,18 @@ u32 RGFW_window_checkFPS(RGFW_window* win, u32 fpsCap) {
 
 		if (sleepTimeMS > 0) {
 			RGFW_sleep(sleepTimeMS);
-			win->event.frameTime = 0;
+			win->_frameTime = 0;
 		}
 	}
 
-	win->event.frameTime = RGFW_getTimeNS();
+	win->_frameTime = RGFW_getTimeNS();
 	
 	if (fpsCap == 0) 
 		return (u32) output_fps;
 	
-	deltaTime = RGFW_getTimeNS() - win->event.frameTime2;
+	deltaTime = RGFW_getTimeNS() - win->_frameTime2;
 	output_fps = round(1e+9 / deltaTime);
-	win->event.frameTime2 = RGFW_getTimeNS();
+	win->_frameTime2 = RGFW_getTimeNS();
 
 	return output_fps;
 }
@@ -1852,6 +2550,7 @@ void RGFW_updateLockState(RGFW_window* win, b8 capital, b8 numlock) {
 	}
 #endif
 
+
 /*
 	graphics API specific code (end of generic code)
 	starts here 
@@ -2190,6 +2889,67 @@ void RGFW_updateLockState(RGFW_window* win, b8 capital, b8 numlock) {
 		eglMakeCurrent(win->src.EGL_display, win->src.EGL_surface, win->src.EGL_surface, win->src.EGL_context);
 	}
 
+	typedef EGLBoolean (EGLAPIENTRY * PFN_RGFW_eglSwapBuffersWithDamage)(EGLDisplay, EGLSurface, EGLint*, EGLint);
+
+	#ifndef EGL_BUFFER_AGE_EXT
+	#define EGL_BUFFER_AGE_EXT 0x313D
+	#endif
+
+	RGFWDEF void RGFW_window_checkSwapExts_EGL(RGFW_window* win);
+	RGFWDEF void RGFW_window_swapBuffers_EGL(RGFW_window* win);
+
+	/* the extensions come with the window's display, so each window looks them up once */
+	void RGFW_window_checkSwapExts_EGL(RGFW_window* win) {
+		if (win->_swapExts & RGFW_swapExtsChecked)
+			return;
+
+		const char* exts = eglQueryString(win->src.EGL_display, EGL_EXTENSIONS);
+		if (exts != NULL && strstr(exts, "EGL_KHR_swap_buffers_with_damage") != NULL)
+			win->_swapWithDamage = (void*) eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+		else if (exts != NULL && strstr(exts, "EGL_EXT_swap_buffers_with_damage") != NULL)
+			win->_swapWithDamage = (void*) eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+
+		if (exts != NULL && strstr(exts, "EGL_EXT_buffer_age") != NULL)
+			win->_swapExts |= RGFW_swapBufferAge;
+
+		win->_swapExts |= RGFW_swapExtsChecked;
+	}
+
+	/* eglSwapBuffers, but passes the damaged rects along if EGL_KHR/EXT_swap_buffers_with_damage is there */
+	void RGFW_window_swapBuffers_EGL(RGFW_window* win) {
+		RGFW_window_checkSwapExts_EGL(win);
+		PFN_RGFW_eglSwapBuffersWithDamage swapWithDamage = (PFN_RGFW_eglSwapBuffersWithDamage) win->_swapWithDamage;
+
+		if (swapWithDamage == NULL || win->damageCount == 0) {
+			eglSwapBuffers(win->src.EGL_display, win->src.EGL_surface);
+			return;
+		}
+
+		/* EGL wants a bottom left origin */
+		EGLint rects[RGFW_MAX_DAMAGE_RECTS * 4];
+		u32 i;
+		for (i = 0; i < win->damageCount; i++) {
+			RGFW_rect r = win->damage[i];
+			rects[i * 4] = r.x;
+			rects[i * 4 + 1] = win->r.h - (r.y + r.h);
+			rects[i * 4 + 2] = r.w;
+			rects[i * 4 + 3] = r.h;
+		}
+
+		swapWithDamage(win->src.EGL_display, win->src.EGL_surface, rects, win->damageCount);
+	}
+
+	i32 RGFW_window_getBufferAge(RGFW_window* win) {
+		assert(win != NULL);
+		RGFW_window_checkSwapExts_EGL(win);
+
+		EGLint age = 0;
+		if (!(win->_swapExts & RGFW_swapBufferAge) || 
+			eglQuerySurface(win->src.EGL_display, win->src.EGL_surface, EGL_BUFFER_AGE_EXT, &age) == EGL_FALSE)
+			return 0;
+		return age;
+	}
+
 	#ifdef RGFW_APPLE
 	void* RGFWnsglFramework = NULL;
 	#elif defined(RGFW_WINDOWS)
@@ -2259,58 +3019,289 @@ This is where OS specific stuff starts
 
 
 #if defined(RGFW_WAYLAND) || defined(RGFW_X11)
-	int RGFW_eventWait_forceStop[] = {0, 0, 0}; /* for wait events */
+	RGFWDEF void RGFW_window_initWake(RGFW_window* win);
+	RGFWDEF void RGFW_window_closeWake(RGFW_window* win);
 
 	#ifdef __linux__
 		#include <linux/joystick.h>
 		#include <fcntl.h>
 		#include <unistd.h>
 		
-		RGFW_Event* RGFW_linux_updateJoystick(RGFW_window* win) {
-			static int xAxis = 0, yAxis = 0;
-			u8 i;
+		#include <sys/inotify.h>
+		#include <poll.h>
+		#include <errno.h>
+		#include <pthread.h>
+
+		u8 RGFW_jsAxesCount[4]; /*!< JSIOCGAXES, asked once when the joystick is registered */
+		RGFW_point RGFW_jsAxis[4][2]; /*!< the current axis state of each joystick */
+		char RGFW_jsFile[4][RGFW_MAX_PATH]; /*!< device each joystick was opened from (for hotplug) */
+		i32 RGFW_jsInotify = -1; /*!< watches /dev/input for joysticks coming and going */
+
+		/* 
+			js_events are read in bulk, then handed out by checkEvent one by one
+			(this is drained before anything is read again)
+		*/
+		struct js_event RGFW_jsEvents[64];
+		u8 RGFW_jsEventJoystick[64];
+		u32 RGFW_jsEventIndex = 0, RGFW_jsEventLen = 0;
+
+		/* same for inotify events */
+		char RGFW_jsHotplugBuffer[sizeof(struct inotify_event) * 16 + 256] __attribute__((aligned(__alignof__(struct inotify_event))));
+		ssize_t RGFW_jsHotplugOffset = 0, RGFW_jsHotplugLen = 0;
+
+		/* every window's checkEvent drains the buffers above, from whichever thread pumps it */
+		pthread_mutex_t RGFW_jsLock = PTHREAD_MUTEX_INITIALIZER;
+
+		RGFWDEF i32 RGFW_linux_openJoystick(char* file);
+		RGFWDEF void RGFW_linux_closeJoystick(u16 js);
+		RGFWDEF void RGFW_linux_initJoystickHotplug(void);
+		RGFWDEF RGFW_Event* RGFW_linux_updateHotplug(RGFW_window* win);
+		RGFWDEF RGFW_Event* RGFW_linux_drainJoysticks(RGFW_window* win);
+		RGFWDEF RGFW_Event* RGFW_linux_updateJoystick(RGFW_window* win);
+
+		/* opens and sets up a joystick slot, returns the slot or -1 */
+		i32 RGFW_linux_openJoystick(char* file) {
+			u16 i, slot = RGFW_joystickCount;
 			for (i = 0; i < RGFW_joystickCount; i++) {
-				struct js_event e;
+				if (RGFW_joysticks[i] == 0 && slot == RGFW_joystickCount)
+					slot = i;
+				else if (RGFW_joysticks[i] && strncmp(RGFW_jsFile[i], file, RGFW_MAX_PATH) == 0)
+					return i; /* already open */
+			}
 
+			if (slot >= 4)
+				return -1;
 
-				if (RGFW_joysticks[i] == 0)
-					continue;
+			i32 js = open(file, O_RDONLY | O_NONBLOCK);
+			if (js == -1)
+				return -1;
 
-				i32 flags = fcntl(RGFW_joysticks[i], F_GETFL, 0);
-				fcntl(RGFW_joysticks[i], F_SETFL, flags | O_NONBLOCK);
+			if (slot == RGFW_joystickCount)
+				RGFW_joystickCount++;
 
-				ssize_t bytes;
-				while ((bytes = read(RGFW_joysticks[i], &e, sizeof(e))) > 0) {
-					switch (e.type) {
-					case JS_EVENT_BUTTON:
-						win->event.type = e.value ? RGFW_jsButtonPressed : RGFW_jsButtonReleased;
-						win->event.button = e.number;
-						RGFW_jsPressed[i][e.number] = e.value;
-						RGFW_jsButtonCallback(win, i, e.number, e.value);
-						return &win->event;
-					case JS_EVENT_AXIS:
-						ioctl(RGFW_joysticks[i], JSIOCGAXES, &win->event.axisesCount);
+			RGFW_joysticks[slot] = js;
+			strncpy(RGFW_jsFile[slot], file, RGFW_MAX_PATH - 1);
+			RGFW_jsFile[slot][RGFW_MAX_PATH - 1] = '\0';
+
+			u8 axes = 0;
+			ioctl(js, JSIOCGAXES, &axes);
+			RGFW_jsAxesCount[slot] = (axes > 4) ? 2 : (axes + 1) / 2; /* RGFW_Event.axis only has room for 2 */
+
+			memset(RGFW_jsPressed[slot], 0, sizeof(RGFW_jsPressed[slot]));
+			memset(RGFW_jsAxis[slot], 0, sizeof(RGFW_jsAxis[slot]));
+			return slot;
+		}
+
+		void RGFW_linux_closeJoystick(u16 js) {
+			if (RGFW_joysticks[js] == 0)
+				return;
+
+			close(RGFW_joysticks[js]);
+			RGFW_joysticks[js] = 0;
+			RGFW_jsFile[js][0] = '\0';
+
+			/* drop anything still queued from it */
+			u32 i;
+			for (i = RGFW_jsEventIndex; i < RGFW_jsEventLen; i++) {
+				if (RGFW_jsEventJoystick[i] == js)
+					RGFW_jsEvents[i].type = 0;
+			}
+		}
+
+		/* set up once, by the first RGFW_createWindow, so joysticks plugged in later are seen too */
+		void RGFW_linux_initJoystickHotplug(void) {
+			if (RGFW_jsInotify != -1)
+				return;
+
+			RGFW_jsInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (RGFW_jsInotify == -1)
+				return;
 
-						if ((e.number == 0 || e.number % 2) && e.number != 1)
-							xAxis = e.value;
-						else
-							yAxis = e.value;
+			/* udev fixes the permissions after creating the node, so IN_ATTRIB is when it can be opened */
+			if (inotify_add_watch(RGFW_jsInotify, "/dev/input", IN_CREATE | IN_ATTRIB | IN_DELETE) == -1) {
+				close(RGFW_jsInotify);
+				RGFW_jsInotify = -1;
+			}
+		}
+
+		/* returns an RGFW_jsConnected / RGFW_jsDisconnected event if /dev/input changed */
+		RGFW_Event* RGFW_linux_updateHotplug(RGFW_window* win) {
+			if (RGFW_jsInotify == -1)
+				return NULL;
 
-						win->event.axis[e.number / 2].x = xAxis;
-						win->event.axis[e.number / 2].y = yAxis;
-						win->event.type = RGFW_jsAxisMove;
+			if (RGFW_jsHotplugOffset >= RGFW_jsHotplugLen) {
+				RGFW_jsHotplugOffset = 0;
+				RGFW_jsHotplugLen = read(RGFW_jsInotify, RGFW_jsHotplugBuffer, sizeof(RGFW_jsHotplugBuffer));
+			}
+
+			while (RGFW_jsHotplugOffset < RGFW_jsHotplugLen) {
+				struct inotify_event* e = (struct inotify_event*)(RGFW_jsHotplugBuffer + RGFW_jsHotplugOffset);
+				RGFW_jsHotplugOffset += sizeof(struct inotify_event) + e->len;
+
+				if (e->len == 0 || strncmp(e->name, "js", 2) != 0)
+					continue;
+
+				char file[RGFW_MAX_PATH];
+				snprintf(file, sizeof(file), "/dev/input/%s", e->name);
+
+				u16 i;
+				if (e->mask & IN_DELETE) {
+					for (i = 0; i < RGFW_joystickCount; i++) {
+						if (RGFW_joysticks[i] == 0 || strncmp(RGFW_jsFile[i], file, RGFW_MAX_PATH) != 0)
+							continue;
+
+						RGFW_linux_closeJoystick(i);
+						win->event.type = RGFW_jsDisconnected;
 						win->event.joystick = i;
-						RGFW_jsAxisCallback(win, i, win->event.axis, win->event.axisesCount);
 						return &win->event;
+					}
+
+					continue;
+				}
 
-						default: break;
+				u16 count = RGFW_joystickCount;
+				u8 wasOpen = 0;
+				for (i = 0; i < count; i++)
+					wasOpen |= (RGFW_joysticks[i] && strncmp(RGFW_jsFile[i], file, RGFW_MAX_PATH) == 0);
+
+				i32 js = wasOpen ? -1 : RGFW_linux_openJoystick(file);
+				if (js == -1)
+					continue;
+
+				win->event.type = RGFW_jsConnected;
+				win->event.joystick = js;
+				win->event.axisesCount = RGFW_jsAxesCount[js];
+				return &win->event;
+			}
+
+			return NULL;
+		}
+
+		RGFW_Event* RGFW_linux_drainJoysticks(RGFW_window* win) {
+			/* hand out whatever is left from the last inotify read first */
+			if (RGFW_jsHotplugOffset < RGFW_jsHotplugLen) {
+				RGFW_Event* event = RGFW_linux_updateHotplug(win);
+				if (event != NULL)
+					return event;
+			}
+
+			if (RGFW_jsEventIndex >= RGFW_jsEventLen) {
+				RGFW_jsEventIndex = RGFW_jsEventLen = 0;
+
+				/* the devices are asked once per frame, not again for every window event after them */
+				if (win->_jsPolled)
+					return NULL;
+				win->_jsPolled = RGFW_TRUE;
+
+				/* one poll for every device, then only read the ones that have something */
+				struct pollfd fds[5];
+				u8 slots[5];
+				nfds_t count = 0;
+				u16 i;
+
+				for (i = 0; i < RGFW_joystickCount; i++) {
+					if (RGFW_joysticks[i] == 0)
+						continue;
+
+					fds[count] = (struct pollfd){ RGFW_joysticks[i], POLLIN, 0 };
+					slots[count++] = i;
+				}
+
+				if (RGFW_jsInotify != -1)
+					fds[count++] = (struct pollfd){ RGFW_jsInotify, POLLIN, 0 };
+
+				if (count == 0 || poll(fds, count, 0) <= 0)
+					return NULL;
+
+				if (RGFW_jsInotify != -1 && (fds[count - 1].revents & POLLIN)) {
+					RGFW_Event* event = RGFW_linux_updateHotplug(win);
+					if (event != NULL)
+						return event;
+				}
+
+				for (i = 0; i < count; i++) {
+					if (fds[i].fd == RGFW_jsInotify || fds[i].revents == 0)
+						continue;
+
+					u8 js = slots[i];
+					ssize_t bytes = read(RGFW_joysticks[js], &RGFW_jsEvents[RGFW_jsEventLen], 
+												(64 - RGFW_jsEventLen) * sizeof(struct js_event));
+
+					if (bytes == -1 && errno == ENODEV) { /* unplugged, inotify may not have told us yet */
+						RGFW_linux_closeJoystick(js);
+						win->event.type = RGFW_jsDisconnected;
+						win->event.joystick = js;
+						return &win->event;
 					}
+
+					if (bytes <= 0)
+						continue;
+
+					u32 end = RGFW_jsEventLen + (u32)bytes / sizeof(struct js_event);
+					for (; RGFW_jsEventLen < end; RGFW_jsEventLen++)
+						RGFW_jsEventJoystick[RGFW_jsEventLen] = js;
+				}
+			}
+
+			while (RGFW_jsEventIndex < RGFW_jsEventLen) {
+				struct js_event e = RGFW_jsEvents[RGFW_jsEventIndex];
+				u8 i = RGFW_jsEventJoystick[RGFW_jsEventIndex];
+				RGFW_jsEventIndex++;
+
+				/* the driver's synthetic startup state, keep it but don't report it */
+				if (e.type & JS_EVENT_INIT) {
+					if ((e.type & ~JS_EVENT_INIT) == JS_EVENT_BUTTON && e.number < 16)
+						RGFW_jsPressed[i][e.number] = e.value;
+					else if ((e.type & ~JS_EVENT_INIT) == JS_EVENT_AXIS && e.number < 4 && (e.number % 2))
+						RGFW_jsAxis[i][e.number / 2].y = e.value;
+					else if ((e.type & ~JS_EVENT_INIT) == JS_EVENT_AXIS && e.number < 4)
+						RGFW_jsAxis[i][e.number / 2].x = e.value;
+					continue;
+				}
+
+				switch (e.type) {
+				case JS_EVENT_BUTTON:
+					if (e.number >= 16)
+						break;
+
+					win->event.type = e.value ? RGFW_jsButtonPressed : RGFW_jsButtonReleased;
+					win->event.button = e.number;
+					win->event.joystick = i;
+					RGFW_jsPressed[i][e.number] = e.value;
+					RGFW_jsButtonCallback(win, i, e.number, e.value);
+					return &win->event;
+				case JS_EVENT_AXIS:
+					if (e.number >= 4)
+						break;
+
+					if (e.number % 2)
+						RGFW_jsAxis[i][e.number / 2].y = e.value;
+					else
+						RGFW_jsAxis[i][e.number / 2].x = e.value;
+
+					win->event.axis[0] = RGFW_jsAxis[i][0];
+					win->event.axis[1] = RGFW_jsAxis[i][1];
+					win->event.axisesCount = RGFW_jsAxesCount[i];
+					win->event.type = RGFW_jsAxisMove;
+					win->event.joystick = i;
+					RGFW_jsAxisCallback(win, i, win->event.axis, win->event.axisesCount);
+					return &win->event;
+
+					default: break;
 				}
 			}
 
 			return NULL;
 		}
 
+		/* the joystick callbacks run with RGFW_jsLock held, they mustn't register joysticks */
+		RGFW_Event* RGFW_linux_updateJoystick(RGFW_window* win) {
+			pthread_mutex_lock(&RGFW_jsLock);
+			RGFW_Event* event = RGFW_linux_drainJoysticks(win);
+			pthread_mutex_unlock(&RGFW_jsLock);
+			return event;
+		}
+
 	#endif
 #endif
 
@@ -2339,6 +3330,7 @@ Start of Linux / Unix defines
 #include <unistd.h>
 
 #include <X11/XKBlib.h> /* for converting keycode to string */
+#include <poll.h>
 #include <X11/cursorfont.h> /* for hiding */
 #include <X11/extensions/shapeconst.h>
 #include <X11/extensions/shape.h>
@@ -2346,6 +3338,7 @@ Start of Linux / Unix defines
 
 #include <limits.h> /* for data limits (mainly used in drag and drop functions) */
 #include <poll.h>
+#include <pthread.h> /* RGFW_loadAtoms can race between windows made on different threads */
 
 
 #ifdef __linux__
@@ -2353,10 +3346,129 @@ Start of Linux / Unix defines
 #endif
 
 	u8 RGFW_mouseIconSrc[] = { XC_arrow, XC_left_ptr, XC_xterm, XC_crosshair, XC_hand2, XC_sb_h_double_arrow, XC_sb_v_double_arrow, XC_bottom_left_corner, XC_bottom_right_corner, XC_fleur, XC_X_cursor};  
-	/*atoms needed for drag and drop*/
-	Atom XdndAware, XdndTypeList, XdndSelection, XdndEnter, XdndPosition, XdndStatus, XdndLeave, XdndDrop, XdndFinished, XdndActionCopy, XtextPlain, XtextUriList;
+	/*
+		every atom RGFW uses, they're interned together (one XInternAtoms request) the first time a display is opened
+		atoms belong to the server, so the table is shared by every window / display connection
+	*/
+	typedef RGFW_ENUM(u8, RGFW_atomIndex) {
+		RGFW_atom_WM_DELETE_WINDOW,
+		RGFW_atom_WM_STATE,
+		RGFW_atom__MOTIF_WM_HINTS,
+		RGFW_atom__NET_WM_ICON,
+		RGFW_atom__NET_WM_STATE,
+		RGFW_atom__NET_WM_STATE_MAXIMIZED_VERT,
+		RGFW_atom__NET_WM_STATE_MAXIMIZED_HORZ,
+		RGFW_atom_XdndAware,
+		RGFW_atom_XdndTypeList,
+		RGFW_atom_XdndSelection,
+		RGFW_atom_XdndEnter,
+		RGFW_atom_XdndPosition,
+		RGFW_atom_XdndStatus,
+		RGFW_atom_XdndLeave,
+		RGFW_atom_XdndDrop,
+		RGFW_atom_XdndFinished,
+		RGFW_atom_XdndActionCopy,
+		RGFW_atom_text_uri_list,
+		RGFW_atom_text_plain,
+		RGFW_atom_CLIPBOARD,
+		RGFW_atom_UTF8_STRING,
+		RGFW_atom_SAVE_TARGETS,
+		RGFW_atom_TARGETS,
+		RGFW_atom_MULTIPLE,
+		RGFW_atom_ATOM_PAIR,
+		RGFW_atom_CLIPBOARD_MANAGER,
+		RGFW_atom_INCR,
+		RGFW_atom_RGFW_CLIPBOARD,
+		RGFW_atomCount
+	};
+
+	char* RGFW_atomNames[RGFW_atomCount] = {
+		"WM_DELETE_WINDOW",
+		"WM_STATE",
+		"_MOTIF_WM_HINTS",
+		"_NET_WM_ICON",
+		"_NET_WM_STATE",
+		"_NET_WM_STATE_MAXIMIZED_VERT",
+		"_NET_WM_STATE_MAXIMIZED_HORZ",
+		"XdndAware",
+		"XdndTypeList",
+		"XdndSelection",
+		"XdndEnter",
+		"XdndPosition",
+		"XdndStatus",
+		"XdndLeave",
+		"XdndDrop",
+		"XdndFinished",
+		"XdndActionCopy",
+		"text/uri-list",
+		"text/plain",
+		"CLIPBOARD",
+		"UTF8_STRING",
+		"SAVE_TARGETS",
+		"TARGETS",
+		"MULTIPLE",
+		"ATOM_PAIR",
+		"CLIPBOARD_MANAGER",
+		"INCR",
+		"RGFW_CLIPBOARD",
+	};
+
+	Atom RGFW_atoms[RGFW_atomCount];
+	b8 RGFW_atomsLoaded = RGFW_FALSE;
+	pthread_mutex_t RGFW_atomsLock = PTHREAD_MUTEX_INITIALIZER; /* windows can be created on several threads at once */
+
+	#define RGFW_ATOM(name) RGFW_atoms[RGFW_atom_##name]
+
+	void RGFW_loadAtoms(Display* display) {
+		pthread_mutex_lock(&RGFW_atomsLock);
+
+		if (RGFW_atomsLoaded == RGFW_FALSE) {
+			XInternAtoms(display, RGFW_atomNames, RGFW_atomCount, False, RGFW_atoms);
+			RGFW_atomsLoaded = RGFW_TRUE;
+		}
+
+		pthread_mutex_unlock(&RGFW_atomsLock);
+	}
+
+#ifndef RGFW_NO_MONITOR
+	/*
+		the monitor topology, read once and then only again when RandR reports a change
+		(XRRGetScreenResources can make the server re-probe the outputs, which takes tens of ms)
+		the change events are collected while the queue is pumped and applied when it runs dry
+		every window's thread pumps its own queue, so the cache is only touched with RGFW_monitorLock held
+	*/
+	typedef struct RGFW_XMonitorList {
+		u32 count;
+		u32 primary;
+		RGFW_monitor monitors[6];
+	} RGFW_XMonitorList;
+
+	struct {
+		b8 valid, stale;
+		RGFW_XMonitorList list;
+	} RGFW_monitorCache;
+	pthread_mutex_t RGFW_monitorLock = PTHREAD_MUTEX_INITIALIZER;
+
+	i32 RGFW_xrrEventBase = -1;
 
-	Atom wm_delete_window = 0;
+	RGFWDEF void RGFW_XUpdateMonitors(Display* display);
+#endif
+
+	/*atoms needed for drag and drop*/
+	#define XdndAware RGFW_ATOM(XdndAware)
+	#define XdndTypeList RGFW_ATOM(XdndTypeList)
+	#define XdndSelection RGFW_ATOM(XdndSelection)
+	#define XdndEnter RGFW_ATOM(XdndEnter)
+	#define XdndPosition RGFW_ATOM(XdndPosition)
+	#define XdndStatus RGFW_ATOM(XdndStatus)
+	#define XdndLeave RGFW_ATOM(XdndLeave)
+	#define XdndDrop RGFW_ATOM(XdndDrop)
+	#define XdndFinished RGFW_ATOM(XdndFinished)
+	#define XdndActionCopy RGFW_ATOM(XdndActionCopy)
+	#define XtextPlain RGFW_ATOM(text_plain)
+	#define XtextUriList RGFW_ATOM(text_uri_list)
+
+	#define wm_delete_window RGFW_ATOM(WM_DELETE_WINDOW)
 
 #if !defined(RGFW_NO_X11_CURSOR) && !defined(RGFW_NO_X11_CURSOR_PRELOAD)
 	typedef XcursorImage* (*PFN_XcursorImageCreate)(int, int);
@@ -2372,6 +3484,10 @@ Start of Linux / Unix defines
 	PFN_XISelectEvents XISelectEventsSrc = NULL;
 	#define XISelectEvents XISelectEventsSrc
 
+	typedef Status (* PFN_XIQueryVersion)(Display*,int*,int*);
+	PFN_XIQueryVersion XIQueryVersionSrc = NULL;
+	#define XIQueryVersion XIQueryVersionSrc
+
 	void* X11Xihandle = NULL;
 #endif
 
@@ -2387,6 +3503,146 @@ Start of Linux / Unix defines
 	void* X11Cursorhandle = NULL;
 #endif
 
+#ifdef RGFW_X11_SHM
+	#include <sys/ipc.h>
+	#include <sys/shm.h>
+
+	#ifndef RGFW_NO_X11_SHM_PRELOAD
+	typedef Bool (* PFN_XShmQueryExtension)(Display*);
+	typedef XImage* (* PFN_XShmCreateImage)(Display*, Visual*, unsigned int, int, char*, XShmSegmentInfo*, unsigned int, unsigned int);
+	typedef Bool (* PFN_XShmAttach)(Display*, XShmSegmentInfo*);
+	typedef Bool (* PFN_XShmDetach)(Display*, XShmSegmentInfo*);
+	typedef Bool (* PFN_XShmPutImage)(Display*, Drawable, GC, XImage*, int, int, int, int, unsigned int, unsigned int, Bool);
+	typedef int (* PFN_XShmGetEventBase)(Display*);
+
+	PFN_XShmQueryExtension XShmQueryExtensionSrc = NULL;
+	PFN_XShmCreateImage XShmCreateImageSrc = NULL;
+	PFN_XShmAttach XShmAttachSrc = NULL;
+	PFN_XShmDetach XShmDetachSrc = NULL;
+	PFN_XShmPutImage XShmPutImageSrc = NULL;
+	PFN_XShmGetEventBase XShmGetEventBaseSrc = NULL;
+
+	#define XShmQueryExtension XShmQueryExtensionSrc
+	#define XShmCreateImage XShmCreateImageSrc
+	#define XShmAttach XShmAttachSrc
+	#define XShmDetach XShmDetachSrc
+	#define XShmPutImage XShmPutImageSrc
+	#define XShmGetEventBase XShmGetEventBaseSrc
+
+	void* X11Xexthandle = NULL;
+	#endif
+
+	b8 RGFW_shmError = RGFW_FALSE;
+	int RGFW_shmErrorHandler(Display* display, XErrorEvent* ev) {
+		RGFW_UNUSED(display); RGFW_UNUSED(ev);
+		RGFW_shmError = RGFW_TRUE;
+		return 0;
+	}
+
+	RGFWDEF b8 RGFW_window_initShmSegment(RGFW_window* win, XVisualInfo* vi, u8 i);
+	RGFWDEF void RGFW_window_freeShmSegment(RGFW_window* win, u8 i);
+	RGFWDEF b8 RGFW_window_initShm(RGFW_window* win, XVisualInfo* vi);
+	RGFWDEF void RGFW_window_shmCompleted(RGFW_window* win, XEvent* E); /*!< counts an XShmCompletionEvent against its segment */
+
+	/* one buffer sized segment and the XImage over it, returns false if the server can't attach it */
+	b8 RGFW_window_initShmSegment(RGFW_window* win, XVisualInfo* vi, u8 i) {
+		XShmSegmentInfo* shm = &win->src.shm[i];
+		shm->shmaddr = NULL;
+
+		XImage* image = XShmCreateImage(
+			win->src.display, XDefaultVisual(win->src.display, vi->screen),
+			vi->depth, ZPixmap, NULL, shm, RGFW_bufferSize.w, RGFW_bufferSize.h
+		);
+
+		if (image == NULL)
+			return RGFW_FALSE;
+
+		/* RGFW_BUFFER is tightly packed 4 byte pixels */
+		if (image->bytes_per_line != (i32)(RGFW_bufferSize.w * 4)) {
+			XDestroyImage(image);
+			return RGFW_FALSE;
+		}
+
+		shm->shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height, IPC_CREAT | 0600);
+		if (shm->shmid == -1) {
+			XDestroyImage(image);
+			return RGFW_FALSE;
+		}
+
+		shm->shmaddr = image->data = (char*) shmat(shm->shmid, NULL, 0);
+		shm->readOnly = False;
+
+		/* attaching fails with an async X error (not a return value) if the server can't see the segment */
+		RGFW_shmError = RGFW_FALSE;
+		int (*prevHandler)(Display*, XErrorEvent*) = XSetErrorHandler(RGFW_shmErrorHandler);
+
+		if (shm->shmaddr != (char*) -1)
+			XShmAttach((Display*) win->src.display, shm);
+		XSync((Display*) win->src.display, False);
+
+		XSetErrorHandler(prevHandler);
+
+		/* the segment is freed once both the server and RGFW detach from it */
+		shmctl(shm->shmid, IPC_RMID, NULL);
+
+		if (shm->shmaddr == (char*) -1 || RGFW_shmError) {
+			if (shm->shmaddr != (char*) -1)
+				shmdt(shm->shmaddr);
+
+			image->data = NULL;
+			XDestroyImage(image);
+			shm->shmaddr = NULL;
+			return RGFW_FALSE;
+		}
+
+		win->src.shmBitmap[i] = image;
+		win->src.shmPending[i] = 0;
+		return RGFW_TRUE;
+	}
+
+	void RGFW_window_freeShmSegment(RGFW_window* win, u8 i) {
+		XShmDetach(win->src.display, &win->src.shm[i]);
+		win->src.shmBitmap[i]->data = NULL; /* not malloc'd, don't let XDestroyImage free it */
+		XDestroyImage(win->src.shmBitmap[i]);
+		shmdt(win->src.shm[i].shmaddr);
+		win->src.shm[i].shmaddr = NULL;
+	}
+
+	/* 
+		create the window buffer in shared memory segments so XShmPutImage can present it without copying it through the socket,
+		two of them so the next frame is drawn into one while the server is still reading the other
+		returns false if the server can't do it (no MIT-SHM, remote display...), the caller falls back to XPutImage
+	*/
+	b8 RGFW_window_initShm(RGFW_window* win, XVisualInfo* vi) {
+		win->src.shm[0].shmaddr = win->src.shm[1].shmaddr = NULL;
+
+		#ifndef RGFW_NO_X11_SHM_PRELOAD
+		if (XShmQueryExtensionSrc == NULL || XShmCreateImageSrc == NULL || XShmAttachSrc == NULL || XShmDetachSrc == NULL || 
+			XShmPutImageSrc == NULL || XShmGetEventBaseSrc == NULL)
+			return RGFW_FALSE;
+		#endif
+
+		if (XShmQueryExtension((Display*) win->src.display) == False)
+			return RGFW_FALSE;
+
+		if (RGFW_window_initShmSegment(win, vi, 0) == RGFW_FALSE)
+			return RGFW_FALSE;
+
+		if (RGFW_window_initShmSegment(win, vi, 1) == RGFW_FALSE) {
+			RGFW_window_freeShmSegment(win, 0);
+			return RGFW_FALSE;
+		}
+
+		win->src.shmCompletion = XShmGetEventBase((Display*) win->src.display) + ShmCompletion;
+		win->src.shmCurrent = 0;
+		win->src.shmDrawn = 0;
+		win->src.shmStale = RGFW_FALSE;
+		win->src.bitmap = win->src.shmBitmap[0];
+		win->buffer = (u8*) win->src.shm[0].shmaddr;
+		return RGFW_TRUE;
+	}
+#endif
+
 	u32 RGFW_windowsOpen = 0;
 
 #ifdef RGFW_OPENGL
@@ -2399,20 +3655,25 @@ Start of Linux / Unix defines
 		if (RGFW_bufferSize.w == 0 && RGFW_bufferSize.h == 0)
 			RGFW_bufferSize = RGFW_getScreenSize();
 		
-		win->buffer = (u8*)RGFW_MALLOC(RGFW_bufferSize.w * RGFW_bufferSize.h * 4);
+		#ifdef RGFW_X11_SHM
+		if (RGFW_window_initShm(win, vi) == RGFW_FALSE)
+		#endif
+		{
+			win->buffer = (u8*)RGFW_MALLOC(RGFW_bufferSize.w * RGFW_bufferSize.h * 4);
+
+			win->src.bitmap = XCreateImage(
+				win->src.display, XDefaultVisual(win->src.display, vi->screen),
+				vi->depth,
+				ZPixmap, 0, (char*) win->buffer, RGFW_bufferSize.w, RGFW_bufferSize.h,
+				32, 0
+			);
+		}
 
 		#ifdef RGFW_OSMESA
 				win->src.ctx = OSMesaCreateContext(OSMESA_RGBA, NULL);
 				OSMesaMakeCurrent(win->src.ctx, win->buffer, GL_UNSIGNED_BYTE, win->r.w, win->r.h);
 		#endif
 
-		win->src.bitmap = XCreateImage(
-			win->src.display, XDefaultVisual(win->src.display, vi->screen),
-			vi->depth,
-			ZPixmap, 0, NULL, RGFW_bufferSize.w, RGFW_bufferSize.h,
-			32, 0
-		);
-
 		win->src.gc = XCreateGC(win->src.display, win->src.window, 0, NULL);
 
 		#else
@@ -2424,9 +3685,7 @@ Start of Linux / Unix defines
 
 
 	void RGFW_window_setBorder(RGFW_window* win, u8 border) {
-		static Atom _MOTIF_WM_HINTS = 0;
-		if (_MOTIF_WM_HINTS == 0 )
-			_MOTIF_WM_HINTS = XInternAtom(win->src.display, "_MOTIF_WM_HINTS", False);
+		Atom _MOTIF_WM_HINTS = RGFW_ATOM(_MOTIF_WM_HINTS);
 		
 		struct __x11WindowHints {
 			unsigned long flags, functions, decorations, status;
@@ -2500,6 +3759,28 @@ Start of Linux / Unix defines
 #endif
 
 			XISelectEventsSrc = (PFN_XISelectEvents) dlsym(X11Xihandle, "XISelectEvents");
+			XIQueryVersionSrc = (PFN_XIQueryVersion) dlsym(X11Xihandle, "XIQueryVersion");
+		}
+#endif
+
+#if defined(RGFW_X11_SHM) && !defined(RGFW_NO_X11_SHM_PRELOAD)
+		if (X11Xexthandle == NULL) {
+#if defined(__CYGWIN__)
+			X11Xexthandle = dlopen("libXext-6.so", RTLD_LAZY | RTLD_LOCAL);
+#elif defined(__OpenBSD__) || defined(__NetBSD__)
+			X11Xexthandle = dlopen("libXext.so", RTLD_LAZY | RTLD_LOCAL);
+#else
+			X11Xexthandle = dlopen("libXext.so.6", RTLD_LAZY | RTLD_LOCAL);
+#endif
+
+			if (X11Xexthandle != NULL) {
+				XShmQueryExtensionSrc = (PFN_XShmQueryExtension) dlsym(X11Xexthandle, "XShmQueryExtension");
+				XShmCreateImageSrc = (PFN_XShmCreateImage) dlsym(X11Xexthandle, "XShmCreateImage");
+				XShmAttachSrc = (PFN_XShmAttach) dlsym(X11Xexthandle, "XShmAttach");
+				XShmDetachSrc = (PFN_XShmDetach) dlsym(X11Xexthandle, "XShmDetach");
+				XShmPutImageSrc = (PFN_XShmPutImage) dlsym(X11Xexthandle, "XShmPutImage");
+				XShmGetEventBaseSrc = (PFN_XShmGetEventBase) dlsym(X11Xexthandle, "XShmGetEventBase");
+			}
 		}
 #endif
 
@@ -2510,7 +3791,7 @@ Start of Linux / Unix defines
 
 		RGFW_window* win = RGFW_window_basic_init(rect, args);
 
-		u64 event_mask = KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask | StructureNotifyMask | FocusChangeMask | LeaveWindowMask | EnterWindowMask | ExposureMask; /*!< X11 events accepted*/
+		u64 event_mask = KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask | StructureNotifyMask | FocusChangeMask | LeaveWindowMask | EnterWindowMask | ExposureMask | PropertyChangeMask; /*!< X11 events accepted*/
 
 #ifdef RGFW_OPENGL
 		u32* visual_attribs = RGFW_initFormatAttribs(args & RGFW_OPENGL_SOFTWARE);
@@ -2584,6 +3865,9 @@ Start of Linux / Unix defines
 
 		XFreeColors((Display*) win->src.display, cmap, NULL, 0, 0);
 
+		win->src.clipboard = NULL;
+		win->src.clipboardIncr = RGFW_FALSE;
+
 		#ifdef RGFW_OPENGL
 		XFree(vi);
 		#endif
@@ -2663,9 +3947,6 @@ Start of Linux / Unix defines
 		XSelectInput((Display*) win->src.display, (Drawable) win->src.window, event_mask); /*!< tell X11 what events we want*/
 
 		/* make it so the user can't close the window until the program does*/
-		if (wm_delete_window == 0)
-			wm_delete_window = XInternAtom((Display*) win->src.display, "WM_DELETE_WINDOW", False);
-
 		XSetWMProtocols((Display*) win->src.display, (Drawable) win->src.window, &wm_delete_window, 1);
 
 		/* connect the context to the window*/
@@ -2683,24 +3964,6 @@ Start of Linux / Unix defines
 		if (args & RGFW_ALLOW_DND) { /* init drag and drop atoms and turn on drag and drop for this window */
 			win->_winArgs |= RGFW_ALLOW_DND;
 
-			XdndTypeList = XInternAtom((Display*) win->src.display, "XdndTypeList", False);
-			XdndSelection = XInternAtom((Display*) win->src.display, "XdndSelection", False);
-
-			/* client messages */
-			XdndEnter = XInternAtom((Display*) win->src.display, "XdndEnter", False);
-			XdndPosition = XInternAtom((Display*) win->src.display, "XdndPosition", False);
-			XdndStatus = XInternAtom((Display*) win->src.display, "XdndStatus", False);
-			XdndLeave = XInternAtom((Display*) win->src.display, "XdndLeave", False);
-			XdndDrop = XInternAtom((Display*) win->src.display, "XdndDrop", False);
-			XdndFinished = XInternAtom((Display*) win->src.display, "XdndFinished", False);
-
-			/* actions */
-			XdndActionCopy = XInternAtom((Display*) win->src.display, "XdndActionCopy", False);
-
-			XtextUriList = XInternAtom((Display*) win->src.display, "text/uri-list", False); 
-			XtextPlain = XInternAtom((Display*) win->src.display, "text/plain", False);
-
-			XdndAware = XInternAtom((Display*) win->src.display, "XdndAware", False);
 			const u8 version = 5;
 
 			XChangeProperty((Display*) win->src.display, (Window) win->src.window,
@@ -2714,6 +3977,11 @@ Start of Linux / Unix defines
 		#endif
 
 		RGFW_window_setMouseDefault(win);
+		RGFW_window_initWake(win);
+
+		#ifdef __linux__
+		RGFW_linux_initJoystickHotplug();
+		#endif
 
 		RGFW_windowsOpen++;
 
@@ -2755,6 +4023,120 @@ Start of Linux / Unix defines
 
 	int xAxis = 0, yAxis = 0;
 
+	#ifndef RGFW_CLIPBOARD_TIMEOUT
+	#define RGFW_CLIPBOARD_TIMEOUT 5000 /* ms RGFW_readClipboard waits on a silent clipboard owner */
+	#endif
+
+	b8 RGFW_window_readClipboardAsync(RGFW_window* win, RGFW_clipboardRequest* req) {
+		assert(win != NULL && req != NULL);
+
+		if (win->src.clipboard != NULL)
+			return RGFW_FALSE;
+
+		RGFW_clipboardRequest_begin(req);
+
+		/* nobody to ask, (or it's us, and the text isn't kept after RGFW_writeClipboard) */
+		Window owner = XGetSelectionOwner(win->src.display, RGFW_ATOM(CLIPBOARD));
+		if (owner == None || owner == win->src.window) {
+			RGFW_clipboardRequest_finish(req, RGFW_clipboardFailed);
+			return RGFW_TRUE;
+		}
+
+		win->src.clipboard = req;
+		win->src.clipboardIncr = RGFW_FALSE;
+		win->src.clipboardTime = RGFW_getTimeNS();
+
+		XDeleteProperty(win->src.display, win->src.window, RGFW_ATOM(RGFW_CLIPBOARD));
+		/* the owner puts the data in our RGFW_CLIPBOARD property */
+		XConvertSelection(win->src.display, RGFW_ATOM(CLIPBOARD), RGFW_ATOM(UTF8_STRING), RGFW_ATOM(RGFW_CLIPBOARD), win->src.window, CurrentTime);
+		XFlush(win->src.display);
+		return RGFW_TRUE;
+	}
+
+	RGFWDEF Bool RGFW_isClipboardEvent(Display* display, XEvent* E, XPointer arg);
+
+	/* XIfEvent predicate, true for events that belong to win's clipboard request */
+	Bool RGFW_isClipboardEvent(Display* display, XEvent* E, XPointer arg) {
+		RGFW_window* win = (RGFW_window*) arg;
+		RGFW_UNUSED(display);
+
+		if (win->src.clipboard == NULL)
+			return False;
+
+		if (E->type == SelectionNotify)
+			return E->xselection.requestor == win->src.window && E->xselection.selection == RGFW_ATOM(CLIPBOARD);
+
+		return E->type == PropertyNotify && win->src.clipboardIncr &&
+				E->xproperty.window == win->src.window && E->xproperty.atom == RGFW_ATOM(RGFW_CLIPBOARD) &&
+				E->xproperty.state == PropertyNewValue;
+	}
+
+	RGFWDEF b8 RGFW_window_handleClipboardEvent(RGFW_window* win, XEvent* E);
+
+	/* feeds an event to win's clipboard request, returns true if that finished it */
+	b8 RGFW_window_handleClipboardEvent(RGFW_window* win, XEvent* E) {
+		if (RGFW_isClipboardEvent(win->src.display, E, (XPointer) win) == False)
+			return RGFW_FALSE;
+
+		RGFW_clipboardRequest* req = win->src.clipboard;
+		win->src.clipboardTime = RGFW_getTimeNS();
+
+		if (E->type == SelectionNotify && E->xselection.property == None) {
+			win->src.clipboard = NULL;
+			RGFW_clipboardRequest_finish(req, RGFW_clipboardFailed);
+			return RGFW_TRUE;
+		}
+
+		Atom type;
+		int format;
+		unsigned long count, bytesAfter;
+		u8* data = NULL;
+
+		/* deleting the property as it's read is also what tells an INCR owner to send the next chunk */
+		XGetWindowProperty(win->src.display, win->src.window, RGFW_ATOM(RGFW_CLIPBOARD), 0, LONG_MAX, True, AnyPropertyType,
+							&type, &format, &count, &bytesAfter, &data);
+
+		if (E->type == SelectionNotify && type == RGFW_ATOM(INCR)) {
+			win->src.clipboardIncr = RGFW_TRUE;
+			if (data != NULL)
+				XFree(data);
+			XFlush(win->src.display);
+			return RGFW_FALSE;
+		}
+
+		if (data != NULL && count) 
+			RGFW_clipboardRequest_append(req, (char*) data, count * (format / 8));
+		
+		if (data != NULL)
+			XFree(data);
+
+		/* a zero length chunk ends an INCR transfer */
+		if (win->src.clipboardIncr && count != 0) {
+			XFlush(win->src.display);
+			return RGFW_FALSE;
+		}
+
+		win->src.clipboard = NULL;
+		win->src.clipboardIncr = RGFW_FALSE;
+		RGFW_clipboardRequest_finish(req, (type == None) ? RGFW_clipboardFailed : RGFW_clipboardDone);
+		return RGFW_TRUE;
+	}
+
+	RGFWDEF b8 RGFW_window_clipboardTimedOut(RGFW_window* win);
+
+	/* fails win's clipboard request if the owner has been silent for RGFW_CLIPBOARD_TIMEOUT, returns true if it did */
+	b8 RGFW_window_clipboardTimedOut(RGFW_window* win) {
+		if (win->src.clipboard == NULL || 
+			(RGFW_getTimeNS() - win->src.clipboardTime) / 1000000 < RGFW_CLIPBOARD_TIMEOUT)
+			return RGFW_FALSE;
+
+		RGFW_clipboardRequest* req = win->src.clipboard;
+		win->src.clipboard = NULL;
+		win->src.clipboardIncr = RGFW_FALSE;
+		RGFW_clipboardRequest_finish(req, RGFW_clipboardFailed);
+		return RGFW_TRUE;
+	}
+
 	RGFW_Event* RGFW_window_checkEvent(RGFW_window* win) {
 		assert(win != NULL);
 
@@ -2763,8 +4145,12 @@ Start of Linux / Unix defines
 			i32 format;
 		} xdnd;
 
-		if (win->event.type == 0) 
-			RGFW_resetKey();
+		/* once per batch, events RGFW ignores mid-batch mustn't clear what the batch pressed */
+		if (win->_queueEmptied) {
+			RGFW_window_resetKeys(win);
+			win->_queueEmptied = RGFW_FALSE;
+			win->_jsPolled = RGFW_FALSE;
+		}
 
 		if (win->event.type == RGFW_quit) {
 			return NULL;
@@ -2788,12 +4174,28 @@ Start of Linux / Unix defines
 		)
 			XNextEvent((Display*) win->src.display, &E);
 		else {
+			#ifndef RGFW_NO_MONITOR
+			/* a topology change comes as a burst of events, apply them in one go */
+			pthread_mutex_lock(&RGFW_monitorLock);
+			b8 stale = RGFW_monitorCache.stale;
+			pthread_mutex_unlock(&RGFW_monitorLock);
+
+			if (stale)
+				RGFW_XUpdateMonitors(win->src.display);
+			#endif
+
+			/* the owner went away without answering, (or stopped halfway through an INCR transfer) */
+			if (RGFW_window_clipboardTimedOut(win)) {
+				win->event.type = RGFW_clipboardReady;
+				return &win->event;
+			}
+
+			win->_queueEmptied = RGFW_TRUE;
 			return NULL;
 		}
 
-		u32 i;
 		win->event.type = 0;
-
+		win->_hasRawMotion = RGFW_FALSE;
 
 		switch (E.type) {
 		case KeyPress:
@@ -2818,8 +4220,6 @@ Start of Linux / Unix defines
 
 			win->event.keyName[15] = '\0';		
 
-			RGFW_keyboard[win->event.keyCode].prev = RGFW_isPressed(win, win->event.keyCode);
-			
 			/* get keystate data */
 			win->event.type = (E.type == KeyPress) ? RGFW_keyPressed : RGFW_keyReleased;
 
@@ -2827,13 +4227,14 @@ Start of Linux / Unix defines
 			XGetKeyboardControl((Display*) win->src.display, &keystate);
 
 			RGFW_updateLockState(win, (keystate.led_mask & 1), (keystate.led_mask & 2));
-			RGFW_keyboard[win->event.keyCode].current = (E.type == KeyPress);
+			RGFW_window_setKey(win, (u8)win->event.keyCode, (E.type == KeyPress));
 			RGFW_keyCallback(win, win->event.keyCode, win->event.keyName, win->event.lockState, (E.type == KeyPress));
 			break;
 		}
 		case ButtonPress:
 		case ButtonRelease:
 			win->event.type = RGFW_mouseButtonPressed + (E.type == ButtonRelease); // the events match 
+			win->event.button = E.xbutton.button;
 			
 			switch(win->event.button) {
 				case RGFW_mouseScrollUp:
@@ -2845,13 +4246,10 @@ Start of Linux / Unix defines
 				default: break;
 			}
 
-			win->event.button = E.xbutton.button;
-			RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-
 			if (win->event.repeat == RGFW_FALSE)
 				win->event.repeat = RGFW_isPressed(win, win->event.keyCode);
 
-			RGFW_mouseButtons[win->event.button].current = (E.type == ButtonPress);
+			RGFW_window_setMouseButton(win, win->event.button, (E.type == ButtonPress));
 			RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, (E.type == ButtonPress));
 			break;
 
@@ -2873,14 +4271,27 @@ Start of Linux / Unix defines
 			break;
 
 		case GenericEvent: {
-			/* MotionNotify is used for mouse events if the mouse isn't held */                
-			if (!(win->_winArgs & RGFW_HOLD_MOUSE)) {
-            	XFreeEventData(win->src.display, &E.xcookie);
+            if (XGetEventData(win->src.display, &E.xcookie) == False)
 				break;
+
+			/* XI_Motion is only selected in raw mouse mode, it's ignored while the mouse is held so the raw deltas are used instead */
+			if (E.xcookie.evtype == XI_Motion && !(win->_winArgs & RGFW_HOLD_MOUSE)) {
+				XIDeviceEvent* dev = (XIDeviceEvent*)E.xcookie.data;
+
+				win->_rawMotion.x = dev->event_x;
+				win->_rawMotion.y = dev->event_y;
+				win->_rawMotion.time = (u64)dev->time;
+				win->_hasRawMotion = RGFW_TRUE;
+
+				win->event.point = RGFW_POINT(dev->event_x, dev->event_y);
+				win->_lastMousePoint = win->event.point;
+
+				win->event.type = RGFW_mousePosChanged;
+				RGFW_mousePosCallback(win, win->event.point);
 			}
-			
-            XGetEventData(win->src.display, &E.xcookie);
-            if (E.xcookie.evtype == XI_RawMotion) {
+
+			/* MotionNotify (or XI_Motion) is used for mouse events if the mouse isn't held */                
+            if (E.xcookie.evtype == XI_RawMotion && (win->_winArgs & RGFW_HOLD_MOUSE)) {
 				XIRawEvent *raw = (XIRawEvent *)E.xcookie.data;
 				if (raw->valuators.mask_len == 0) {
 					XFreeEventData(win->src.display, &E.xcookie);
@@ -2897,6 +4308,11 @@ Start of Linux / Unix defines
 					deltaY += raw->raw_values[1];
 
 				win->event.point = RGFW_POINT((i32)deltaX, (i32)deltaY);
+
+				win->_rawMotion.x = deltaX;
+				win->_rawMotion.y = deltaY;
+				win->_rawMotion.time = (u64)raw->time;
+				win->_hasRawMotion = RGFW_TRUE;
 				
 				RGFW_window_moveMouse(win, RGFW_POINT(win->r.x + (win->r.w / 2), win->r.y + (win->r.h / 2)));
 
@@ -2922,11 +4338,6 @@ Start of Linux / Unix defines
 			}
 			
 			/* reset DND values */
-			if (win->event.droppedFilesCount) {
-				for (i = 0; i < win->event.droppedFilesCount; i++)
-					win->event.droppedFiles[i][0] = '\0';
-			}
-
 			win->event.droppedFilesCount = 0;
 
 			if ((win->_winArgs & RGFW_ALLOW_DND) == 0)
@@ -3060,7 +4471,17 @@ Start of Linux / Unix defines
 
 			RGFW_dndInitCallback(win, win->event.point);
 			break;
+		case PropertyNotify:
+			if (RGFW_window_handleClipboardEvent(win, &E))
+				win->event.type = RGFW_clipboardReady;
+			break;
 		case SelectionNotify: {
+			if (RGFW_isClipboardEvent(win->src.display, &E, (XPointer) win)) {
+				if (RGFW_window_handleClipboardEvent(win, &E))
+					win->event.type = RGFW_clipboardReady;
+				break;
+			}
+
 			/* this is only for checking for xdnd drops */
 			if (E.xselection.property != XdndSelection || !(win->_winArgs | RGFW_ALLOW_DND))
 				break;
@@ -3085,18 +4506,20 @@ Start of Linux / Unix defines
 
 			const char* prefix = (const char*)"file://";
 
-			char* line;
+			char* cursor = data;
 
-			win->event.droppedFilesCount = 0;
+			RGFW_window_beginDrop(win);
 
 			win->event.type = RGFW_dnd;
 
-			while ((line = strtok(data, "\r\n"))) {
-				char path[RGFW_MAX_PATH];
+			while (*cursor) {
+				/* split the uri list by hand, strtok isn't thread safe and would lose data for XFree */
+				char* line = cursor;
+				cursor += strcspn(cursor, "\r\n");
+				while (*cursor == '\r' || *cursor == '\n')
+					*(cursor++) = '\0';
 
-				data = NULL;
-
-				if (line[0] == '#')
+				if (line[0] == '#' || line[0] == '\0')
 					continue;
 
 				char* l;
@@ -3114,8 +4537,8 @@ Start of Linux / Unix defines
 						break;
 				}
 
-				win->event.droppedFilesCount++;
-
+				/* decode the %XX escapes in place, the result is never longer than the uri */
+				char* path = line;
 				size_t index = 0;
 				while (*line) {
 					if (line[0] == '%' && line[1] && line[2]) {
@@ -3128,10 +4551,12 @@ Start of Linux / Unix defines
 					index++;
 					line++;
 				}
-				path[index] = '\0';
-				strncpy(win->event.droppedFiles[win->event.droppedFilesCount - 1], path, index + 1);
+
+				RGFW_window_addDrop(win, path, index);
 			}
 
+			RGFW_window_endDrop(win);
+
 			if (data)
 				XFree(data);
 
@@ -3194,6 +4619,19 @@ Start of Linux / Unix defines
 				break;
 		}
 		default: {
+			#ifndef RGFW_NO_MONITOR
+			if (RGFW_xrrEventBase >= 0 &&
+				(E.type == RGFW_xrrEventBase + RRScreenChangeNotify || E.type == RGFW_xrrEventBase + RRNotify)) {
+				XRRUpdateConfiguration(&E); /* keeps the Screen's size, used by RGFW_getScreenSize, current */
+				pthread_mutex_lock(&RGFW_monitorLock);
+				RGFW_monitorCache.stale = RGFW_TRUE;
+				pthread_mutex_unlock(&RGFW_monitorLock);
+			}
+			#endif
+			#ifdef RGFW_X11_SHM
+			if (win->src.shm[0].shmaddr != NULL && E.type == win->src.shmCompletion)
+				RGFW_window_shmCompleted(win, &E);
+			#endif
 			break;
 		}
 		}
@@ -3206,6 +4644,68 @@ Start of Linux / Unix defines
 			return NULL;
 	}
 
+	void RGFW_window_setRawMouse(RGFW_window* win, b8 raw) {
+		assert(win != NULL);
+
+		if (XISelectEvents == NULL || XIQueryVersion == NULL)
+			return;
+
+		/* the server only takes XI2 requests once the client says which version it speaks */
+		static i32 supported = -1;
+		if (supported == -1) {
+			int major = 2, minor = 0;
+			supported = (XIQueryVersion(win->src.display, &major, &minor) == Success);
+		}
+
+		if (!supported)
+			return;
+
+		unsigned char mask[XIMaskLen(XI_Motion)] = { 0 };
+		if (raw)
+			XISetMask(mask, XI_Motion);
+
+		XIEventMask em;
+		em.deviceid = XIAllMasterDevices;
+		em.mask_len = sizeof(mask);
+		em.mask = mask;
+
+		/* selecting XI_Motion replaces the window's core MotionNotify events */
+		XISelectEvents(win->src.display, win->src.window, &em, 1);
+
+		if (raw)
+			win->_winArgs |= RGFW_RAW_MOUSE;
+		else
+			win->_winArgs &= ~(u32)RGFW_RAW_MOUSE;
+	}
+
+	u32 RGFW_window_drainEvents(RGFW_window* win, RGFW_Event* events, u32 maxEvents) {
+		assert(win != NULL);
+
+		u32 count = 0;
+		win->motionSampleCount = 0;
+
+		/* a drain is a frame, even if the last one stopped on an ignored event with the queue already empty */
+		RGFW_window_resetKeys(win);
+		win->_queueEmptied = RGFW_FALSE;
+		win->_jsPolled = RGFW_FALSE;
+
+		while (count < maxEvents) {
+			if (RGFW_window_checkEvent(win) != NULL) {
+				RGFW_window_pushDrainedEvent(win, events, &count);
+				continue;
+			}
+
+			/* 
+				checkEvent also returns NULL for X events RGFW ignores, 
+				so only stop once Xlib's queue is really empty (checkEvent already read the socket)
+			*/
+			if (win->event.type == RGFW_quit || QLength((Display*) win->src.display) == 0)
+				break;
+		}
+
+		return count;
+	}
+
 	void RGFW_window_move(RGFW_window* win, RGFW_point v) {
 		assert(win != NULL);
 		win->r.x = v.x;
@@ -3351,9 +4851,7 @@ Start of Linux / Unix defines
 				((icon[i * 4 + 3]) << 24);
 		}
 
-		static Atom NET_WM_ICON = 0;
-		if (NET_WM_ICON == 0)
-			NET_WM_ICON = XInternAtom((Display*) win->src.display, "_NET_WM_ICON", False);
+		Atom NET_WM_ICON = RGFW_ATOM(_NET_WM_ICON);
 
 		XChangeProperty((Display*) win->src.display, (Window) win->src.window,
 			NET_WM_ICON,
@@ -3447,69 +4945,59 @@ Start of Linux / Unix defines
 		the majority function is sourced from GLFW
 	*/
 	char* RGFW_readClipboard(size_t* size) {
-		static Atom UTF8 = 0;
-		if (UTF8 == 0)
-			UTF8 = XInternAtom(RGFW_root->src.display, "UTF8_STRING", True);
+		RGFW_clipboardRequest req;
+		req.data = NULL;
 
-		XEvent event;
-		int format;
-		unsigned long N, sizeN;
-		char* data, * s = NULL;
-		Atom target;
-		Atom CLIPBOARD = 0, XSEL_DATA = 0;
-
-		if (CLIPBOARD == 0) {
-			CLIPBOARD = XInternAtom(RGFW_root->src.display, "CLIPBOARD", 0);
-			XSEL_DATA = XInternAtom(RGFW_root->src.display, "XSEL_DATA", 0);
-		}
-
-		XConvertSelection(RGFW_root->src.display, CLIPBOARD, UTF8, XSEL_DATA, RGFW_root->src.window, CurrentTime);
-		XSync(RGFW_root->src.display, 0);
-		XNextEvent(RGFW_root->src.display, &event);
-
-		if (event.type != SelectionNotify || event.xselection.selection != CLIPBOARD || event.xselection.property == 0)
+		if (RGFW_window_readClipboardAsync(RGFW_root, &req) == RGFW_FALSE)
 			return NULL;
 
-		XGetWindowProperty(event.xselection.display, event.xselection.requestor,
-			event.xselection.property, 0L, (~0L), 0, AnyPropertyType, &target,
-			&format, &sizeN, &N, (unsigned char**) &data);
+		/* 
+			only take the events for this request off the queue, the rest are left for checkEvent
+			give up if the owner goes quiet for too long
+		*/
+		u64 lastProgress = RGFW_getTimeNS();
+		while (req.status == RGFW_clipboardPending) {
+			XEvent event;
+			if (XCheckIfEvent(RGFW_root->src.display, &event, RGFW_isClipboardEvent, (XPointer) RGFW_root)) {
+				RGFW_window_handleClipboardEvent(RGFW_root, &event);
+				lastProgress = RGFW_getTimeNS();
+				continue;
+			}
 
-		if (target == UTF8 || target == XA_STRING) {
-			s = (char*)RGFW_MALLOC(sizeof(char) * sizeN);
-			strncpy(s, data, sizeN);
-			s[sizeN] = '\0';
-			XFree(data);
+			i32 waited = (i32)((RGFW_getTimeNS() - lastProgress) / 1000000);
+			if (waited >= RGFW_CLIPBOARD_TIMEOUT) {
+				RGFW_root->src.clipboard = NULL;
+				RGFW_clipboardRequest_finish(&req, RGFW_clipboardFailed);
+				break;
+			}
+
+			struct pollfd fd = { ConnectionNumber(RGFW_root->src.display), POLLIN, 0 };
+			poll(&fd, 1, RGFW_CLIPBOARD_TIMEOUT - waited);
 		}
 
-		XDeleteProperty(event.xselection.display, event.xselection.requestor, event.xselection.property);
+		if (req.status != RGFW_clipboardDone) {
+			if (req.data != NULL)
+				RGFW_clipboardFree(req.data);
+			return NULL;
+		}
 
-		if (s != NULL && size != NULL)
-			*size = sizeN;
+		if (size != NULL)
+			*size = req.size;
 
-		return s;
+		return req.data;
 	}
 
 	/*
 		almost all of this function is sourced from GLFW
 	*/
 	void RGFW_writeClipboard(const char* text, u32 textLen) {
-		static Atom CLIPBOARD = 0,
-			UTF8_STRING = 0,
-			SAVE_TARGETS = 0,
-			TARGETS = 0,
-			MULTIPLE = 0,
-			ATOM_PAIR = 0,
-			CLIPBOARD_MANAGER = 0;
-
-		if (CLIPBOARD == 0) {
-			CLIPBOARD = XInternAtom((Display*) RGFW_root->src.display, "CLIPBOARD", False);
-			UTF8_STRING = XInternAtom((Display*) RGFW_root->src.display, "UTF8_STRING", False);
-			SAVE_TARGETS = XInternAtom((Display*) RGFW_root->src.display, "SAVE_TARGETS", False);
-			TARGETS = XInternAtom((Display*) RGFW_root->src.display, "TARGETS", False);
-			MULTIPLE = XInternAtom((Display*) RGFW_root->src.display, "MULTIPLE", False);
-			ATOM_PAIR = XInternAtom((Display*) RGFW_root->src.display, "ATOM_PAIR", False);
-			CLIPBOARD_MANAGER = XInternAtom((Display*) RGFW_root->src.display, "CLIPBOARD_MANAGER", False);
-		}
+		Atom CLIPBOARD = RGFW_ATOM(CLIPBOARD),
+			UTF8_STRING = RGFW_ATOM(UTF8_STRING),
+			SAVE_TARGETS = RGFW_ATOM(SAVE_TARGETS),
+			TARGETS = RGFW_ATOM(TARGETS),
+			MULTIPLE = RGFW_ATOM(MULTIPLE),
+			ATOM_PAIR = RGFW_ATOM(ATOM_PAIR),
+			CLIPBOARD_MANAGER = RGFW_ATOM(CLIPBOARD_MANAGER);
 		
 		XSetSelectionOwner((Display*) RGFW_root->src.display, CLIPBOARD, (Window) RGFW_root->src.window, CurrentTime);
 
@@ -3625,9 +5113,7 @@ Start of Linux / Unix defines
 	u8 RGFW_window_isMinimized(RGFW_window* win) {
 		assert(win != NULL);
 
-		static Atom prop = 0;
-		if (prop == 0)
-			prop = XInternAtom(win->src.display, "WM_STATE", False);
+		Atom prop = RGFW_ATOM(WM_STATE);
 
 		Atom actual_type;
 		i32 actual_format;
@@ -3643,192 +5129,446 @@ Start of Linux / Unix defines
 			return 1;
 		}
 
-		if (prop_data != NULL)
-			XFree(prop_data);
+		if (prop_data != NULL)
+			XFree(prop_data);
+
+		return 0;
+	}
+
+	u8 RGFW_window_isMaximized(RGFW_window* win) {
+		assert(win != NULL);
+
+		Atom net_wm_state = RGFW_ATOM(_NET_WM_STATE);
+		Atom net_wm_state_maximized_horz = RGFW_ATOM(_NET_WM_STATE_MAXIMIZED_HORZ);
+		Atom net_wm_state_maximized_vert = RGFW_ATOM(_NET_WM_STATE_MAXIMIZED_VERT);
+
+		Atom actual_type;
+		i32 actual_format;
+		unsigned long nitems, bytes_after;
+		unsigned char* prop_data;
+
+		i16 status = XGetWindowProperty(win->src.display, (Window) win->src.window, net_wm_state, 0, 1024, False,
+			XA_ATOM, &actual_type, &actual_format,
+			&nitems, &bytes_after, &prop_data);
+
+		if (status != Success) {
+			if (prop_data != NULL)
+				XFree(prop_data);
+
+			return 0;
+		}
+
+		Atom* atoms = (Atom*) prop_data;
+		u64 i;
+		for (i = 0; i < nitems; ++i) {
+			if (atoms[i] == net_wm_state_maximized_horz ||
+				atoms[i] == net_wm_state_maximized_vert) {
+				XFree(prop_data);
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+
+	static void XGetSystemContentScale(Display* display, float* xscale, float* yscale) {
+		float xdpi = 96.f, ydpi = 96.f;
+
+#ifndef RGFW_NO_DPI
+		char* rms = XResourceManagerString(display);
+		XrmDatabase db = NULL;
+
+		if (rms)
+			db = XrmGetStringDatabase(rms);
+
+		if (db == 0) {
+			*xscale = xdpi / 96.f;
+			*yscale = ydpi / 96.f;
+			return;
+		}
+
+		XrmValue value;
+		char* type = NULL;
+
+		if (XrmGetResource(db, "Xft.dpi", "Xft.Dpi", &type, &value) && type && strncmp(type, "String", 7) == 0)
+			xdpi = ydpi = atof(value.addr);
+		XrmDestroyDatabase(db);
+#endif
+
+		* xscale = xdpi / 96.f;
+		*yscale = ydpi / 96.f;
+	}
+
+#ifndef RGFW_NO_MONITOR
+	void RGFW_XSelectMonitorEvents(Display* display) {
+		i32 errorBase;
+		if (!XRRQueryExtension(display, &RGFW_xrrEventBase, &errorBase)) {
+			RGFW_xrrEventBase = -1;
+			return;
+		}
+
+		/* every connection gets the events, so whichever window pumps first sees the change */
+		XRRSelectInput(display, DefaultRootWindow(display), RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask);
+	}
+
+	static float RGFW_XModeRefreshRate(const XRRScreenResources* sr, RRMode mode) {
+		i32 i;
+		for (i = 0; i < sr->nmode; i++) {
+			const XRRModeInfo* mi = &sr->modes[i];
+			if (mi->id != mode)
+				continue;
+
+			double vTotal = mi->vTotal;
+			if (mi->modeFlags & RR_DoubleScan)
+				vTotal *= 2;
+			if (mi->modeFlags & RR_Interlace)
+				vTotal /= 2;
+
+			if (mi->hTotal == 0 || vTotal == 0)
+				return 0;
+			return (float)((double)mi->dotClock / ((double)mi->hTotal * vTotal));
+		}
+
+		return 0;
+	}
+
+	static void RGFW_XMonitorScale(RGFW_monitor* monitor, float xscale, float yscale) {
+		/* the physical size is unknown (or made up) for projectors, some VMs and Xvfb */
+		if (monitor->physW < 1 || monitor->physH < 1) {
+			monitor->scaleX = xscale;
+			monitor->scaleY = yscale;
+			return;
+		}
+
+		float dpi_width = round((double)monitor->rect.w/(((double)monitor->physW)/25.4));
+		float dpi_height = round((double)monitor->rect.h/(((double)monitor->physH)/25.4));
+
+		monitor->scaleX = (float) (dpi_width) / (float) 96;
+		monitor->scaleY = (float) (dpi_height) / (float) 96;
+
+		if (monitor->scaleX > 1 && monitor->scaleX < 1.1)
+			monitor->scaleX = 1;
+
+		if (monitor->scaleY > 1 && monitor->scaleY < 1.1)
+			monitor->scaleY = 1;
+	}
+
+	void RGFW_XUpdateMonitors(Display* display) {
+		i32 screen = DefaultScreen(display);
+		Window root = RootWindow(display, screen);
+
+		/* 
+			cleared before asking, so a change that comes in while this runs marks it stale again, 
+			the list is built on the side and only swapped in once it's whole
+		*/
+		pthread_mutex_lock(&RGFW_monitorLock);
+		RGFW_monitorCache.stale = RGFW_FALSE;
+		pthread_mutex_unlock(&RGFW_monitorLock);
+
+		RGFW_XMonitorList list;
+		list.count = 0;
+		list.primary = 0;
+
+		float xscale, yscale;
+		XGetSystemContentScale(display, &xscale, &yscale);
+
+		/* the Current variant answers from the server's state, without probing the outputs */
+		XRRScreenResources* sr = XRRGetScreenResourcesCurrent(display, root);
+		RROutput primary = XRRGetOutputPrimary(display, root);
+
+		i32 i;
+		for (i = 0; sr != NULL && i < sr->noutput && list.count < 6; i++) {
+			XRROutputInfo* info = XRRGetOutputInfo(display, sr, sr->outputs[i]);
+			if (info == NULL)
+				continue;
+
+			XRRCrtcInfo* ci = NULL;
+			if (info->connection == RR_Connected && info->crtc)
+				ci = XRRGetCrtcInfo(display, sr, info->crtc);
+
+			if (ci == NULL || ci->mode == None) {
+				if (ci != NULL)
+					XRRFreeCrtcInfo(ci);
+				XRRFreeOutputInfo(info);
+				continue;
+			}
+
+			RGFW_monitor* monitor = &list.monitors[list.count];
+			memset(monitor, 0, sizeof(RGFW_monitor));
+
+			size_t len = (size_t)info->nameLen < sizeof(monitor->name) - 1 ? (size_t)info->nameLen : sizeof(monitor->name) - 1;
+			memcpy(monitor->name, info->name, len);
+
+			monitor->rect = RGFW_RECT(ci->x, ci->y, ci->width, ci->height);
+
+			/* mm_width / mm_height are for the unrotated output */
+			if (ci->rotation & (RR_Rotate_90 | RR_Rotate_270)) {
+				monitor->physW = info->mm_height;
+				monitor->physH = info->mm_width;
+			} else {
+				monitor->physW = info->mm_width;
+				monitor->physH = info->mm_height;
+			}
+
+			RGFW_XMonitorScale(monitor, xscale, yscale);
+			monitor->refreshRate = RGFW_XModeRefreshRate(sr, ci->mode);
+
+			if (sr->outputs[i] == primary || (primary == None && ci->x == 0 && ci->y == 0))
+				list.primary = list.count;
+
+			list.count++;
+
+			XRRFreeCrtcInfo(ci);
+			XRRFreeOutputInfo(info);
+		}
+
+		if (sr != NULL)
+			XRRFreeScreenResources(sr);
 
-		return 0;
+		/* no RandR, or nothing lit up: the screen is the one monitor */
+		if (list.count == 0) {
+			RGFW_monitor* monitor = &list.monitors[0];
+			memset(monitor, 0, sizeof(RGFW_monitor));
+
+			Screen* scrn = ScreenOfDisplay(display, screen);
+			monitor->rect = RGFW_RECT(0, 0, scrn->width, scrn->height);
+			monitor->physW = DisplayWidthMM(display, screen);
+			monitor->physH = DisplayHeightMM(display, screen);
+			RGFW_XMonitorScale(monitor, xscale, yscale);
+
+			list.count = 1;
+		}
+
+		pthread_mutex_lock(&RGFW_monitorLock);
+		RGFW_monitorCache.list = list;
+		RGFW_monitorCache.valid = RGFW_TRUE;
+		pthread_mutex_unlock(&RGFW_monitorLock);
 	}
 
-	u8 RGFW_window_isMaximized(RGFW_window* win) {
-		assert(win != NULL);
+	/* a copy of the cache, refreshed first if it's out of date */
+	static RGFW_XMonitorList RGFW_XMonitors(void) {
+		assert(RGFW_root != NULL);
 
-		static Atom net_wm_state = 0;
-		static Atom net_wm_state_maximized_horz = 0;
-		static Atom net_wm_state_maximized_vert = 0;
+		pthread_mutex_lock(&RGFW_monitorLock);
+		b8 update = !RGFW_monitorCache.valid || RGFW_monitorCache.stale;
+		pthread_mutex_unlock(&RGFW_monitorLock);
 
-		if (net_wm_state == 0) {
-			net_wm_state = XInternAtom(win->src.display, "_NET_WM_STATE", False);
-			net_wm_state_maximized_vert = XInternAtom(win->src.display, "_NET_WM_STATE_MAXIMIZED_VERT", False);
-			net_wm_state_maximized_horz = XInternAtom(win->src.display, "_NET_WM_STATE_MAXIMIZED_HORZ", False);
-		}
+		if (update)
+			RGFW_XUpdateMonitors(RGFW_root->src.display);
 
-		Atom actual_type;
-		i32 actual_format;
-		unsigned long nitems, bytes_after;
-		unsigned char* prop_data;
+		pthread_mutex_lock(&RGFW_monitorLock);
+		RGFW_XMonitorList list = RGFW_monitorCache.list;
+		pthread_mutex_unlock(&RGFW_monitorLock);
+		return list;
+	}
 
-		i16 status = XGetWindowProperty(win->src.display, (Window) win->src.window, net_wm_state, 0, 1024, False,
-			XA_ATOM, &actual_type, &actual_format,
-			&nitems, &bytes_after, &prop_data);
+	RGFW_monitor* RGFW_getMonitors(void) {
+		static __thread RGFW_monitor monitors[6]; /* another thread can replace the cache while the caller reads this */
+		RGFW_XMonitorList list = RGFW_XMonitors();
+		memcpy(monitors, list.monitors, sizeof(monitors));
+		return monitors;
+	}
 
-		if (status != Success) {
-			if (prop_data != NULL)
-				XFree(prop_data);
+	u32 RGFW_getMonitorCount(void) {
+		return RGFW_XMonitors().count;
+	}
 
-			return 0;
-		}
+	RGFW_monitor RGFW_getPrimaryMonitor(void) {
+		RGFW_XMonitorList list = RGFW_XMonitors();
+		return list.monitors[list.primary];
+	}
 
-		Atom* atoms = (Atom*) prop_data;
-		u64 i;
-		for (i = 0; i < nitems; ++i) {
-			if (atoms[i] == net_wm_state_maximized_horz ||
-				atoms[i] == net_wm_state_maximized_vert) {
-				XFree(prop_data);
-				return 1;
+	RGFW_monitor RGFW_window_getMonitor(RGFW_window* win) {
+		assert(win != NULL);
+		RGFW_XMonitorList list = RGFW_XMonitors();
+
+		/* the monitor with the window's center, or else the one it overlaps most */
+		i32 cx = win->r.x + win->r.w / 2, cy = win->r.y + win->r.h / 2;
+		u32 i, best = list.primary;
+		i64 bestArea = 0;
+
+		for (i = 0; i < list.count; i++) {
+			RGFW_rect r = list.monitors[i].rect;
+			if (cx >= r.x && cx < r.x + r.w && cy >= r.y && cy < r.y + r.h)
+				return list.monitors[i];
+
+			i64 w = (i64)((win->r.x + win->r.w < r.x + r.w) ? win->r.x + win->r.w : r.x + r.w) - ((win->r.x > r.x) ? win->r.x : r.x);
+			i64 h = (i64)((win->r.y + win->r.h < r.y + r.h) ? win->r.y + win->r.h : r.y + r.h) - ((win->r.y > r.y) ? win->r.y : r.y);
+			if (w > 0 && h > 0 && w * h > bestArea) {
+				bestArea = w * h;
+				best = i;
 			}
 		}
 
-		return 0;
+		return list.monitors[best];
 	}
+#endif
 
-	static void XGetSystemContentScale(Display* display, float* xscale, float* yscale) {
-		float xdpi = 96.f, ydpi = 96.f;
+	#ifdef RGFW_OPENGL
+	void RGFW_window_makeCurrent_OpenGL(RGFW_window* win) {
+		if (win == NULL)
+			glXMakeCurrent((Display*) NULL, (Drawable)NULL, (GLXContext) NULL);
+		else
+			glXMakeCurrent((Display*) win->src.display, (Drawable) win->src.window, (GLXContext) win->src.ctx);
+	}
+	#endif
 
-#ifndef RGFW_NO_DPI
-		char* rms = XResourceManagerString(display);
-		XrmDatabase db = NULL;
 
-		if (rms && db)
-			db = XrmGetStringDatabase(rms);
+#if defined(RGFW_OSMESA) || defined(RGFW_BUFFER)
+	RGFWDEF b8 RGFW_window_clipToBuffer(RGFW_window* win, RGFW_rect* r);
 
-		if (db == 0) {
-			*xscale = xdpi / 96.f;
-			*yscale = ydpi / 96.f;
+	/* clip r to both the window and the buffer, returns false if nothing is left */
+	b8 RGFW_window_clipToBuffer(RGFW_window* win, RGFW_rect* r) {
+		i32 right = r->x + r->w, bottom = r->y + r->h;
+
+		if (r->x < 0) r->x = 0;
+		if (r->y < 0) r->y = 0;
+		if (right > win->r.w) right = win->r.w;
+		if (bottom > win->r.h) bottom = win->r.h;
+		if (right > (i32)RGFW_bufferSize.w) right = RGFW_bufferSize.w;
+		if (bottom > (i32)RGFW_bufferSize.h) bottom = RGFW_bufferSize.h;
+
+		r->w = right - r->x;
+		r->h = bottom - r->y;
+		return (r->w > 0 && r->h > 0);
+	}
+
+	#ifndef RGFW_X11_DONT_CONVERT_BGR
+	RGFWDEF void RGFW_window_convertBuffer(RGFW_window* win, RGFW_rect r);
+
+	/* RGBA -> BGRA for the part of the buffer inside r (already clipped) */
+	void RGFW_window_convertBuffer(RGFW_window* win, RGFW_rect r) {
+		size_t stride = (size_t)RGFW_bufferSize.w * 4;
+		u8* row = win->buffer + (size_t)r.y * stride + (size_t)r.x * 4;
+
+		/* full rows are contiguous, convert them in one go */
+		if (r.x == 0 && r.w == (i32)RGFW_bufferSize.w) {
+			RGFW_swizzleBGRA(row, (size_t)r.w * (size_t)r.h);
 			return;
 		}
 
-		XrmValue value;
-		char* type = NULL;
-
-		if (XrmGetResource(db, "Xft.dpi", "Xft.Dpi", &type, &value) && type && strncmp(type, "String", 7) == 0)
-			xdpi = ydpi = atof(value.addr);
-		XrmDestroyDatabase(db);
+		i32 y;
+		for (y = 0; y < r.h; y++, row += stride)
+			RGFW_swizzleBGRA(row, (size_t)r.w);
+	}
+	#endif
 #endif
 
-		* xscale = xdpi / 96.f;
-		*yscale = ydpi / 96.f;
+#ifdef RGFW_X11_SHM
+	RGFWDEF void RGFW_window_flipShm(RGFW_window* win, RGFW_rect* rects, u32 count);
+	RGFWDEF Bool RGFW_isShmCompletion(Display* display, XEvent* E, XPointer arg);
+
+	void RGFW_window_shmCompleted(RGFW_window* win, XEvent* E) {
+		ShmSeg seg = ((XShmCompletionEvent*) E)->shmseg;
+		u8 i;
+		for (i = 0; i < 2; i++)
+			if (win->src.shm[i].shmseg == seg && win->src.shmPending[i])
+				win->src.shmPending[i]--;
 	}
 
-	RGFW_monitor RGFW_XCreateMonitor(i32 screen) {
-		RGFW_monitor monitor;
+	Bool RGFW_isShmCompletion(Display* display, XEvent* E, XPointer arg) {
+		RGFW_UNUSED(display);
+		return E->type == ((RGFW_window*) arg)->src.shmCompletion;
+	}
 
-		Display* display = XOpenDisplay(NULL);
-		
-		RGFW_area size = RGFW_getScreenSize();
+	/*
+		switch win->buffer to the other segment, once the server is done with it (it was presented a frame ago, so it usually is),
+		and bring it up to date with the rects this frame changed so it holds the same frame, unless the caller doesn't need that
+		(RGFW_window_setBufferPreserved)
+	*/
+	void RGFW_window_flipShm(RGFW_window* win, RGFW_rect* rects, u32 count) {
+		u8 cur = win->src.shmCurrent, next = cur ^ 1;
 
-		monitor.rect = RGFW_RECT(0, 0, size.w, size.h);
-		monitor.physW = DisplayWidthMM(display, screen);
-		monitor.physH = DisplayHeightMM(display, screen);
-		
-		XGetSystemContentScale(display, &monitor.scaleX, &monitor.scaleY);
-		XRRScreenResources* sr = XRRGetScreenResourcesCurrent(display, RootWindow(display, screen));
+		XFlush((Display*) win->src.display);
 
-		XRRCrtcInfo* ci = NULL;
-		int crtc = screen;
+		while (win->src.shmPending[next]) {
+			XEvent E;
+			XIfEvent((Display*) win->src.display, &E, RGFW_isShmCompletion, (XPointer) win);
+			RGFW_window_shmCompleted(win, &E);
+		}
+
+		win->src.shmDrawn |= (u8)(1 << cur);
 
-		if (sr->ncrtc > crtc) {
-			ci = XRRGetCrtcInfo(display, sr, sr->crtcs[crtc]);
+		RGFW_rect full = RGFW_RECT(0, 0, win->r.w, win->r.h);
+		if (win->_winArgs & RGFW_BUFFER_DISCARD) {
+			win->src.shmStale = RGFW_TRUE;
+			count = 0;
+		} else if (win->src.shmStale) {
+			/* after swaps that didn't copy, the other segment is behind by more than this frame's damage */
+			win->src.shmStale = RGFW_FALSE;
+			rects = &full;
+			count = 1;
 		}
-		
-		if (ci == NULL) {
-			float dpi_width = round((double)monitor.rect.w/(((double)monitor.physW)/25.4));
-			float dpi_height = round((double)monitor.rect.h/(((double)monitor.physH)/25.4));
-		
-			monitor.scaleX = (float) (dpi_width) / (float) 96;
-			monitor.scaleY = (float) (dpi_height) / (float) 96;
-			XRRFreeScreenResources(sr);
-			XCloseDisplay(display);
-			return monitor;
-		}
-	    
-		XRROutputInfo* info = XRRGetOutputInfo (display, sr, sr->outputs[screen]);
-		monitor.physW = info->mm_width;
-		monitor.physH = info->mm_height;
-
-		monitor.rect.x = ci->x;
-		monitor.rect.y = ci->y;
-		monitor.rect.w = ci->width;
-		monitor.rect.h = ci->height;
-		
-		float dpi_width = round((double)monitor.rect.w/(((double)monitor.physW)/25.4));
-		float dpi_height = round((double)monitor.rect.h/(((double)monitor.physH)/25.4));
 
-		monitor.scaleX = (float) (dpi_width) / (float) 96;
-		monitor.scaleY = (float) (dpi_height) / (float) 96;		
+		size_t stride = (size_t)RGFW_bufferSize.w * 4;
+		u32 i;
+		for (i = 0; i < count; i++) {
+			RGFW_rect r = rects[i];
+			if (RGFW_window_clipToBuffer(win, &r) == RGFW_FALSE)
+				continue;
 
-		if (monitor.scaleX > 1 && monitor.scaleX < 1.1)
-			monitor.scaleX = 1;
+			size_t offset = (size_t)r.y * stride + (size_t)r.x * 4;
+			const u8* src = (const u8*) win->src.shm[cur].shmaddr + offset;
+			u8* dst = (u8*) win->src.shm[next].shmaddr + offset;
 
-		if (monitor.scaleY > 1 && monitor.scaleY < 1.1)
-			monitor.scaleY = 1;
+			/* full rows are contiguous, copy them in one go */
+			if (r.x == 0 && r.w == (i32)RGFW_bufferSize.w) {
+				memcpy(dst, src, stride * (size_t)r.h);
+				continue;
+			}
 
-		XRRFreeCrtcInfo(ci);
-		XRRFreeScreenResources(sr);
+			i32 y;
+			for (y = 0; y < r.h; y++, src += stride, dst += stride)
+				memcpy(dst, src, (size_t)r.w * 4);
+		}
 
-		XCloseDisplay(display);
+		if (count)
+			win->src.shmDrawn |= (u8)(1 << next);
 
-		return monitor;
+		win->src.shmCurrent = next;
+		win->src.bitmap = win->src.shmBitmap[next];
+		win->buffer = (u8*) win->src.shm[next].shmaddr;
+
+		#ifdef RGFW_OSMESA
+		OSMesaMakeCurrent(win->src.ctx, win->buffer, GL_UNSIGNED_BYTE, win->r.w, win->r.h);
+		#endif
 	}
+#endif
 
-	RGFW_monitor RGFW_monitors[6];
-	RGFW_monitor* RGFW_getMonitors(void) {
-		size_t i;
-		for (i = 0; i < (size_t)ScreenCount(RGFW_root->src.display) && i < 6; i++)
-			RGFW_monitors[i] = RGFW_XCreateMonitor(i);
+#if defined(RGFW_OPENGL) && !defined(RGFW_EGL)
+	#ifndef GLX_BACK_BUFFER_AGE_EXT
+	#define GLX_BACK_BUFFER_AGE_EXT 0x20F4
+	#endif
 
-		return RGFW_monitors;
+	RGFWDEF void RGFW_window_swapBuffers_GLX(RGFW_window* win);
+
+	/* 
+		GLX has no damaged swap, the whole window is swapped (so the swap interval holds), 
+		RGFW_window_getBufferAge tells the app how much it has to redraw instead
+	*/
+	void RGFW_window_swapBuffers_GLX(RGFW_window* win) {
+		glXSwapBuffers((Display*) win->src.display, (Window) win->src.window);
 	}
 
-	RGFW_monitor RGFW_getPrimaryMonitor(void) {
-		assert(RGFW_root != NULL);
+	i32 RGFW_window_getBufferAge(RGFW_window* win) {
+		assert(win != NULL);
 
-		i32 primary = -1;
-		Window root = DefaultRootWindow(RGFW_root->src.display);
-		XRRScreenResources* res = XRRGetScreenResources(RGFW_root->src.display, root);
-
-		for (int i = 0; i < res->noutput; i++) {
-			XRROutputInfo* output_info = XRRGetOutputInfo(RGFW_root->src.display, res, res->outputs[i]);
-			if (output_info->connection == RR_Connected && output_info->crtc) {
-				XRRCrtcInfo* crtc_info = XRRGetCrtcInfo(RGFW_root->src.display, res, output_info->crtc);
-				if (crtc_info->mode != None && crtc_info->x == 0 && crtc_info->y == 0) {
-					primary = i;
-					XRRFreeCrtcInfo(crtc_info);
-					XRRFreeOutputInfo(output_info);
-					break;
-				}
-				XRRFreeCrtcInfo(crtc_info);
-			}
-			XRRFreeOutputInfo(output_info);
+		/* each window has its own display connection, so it looks the extension up itself */
+		if (!(win->_swapExts & RGFW_swapExtsChecked)) {
+			const char* exts = glXQueryExtensionsString((Display*) win->src.display, DefaultScreen((Display*) win->src.display));
+			if (exts != NULL && strstr(exts, "GLX_EXT_buffer_age") != NULL)
+				win->_swapExts |= RGFW_swapBufferAge;
+			win->_swapExts |= RGFW_swapExtsChecked;
 		}
 
-		XRRFreeScreenResources(res);
-
-		return RGFW_XCreateMonitor(primary);
-	}
-
-	RGFW_monitor RGFW_window_getMonitor(RGFW_window* win) {
-		return RGFW_XCreateMonitor(DefaultScreen(win->src.display));
-	}
+		if (!(win->_swapExts & RGFW_swapBufferAge))
+			return 0;
 
-	#ifdef RGFW_OPENGL
-	void RGFW_window_makeCurrent_OpenGL(RGFW_window* win) {
-		if (win == NULL)
-			glXMakeCurrent((Display*) NULL, (Drawable)NULL, (GLXContext) NULL);
-		else
-			glXMakeCurrent((Display*) win->src.display, (Drawable) win->src.window, (GLXContext) win->src.ctx);
+		unsigned int age = 0;
+		glXQueryDrawable((Display*) win->src.display, (GLXDrawable) win->src.window, GLX_BACK_BUFFER_AGE_EXT, &age);
+		return (i32) age;
 	}
-	#endif
-
+#endif
 
 	void RGFW_window_swapBuffers(RGFW_window* win) {
 		assert(win != NULL);
@@ -3839,33 +5579,45 @@ Start of Linux / Unix defines
 			#ifdef RGFW_OSMESA
 			RGFW_OSMesa_reorganize();
 			#endif
-			RGFW_area area = RGFW_bufferSize;
+			RGFW_rect full = RGFW_RECT(0, 0, win->r.w, win->r.h);
+			RGFW_rect* rects = (win->damageCount) ? win->damage : &full;
+			u32 i, count = (win->damageCount) ? win->damageCount : 1;
 
-#ifndef RGFW_X11_DONT_CONVERT_BGR
-			win->src.bitmap->data = (char*) win->buffer;
-			u32 x, y;
-			for (y = 0; y < (u32)win->r.h; y++) {
-				for (x = 0; x < (u32)win->r.w; x++) {
-					u32 index = (y * 4 * area.w) + x * 4;
-
-					u8 red = win->src.bitmap->data[index];
-					win->src.bitmap->data[index] = win->buffer[index + 2];
-					win->src.bitmap->data[index + 2] = red;
+			for (i = 0; i < count; i++) {
+				RGFW_rect r = rects[i];
+				if (RGFW_window_clipToBuffer(win, &r) == RGFW_FALSE)
+					continue;
 
+#ifndef RGFW_X11_DONT_CONVERT_BGR
+				RGFW_window_convertBuffer(win, r);
+#endif	
+	#ifdef RGFW_X11_SHM
+				if (win->src.shm[0].shmaddr != NULL) {
+					XShmPutImage(win->src.display, (Window) win->src.window, win->src.gc, win->src.bitmap, r.x, r.y, r.x, r.y, r.w, r.h, True);
+					win->src.shmPending[win->src.shmCurrent]++;
 				}
+				else
+	#endif
+				XPutImage(win->src.display, (Window) win->src.window, win->src.gc, win->src.bitmap, r.x, r.y, r.x, r.y, r.w, r.h);
 			}
-#endif	
-			XPutImage(win->src.display, (Window) win->src.window, win->src.gc, win->src.bitmap, 0, 0, 0, 0, RGFW_bufferSize.w, RGFW_bufferSize.h);
+
+	#ifdef RGFW_X11_SHM
+			/* the server reads straight out of win->buffer, the next frame goes into the other segment */
+			if (win->src.shm[0].shmaddr != NULL)
+				RGFW_window_flipShm(win, rects, count);
+	#endif
 #endif
 		}
 
 		if (!(win->_winArgs & RGFW_NO_GPU_RENDER)) {
 			#ifdef RGFW_EGL
-					eglSwapBuffers(win->src.EGL_display, win->src.EGL_surface);
+					RGFW_window_swapBuffers_EGL(win);
 			#elif defined(RGFW_OPENGL)
-					glXSwapBuffers((Display*) win->src.display, (Window) win->src.window);
+					RGFW_window_swapBuffers_GLX(win);
 			#endif
 		}
+
+		win->damageCount = 0;
 	}
 
 	#if !defined(RGFW_EGL)	
@@ -3887,12 +5639,25 @@ Start of Linux / Unix defines
 			XUngrabPointer(win->src.display, CurrentTime);
 			
 		assert(win != NULL);
+
+		/* nothing will finish the request now */
+		if (win->src.clipboard != NULL) {
+			RGFW_clipboardRequest_finish(win->src.clipboard, RGFW_clipboardFailed);
+			win->src.clipboard = NULL;
+		}
 #ifdef RGFW_EGL
 		RGFW_closeEGL(win);
 #endif
 
 #if defined(RGFW_OSMESA) || defined(RGFW_BUFFER)
 		if (win->buffer != NULL) {
+			#ifdef RGFW_X11_SHM
+			if (win->src.shm[0].shmaddr != NULL) {
+				RGFW_window_freeShmSegment(win, 0);
+				RGFW_window_freeShmSegment(win, 1);
+			}
+			else
+			#endif
 			XDestroyImage((XImage*) win->src.bitmap);
 			XFreeGC(win->src.display, win->src.gc);
 		}
@@ -3912,16 +5677,8 @@ Start of Linux / Unix defines
 			XCloseDisplay((Display*) win->src.display); /*!< kill the display*/
 		}
 
-#ifdef RGFW_ALLOC_DROPFILES
-		{
-			u32 i;
-			for (i = 0; i < RGFW_MAX_DROPS; i++)
-				RGFW_FREE(win->event.droppedFiles[i]);
-
-
-			RGFW_FREE(win->event.droppedFiles);
-		}
-#endif
+		RGFW_window_freeDrops(win);
+		RGFW_window_closeWake(win);
 
 		RGFW_windowsOpen--;
 #if !defined(RGFW_NO_X11_CURSOR_PRELOAD) && !defined(RGFW_NO_X11_CURSOR)
@@ -3938,6 +5695,13 @@ Start of Linux / Unix defines
 			X11Xihandle = NULL;
 		}
 #endif
+#if defined(RGFW_X11_SHM) && !defined(RGFW_NO_X11_SHM_PRELOAD)
+		if (X11Xexthandle != NULL && RGFW_windowsOpen <= 0) {
+			dlclose(X11Xexthandle);
+
+			X11Xexthandle = NULL;
+		}
+#endif
 
 		if (RGFW_libxshape != NULL && RGFW_windowsOpen <= 0) {
 			dlclose(RGFW_libxshape);
@@ -3945,14 +5709,17 @@ Start of Linux / Unix defines
 		}
 
 		if (RGFW_windowsOpen <= 0) {
-			if (RGFW_eventWait_forceStop[0] || RGFW_eventWait_forceStop[1]){
-				close(RGFW_eventWait_forceStop[0]);
-				close(RGFW_eventWait_forceStop[1]);
-			}
-
+#ifdef __linux__
 			u8 i;
 			for (i = 0; i < RGFW_joystickCount; i++)
-				close(RGFW_joysticks[i]);
+				RGFW_linux_closeJoystick(i);
+			RGFW_joystickCount = 0;
+
+			if (RGFW_jsInotify != -1) {
+				close(RGFW_jsInotify);
+				RGFW_jsInotify = -1;
+			}
+#endif
 		}
 
 		/* set cleared display / window to NULL for error checking */
@@ -3975,32 +5742,26 @@ Start of Linux / Unix defines
 #include <fcntl.h>
 #include <poll.h>
 #include <unistd.h>
+#include <errno.h>
 	u16 RGFW_registerJoystickF(RGFW_window* win, char* file) {
 		assert(win != NULL);
 
 #ifdef __linux__
 
-		i32 js = open(file, O_RDONLY);
-
-		if (js && RGFW_joystickCount < 4) {
-			RGFW_joystickCount++;
-
-			RGFW_joysticks[RGFW_joystickCount - 1] = open(file, O_RDONLY);
-
-			u8 i;
-			for (i = 0; i < 16; i++)
-				RGFW_jsPressed[RGFW_joystickCount - 1][i] = 0;
-
-		}
+		/* a window thread may be draining the joysticks right now */
+		pthread_mutex_lock(&RGFW_jsLock);
+		i32 js = RGFW_linux_openJoystick(file);
+		pthread_mutex_unlock(&RGFW_jsLock);
 
-		else {
+		if (js == -1) {
 #ifdef RGFW_PRINT_ERRORS
 			RGFW_error = 1;
 			fprintf(stderr, "Error RGFW_registerJoystickF : Cannot open file %s\n", file);
 #endif
+			return RGFW_joystickCount - 1;
 		}
 
-		return RGFW_joystickCount - 1;
+		return (u16) js;
 #endif
 	}
 	
@@ -4015,40 +5776,61 @@ Start of Linux / Unix defines
 #endif
 	}
 	
-	void RGFW_stopCheckEvents(void) { 
-		RGFW_eventWait_forceStop[2] = 1;
+	/* the window's wake pipe, non-blocking so neither side can get stuck on it */
+	void RGFW_window_initWake(RGFW_window* win) {
+		if (pipe(win->src.wake) == -1) {
+			win->src.wake[0] = win->src.wake[1] = -1;
+			return;
+		}
+
+		fcntl(win->src.wake[0], F_SETFL, fcntl(win->src.wake[0], F_GETFL, 0) | O_NONBLOCK);
+		fcntl(win->src.wake[1], F_SETFL, fcntl(win->src.wake[1], F_GETFL, 0) | O_NONBLOCK);
+	}
+
+	void RGFW_window_closeWake(RGFW_window* win) {
+		if (win->src.wake[0] == -1)
+			return;
+
+		close(win->src.wake[0]);
+		close(win->src.wake[1]);
+		win->src.wake[0] = win->src.wake[1] = -1;
+	}
+
+	void RGFW_window_stopCheckEvents(RGFW_window* win) {
+		assert(win != NULL);
+		if (win->src.wake[1] == -1)
+			return;
+
+		/* a full pipe (EAGAIN) already has a wake up in it */
 		while (1) {
 			const char byte = 0;
-			const ssize_t result = write(RGFW_eventWait_forceStop[1], &byte, 1);
-			if (result == 1 || result == -1)
+			const ssize_t result = write(win->src.wake[1], &byte, 1);
+			if (result == 1 || (result == -1 && errno != EINTR))
 				break;
 		}
 	}
 
+	void RGFW_stopCheckEvents(void) { 
+		RGFW_window* root = RGFW_root;
+		if (root != NULL)
+			RGFW_window_stopCheckEvents(root);
+	}
+
 	void RGFW_window_eventWait(RGFW_window* win, i32 waitMS) {
 		if (waitMS == 0)
 			return;
 		
 		u8 i;
 
-		if (RGFW_eventWait_forceStop[0] == 0 || RGFW_eventWait_forceStop[1] == 0) {
-			if (pipe(RGFW_eventWait_forceStop) != -1) {
-				fcntl(RGFW_eventWait_forceStop[0], F_GETFL, 0);
-				fcntl(RGFW_eventWait_forceStop[0], F_GETFD, 0);
-				fcntl(RGFW_eventWait_forceStop[1], F_GETFL, 0);
-				fcntl(RGFW_eventWait_forceStop[1], F_GETFD, 0);
-			}
-		}
-
 		struct pollfd fds[] = {
 			#ifdef RGFW_WAYLAND
 			{ wl_display_get_fd(win->src.display), POLLIN, 0 },
 			#else
 			{ ConnectionNumber(win->src.display), POLLIN, 0 },
 			#endif
-			{ RGFW_eventWait_forceStop[0], POLLIN, 0 },
-			#ifdef __linux__ /* blank space for 4 joystick files*/
-			{ -1, POLLIN, 0 }, {-1, POLLIN, 0 }, {-1, POLLIN, 0 },  {-1, POLLIN, 0} 
+			{ win->src.wake[0], POLLIN, 0 },
+			#ifdef __linux__ /* blank space for 4 joystick files and the hotplug watch */
+			{ -1, POLLIN, 0 }, {-1, POLLIN, 0 }, {-1, POLLIN, 0 },  {-1, POLLIN, 0}, {-1, POLLIN, 0} 
 			#endif
 		};
 
@@ -4062,9 +5844,25 @@ Start of Linux / Unix defines
 				fds[index].fd = RGFW_joysticks[i];
 				index++;
 			}
+
+			if (RGFW_jsInotify != -1) {
+				fds[index].fd = RGFW_jsInotify;
+				index++;
+			}
 		#endif
 
 
+		#ifndef RGFW_WAYLAND
+		/* wake up in time to fail a clipboard request nobody is answering */
+		if (win->src.clipboard != NULL) {
+			i64 left = RGFW_CLIPBOARD_TIMEOUT - (i64)((RGFW_getTimeNS() - win->src.clipboardTime) / 1000000) + 1;
+			if (left < 1)
+				left = 1;
+			if (waitMS < 0 || waitMS > left)
+				waitMS = (i32)left;
+		}
+		#endif
+
 		u64 start = RGFW_getTimeNS();
 
 		#ifdef RGFW_WAYLAND
@@ -4075,17 +5873,20 @@ Start of Linux / Unix defines
 			if (poll(fds, index, waitMS) <= 0)
 				break;
 
+			/* woken up by RGFW_stopCheckEvents or a joystick, there won't be anything for XPending */
+			for (i = 1; i < index && fds[i].revents == 0; i++);
+			if (i < index)
+				break;
+
 			if (waitMS > 0) {
 				waitMS -= (RGFW_getTimeNS() - start) / 1e+6;
 			}
 		}
 
-		/* drain any data in the stop request */
-		if (RGFW_eventWait_forceStop[2]) {	
+		/* drain the wake ups, whatever they asked for is looked at once this returns */
+		if (win->src.wake[0] != -1) {
 			char data[64];
-			(void)!read(RGFW_eventWait_forceStop[0], data, sizeof(data));
-			
-			RGFW_eventWait_forceStop[2] = 0;
+			while (read(win->src.wake[0], data, sizeof(data)) > 0);
 		}
 	}
 
@@ -4309,8 +6110,7 @@ static void pointer_button(void *data, struct wl_pointer *pointer, uint32_t seri
 	if (b == 2) b = 3;
 	else if (b == 3) b = 2;
 	
-	RGFW_mouseButtons[b].prev = RGFW_mouseButtons[b].current;
-	RGFW_mouseButtons[b].current = state;
+	RGFW_window_setMouseButton(RGFW_mouse_win, (u8)b, (b8)state);
 
 	RGFW_Event ev;
 	ev.type = RGFW_mouseButtonPressed + state;
@@ -4387,8 +6187,7 @@ static void keyboard_key (void *data, struct wl_keyboard *keyboard, uint32_t ser
 	xkb_keysym_get_name(keysym, name, 16);
 
 	u32 RGFW_key = RGFW_apiKeyCodeToRGFW(key);
-	RGFW_keyboard[RGFW_key].prev = RGFW_keyboard[RGFW_key].current;
-	RGFW_keyboard[RGFW_key].current = state;
+	RGFW_window_setKey(RGFW_key_win, (u8)RGFW_key, (b8)state);
 	RGFW_Event ev;
 	ev.type = RGFW_keyPressed + state;
 	ev.keyCode = RGFW_key;
@@ -4534,17 +6333,7 @@ static void wl_surface_frame_done(void *data, struct wl_callback *cb, uint32_t t
 			return;	
 		
 		#ifndef RGFW_X11_DONT_CONVERT_BGR
-			u32 x, y;
-			for (y = 0; y < (u32)win->r.h; y++) {
-				for (x = 0; x < (u32)win->r.w; x++) {
-					u32 index = (y * 4 * win->r.w) + x * 4;
-
-					u8 red = win->buffer[index];
-					win->buffer[index] = win->buffer[index + 2];
-					win->buffer[index + 2] = red;
-
-				}
-			}
+			RGFW_swizzleBGRA(win->buffer, (size_t)win->r.w * (size_t)win->r.h);
 		#endif	
 	
 		wl_surface_attach(win->src.surface, win->src.wl_buffer, 0, 0);
@@ -4729,6 +6518,11 @@ static const struct wl_callback_listener wl_surface_frame_listener = {
 		
 		win->src.eventIndex = 0;
 		win->src.eventLen = 0;
+		RGFW_window_initWake(win);
+
+		#ifdef __linux__
+		RGFW_linux_initJoystickHotplug();
+		#endif
 		
 		return win;
 	}
@@ -4741,7 +6535,8 @@ static const struct wl_callback_listener wl_surface_frame_listener = {
 			if (wl_display_roundtrip(win->src.display) == -1) {
 				return NULL;
 			}
-			RGFW_resetKey();
+			RGFW_window_resetKeys(win);
+			win->_jsPolled = RGFW_FALSE;
 		}
 
 		#ifdef __linux__
@@ -4760,9 +6555,7 @@ static const struct wl_callback_listener wl_surface_frame_listener = {
 			return NULL;
 		}
         
-		ev.frameTime = win->event.frameTime;
-        ev.frameTime2 = win->event.frameTime2;
-        ev.inFocus = win->event.inFocus;
+		ev.inFocus = win->event.inFocus;
         win->event = ev;
 		
 		return &win->event;
@@ -4947,10 +6740,11 @@ static const struct wl_callback_listener wl_surface_frame_listener = {
 		#endif
 		{
 		#ifdef RGFW_OPENGL
-			eglSwapBuffers(win->src.EGL_display, win->src.EGL_surface);
+			RGFW_window_swapBuffers_EGL(win);
 		#endif
 		}
 		
+		win->damageCount = 0;
 		wl_display_flush(win->src.display);
 	}
 
@@ -4972,6 +6766,7 @@ static const struct wl_callback_listener wl_surface_frame_listener = {
 		#endif
 		
 		wl_display_disconnect(win->src.display);
+		RGFW_window_closeWake(win);
 		RGFW_FREE(win);
 	}
 
@@ -4987,6 +6782,12 @@ static const struct wl_callback_listener wl_surface_frame_listener = {
 		return NULL;
 	}
 
+	u32 RGFW_getMonitorCount(void) {
+		/* TODO wayland */
+
+		return 0;
+	}
+
 	void RGFW_writeClipboard(const char* text, u32 textLen) {
 		RGFW_UNUSED(text); RGFW_UNUSED(textLen);
 
@@ -5716,6 +7517,11 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 		PostMessageW(RGFW_root->src.window, WM_NULL, 0, 0);
 	}
 
+	void RGFW_window_stopCheckEvents(RGFW_window* win) {
+		assert(win != NULL);
+		PostMessageW(win->src.window, WM_NULL, 0, 0);
+	}
+
 	void RGFW_window_eventWait(RGFW_window* win, i32 waitMS) {
 		RGFW_UNUSED(win);
 
@@ -5756,27 +7562,23 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 		static HDROP drop;
 		
 		if (win->event.type == RGFW_dnd_init) {
-			if (win->event.droppedFilesCount) {
-				u32 i;
-				for (i = 0; i < win->event.droppedFilesCount; i++)
-					win->event.droppedFiles[i][0] = '\0';
-			}
-
-			win->event.droppedFilesCount = 0;
-			win->event.droppedFilesCount = DragQueryFileW(drop, 0xffffffff, NULL, 0);
-			//win->event.droppedFiles = (char**)RGFW_CALLOC(win->event.droppedFilesCount, sizeof(char*));
+			RGFW_window_beginDrop(win);
+			u32 count = DragQueryFileW(drop, 0xffffffff, NULL, 0);
 
 			u32 i;
-			for (i = 0; i < win->event.droppedFilesCount; i++) {
+			for (i = 0; i < count; i++) {
 				const UINT length = DragQueryFileW(drop, i, NULL, 0);
 				WCHAR* buffer = (WCHAR*) RGFW_CALLOC((size_t) length + 1, sizeof(WCHAR));
 
 				DragQueryFileW(drop, i, buffer, length + 1);
-				strncpy(win->event.droppedFiles[i], createUTF8FromWideStringWin32(buffer), RGFW_MAX_PATH);
-				win->event.droppedFiles[i][RGFW_MAX_PATH - 1] = '\0';
+
+				char* path = createUTF8FromWideStringWin32(buffer);
+				if (path != NULL)
+					RGFW_window_addDrop(win, path, strlen(path));
 				RGFW_FREE(buffer);
 			}
 
+			RGFW_window_endDrop(win);
 			DragFinish(drop);
 			RGFW_dndCallback(win, win->event.droppedFiles, win->event.droppedFilesCount);
 			
@@ -5827,8 +7629,6 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 			case WM_KEYUP: {
 				win->event.keyCode = RGFW_apiKeyCodeToRGFW((u32) msg.wParam);
 								
-				RGFW_keyboard[win->event.keyCode].prev = RGFW_isPressed(win, win->event.keyCode);
-
 				static char keyName[16];
 				
 				{
@@ -5850,15 +7650,13 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 				}
 
 				win->event.type = RGFW_keyReleased;
-				RGFW_keyboard[win->event.keyCode].current = 0;
+				RGFW_window_setKey(win, (u8)win->event.keyCode, 0);
 				RGFW_keyCallback(win, win->event.keyCode, win->event.keyName, win->event.lockState, 0);
 				break;
 			}
 			case WM_KEYDOWN: {
 				win->event.keyCode = RGFW_apiKeyCodeToRGFW((u32) msg.wParam);
 
-				RGFW_keyboard[win->event.keyCode].prev = RGFW_isPressed(win, win->event.keyCode);
-
 				static char keyName[16];
 				
 				{
@@ -5881,7 +7679,7 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 
 				win->event.type = RGFW_keyPressed;
 				win->event.repeat = RGFW_isPressed(win, win->event.keyCode);
-				RGFW_keyboard[win->event.keyCode].current = 1;
+				RGFW_window_setKey(win, (u8)win->event.keyCode, 1);
 				RGFW_keyCallback(win, win->event.keyCode, win->event.keyName, win->event.lockState, 1);
 				break;
 			}
@@ -5924,23 +7722,20 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 
 			case WM_LBUTTONDOWN:
 				win->event.button = RGFW_mouseLeft;
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 1;
+				RGFW_window_setMouseButton(win, win->event.button, 1);
 				win->event.type = RGFW_mouseButtonPressed;
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 1);
 				break;
 			case WM_RBUTTONDOWN:
 				win->event.button = RGFW_mouseRight;
 				win->event.type = RGFW_mouseButtonPressed;
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 1;
+				RGFW_window_setMouseButton(win, win->event.button, 1);
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 1);
 				break;
 			case WM_MBUTTONDOWN:
 				win->event.button = RGFW_mouseMiddle;
 				win->event.type = RGFW_mouseButtonPressed;
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 1;
+				RGFW_window_setMouseButton(win, win->event.button, 1);
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 1);
 				break;
 
@@ -5950,8 +7745,7 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 				else
 					win->event.button = RGFW_mouseScrollDown;
 
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 1;
+				RGFW_window_setMouseButton(win, win->event.button, 1);
 
 				win->event.scroll = (SHORT) HIWORD(msg.wParam) / (double) WHEEL_DELTA;
 
@@ -5964,24 +7758,21 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 				win->event.button = RGFW_mouseLeft;
 				win->event.type = RGFW_mouseButtonReleased;
 
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 0;
+				RGFW_window_setMouseButton(win, win->event.button, 0);
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 0);
 				break;
 			case WM_RBUTTONUP:
 				win->event.button = RGFW_mouseRight;
 				win->event.type = RGFW_mouseButtonReleased;
 
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 0;
+				RGFW_window_setMouseButton(win, win->event.button, 0);
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 0);
 				break;
 			case WM_MBUTTONUP:
 				win->event.button = RGFW_mouseMiddle;
 				win->event.type = RGFW_mouseButtonReleased;
 
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 0;
+				RGFW_window_setMouseButton(win, win->event.button, 0);
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 0);
 				break;
 
@@ -6096,10 +7887,10 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 	#ifndef RGFW_NO_MONITOR
 	RGFW_monitor win32CreateMonitor(HMONITOR src) {
 		RGFW_monitor monitor;
-		MONITORINFO monitorInfo;
+		MONITORINFOEXA monitorInfo;
 
-		monitorInfo.cbSize = sizeof(MONITORINFO);
-		GetMonitorInfoA(src, &monitorInfo);
+		monitorInfo.cbSize = sizeof(MONITORINFOEXA);
+		GetMonitorInfoA(src, (MONITORINFO*) &monitorInfo);
 
 		RGFW_mInfo info;
 		info.iIndex = 0;
@@ -6149,6 +7940,13 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 		/* Calculate physical height in inches */
 		monitor.physW = GetSystemMetrics(SM_CYSCREEN) / (float) ppiX;
 		monitor.physH = GetSystemMetrics(SM_CXSCREEN) / (float) ppiY;
+
+		DEVMODEA dm;
+		dm.dmSize = sizeof(dm);
+		dm.dmDriverExtra = 0;
+		monitor.refreshRate = 0;
+		if (EnumDisplaySettingsA(monitorInfo.szDevice, ENUM_CURRENT_SETTINGS, &dm) && dm.dmDisplayFrequency > 1)
+			monitor.refreshRate = (float) dm.dmDisplayFrequency; /* 0 and 1 mean the hardware default */
 		
 		return monitor;
 	}
@@ -6180,14 +7978,23 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 	    #endif
     }
 
+	u32 RGFW_monitorCount = 0;
+
 	RGFW_monitor* RGFW_getMonitors(void) {
 		RGFW_mInfo info;
 		info.iIndex = 0;
 		while (EnumDisplayMonitors(NULL, NULL, GetMonitorHandle, (LPARAM) &info));
-			
+
+		RGFW_monitorCount = info.iIndex;
 		return RGFW_monitors;
 	}
 
+	u32 RGFW_getMonitorCount(void) {
+		if (RGFW_monitorCount == 0)
+			RGFW_getMonitors();
+		return RGFW_monitorCount;
+	}
+
 	RGFW_monitor RGFW_window_getMonitor(RGFW_window* win) {
 		HMONITOR src = MonitorFromWindow(win->src.window, MONITOR_DEFAULTTOPRIMARY);
 		return win32CreateMonitor(src);
@@ -6344,16 +8151,7 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 			RGFW_FREE(win->buffer);
 #endif
 
-#ifdef RGFW_ALLOC_DROPFILES
-		{
-			u32 i;
-			for (i = 0; i < RGFW_MAX_DROPS; i++)
-				RGFW_FREE(win->event.droppedFiles[i]);
-
-
-			RGFW_FREE(win->event.droppedFiles);
-		}
-#endif
+		RGFW_window_freeDrops(win);
 
 		RGFW_FREE(win);
 	}
@@ -7133,13 +8931,15 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 		if (count == 0)
 			return 0;
 
+		RGFW_window_beginDrop(win);
+
 		for (int i = 0; i < count; i++) {
 			id fileURL = objc_msgSend_arr(fileURLs, sel_registerName("objectAtIndex:"), i);
 			const char *filePath = ((const char* (*)(id, SEL))objc_msgSend)(fileURL, sel_registerName("UTF8String"));
-			strncpy(win->event.droppedFiles[i], filePath, RGFW_MAX_PATH);
-			win->event.droppedFiles[i][RGFW_MAX_PATH - 1] = '\0';
+			RGFW_window_addDrop(win, filePath, strlen(filePath));
 		}
-		win->event.droppedFilesCount = count;
+
+		RGFW_window_endDrop(win);
 
 		win->event.type = RGFW_dnd;
 		win->src.dndPassed = 0;
@@ -7590,6 +9390,9 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 		objc_msgSend_bool_void(eventPool, sel_registerName("drain"));
 	}
 
+	/* every window's events come through NSApp on the main thread */
+	void RGFW_window_stopCheckEvents(RGFW_window* win) { RGFW_UNUSED(win); RGFW_stopCheckEvents(); }
+
 	void RGFW_window_eventWait(RGFW_window* win, i32 waitMS) {
 		RGFW_UNUSED(win);
 		
@@ -7653,12 +9456,6 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 			return NULL;
 		}
 
-		if (win->event.droppedFilesCount) {
-			u32 i;
-			for (i = 0; i < win->event.droppedFilesCount; i++)
-				win->event.droppedFiles[i][0] = '\0';
-		}
-
 		win->event.droppedFilesCount = 0;
 		win->event.type = 0;
 		
@@ -7680,13 +9477,11 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 			case NSEventTypeKeyDown: {
 				u32 key = (u16) objc_msgSend_uint(e, sel_registerName("keyCode"));
 				win->event.keyCode = RGFW_apiKeyCodeToRGFW(key);
-				RGFW_keyboard[win->event.keyCode].prev = RGFW_keyboard[win->event.keyCode].current;
-
 				win->event.type = RGFW_keyPressed;
 				char* str = (char*)(const char*) NSString_to_char(objc_msgSend_id(e, sel_registerName("characters")));
 				strncpy(win->event.keyName, str, 16);
 				win->event.repeat = RGFW_isPressed(win, win->event.keyCode);
-				RGFW_keyboard[win->event.keyCode].current = 1;
+				RGFW_window_setKey(win, (u8)win->event.keyCode, 1);
 
 				RGFW_keyCallback(win, win->event.keyCode, win->event.keyName, win->event.lockState, 1);
 				break;
@@ -7696,13 +9491,11 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 				u32 key = (u16) objc_msgSend_uint(e, sel_registerName("keyCode"));
 				win->event.keyCode = RGFW_apiKeyCodeToRGFW(key);;
 
-				RGFW_keyboard[win->event.keyCode].prev = RGFW_keyboard[win->event.keyCode].current;
-
 				win->event.type = RGFW_keyReleased;
 				char* str = (char*)(const char*) NSString_to_char(objc_msgSend_id(e, sel_registerName("characters")));
 				strncpy(win->event.keyName, str, 16);
 
-				RGFW_keyboard[win->event.keyCode].current = 0;
+				RGFW_window_setKey(win, (u8)win->event.keyCode, 0);
 				RGFW_keyCallback(win, win->event.keyCode, win->event.keyName, win->event.lockState, 0);
 				break;
 			}
@@ -7712,29 +9505,26 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 				RGFW_updateLockState(win, ((u32)(flags & NSEventModifierFlagCapsLock) % 255), ((flags & NSEventModifierFlagNumericPad) % 255));
 				
 				u8 i;
-				for (i = 0; i < 9; i++)
-					RGFW_keyboard[i + RGFW_CapsLock].prev = 0;
-				
 				for (i = 0; i < 5; i++) {
 					u32 shift = (1 << (i + 16));
-					u32 key = i + RGFW_CapsLock;
+					u8 key = i + RGFW_CapsLock;
 
-					if ((flags & shift) && !RGFW_wasPressed(win, key)) {
-						RGFW_keyboard[key].current = 1;
+					if ((flags & shift) && !RGFW_keyBit(win->_keys, key)) {
+						RGFW_window_setKey(win, key, 1);
 
 						if (key != RGFW_CapsLock)
-							RGFW_keyboard[key+ 4].current = 1;
+							RGFW_window_setKey(win, key + 4, 1);
 						
 						win->event.type = RGFW_keyPressed;
 						win->event.keyCode = key;
 						break;
 					} 
 					
-					if (!(flags & shift) && RGFW_wasPressed(win, key)) {
-						RGFW_keyboard[key].current = 0;
+					if (!(flags & shift) && RGFW_keyBit(win->_keys, key)) {
+						RGFW_window_setKey(win, key, 0);
 						
 						if (key != RGFW_CapsLock)
-							RGFW_keyboard[key + 4].current = 0;
+							RGFW_window_setKey(win, key + 4, 0);
 
 						win->event.type = RGFW_keyReleased;
 						win->event.keyCode = key;
@@ -7767,47 +9557,41 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 			case NSEventTypeLeftMouseDown:
 				win->event.button = RGFW_mouseLeft;
 				win->event.type = RGFW_mouseButtonPressed;
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 1;
+				RGFW_window_setMouseButton(win, win->event.button, 1);
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 1);
 				break;
 
 			case NSEventTypeOtherMouseDown:
 				win->event.button = RGFW_mouseMiddle;
 				win->event.type = RGFW_mouseButtonPressed;
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 1;
+				RGFW_window_setMouseButton(win, win->event.button, 1);
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 1);
 				break;
 
 			case NSEventTypeRightMouseDown:
 				win->event.button = RGFW_mouseRight;
 				win->event.type = RGFW_mouseButtonPressed;
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 1;
+				RGFW_window_setMouseButton(win, win->event.button, 1);
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 1);
 				break;
 
 			case NSEventTypeLeftMouseUp:
 				win->event.button = RGFW_mouseLeft;
 				win->event.type = RGFW_mouseButtonReleased;
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 0;
+				RGFW_window_setMouseButton(win, win->event.button, 0);
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 0);
 				break;
 
 			case NSEventTypeOtherMouseUp:
 				win->event.button = RGFW_mouseMiddle;
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 0;
+				RGFW_window_setMouseButton(win, win->event.button, 0);
 				win->event.type = RGFW_mouseButtonReleased;
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 0);
 				break;
 
 			case NSEventTypeRightMouseUp:
 				win->event.button = RGFW_mouseRight;
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 0;
+				RGFW_window_setMouseButton(win, win->event.button, 0);
 				win->event.type = RGFW_mouseButtonReleased;
 				RGFW_mouseButtonCallback(win, win->event.button, win->event.scroll, 0);
 				break;
@@ -7822,8 +9606,7 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 					win->event.button = RGFW_mouseScrollDown;
 				}
 
-				RGFW_mouseButtons[win->event.button].prev = RGFW_mouseButtons[win->event.button].current;
-				RGFW_mouseButtons[win->event.button].current = 1;
+				RGFW_window_setMouseButton(win, win->event.button, 1);
 
 				win->event.scroll = deltaY;
 
@@ -8052,11 +9835,19 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 		monitor.scaleX = ((monitor.rect.w / (screenSizeMM.width / 25.4)) / 96) + 0.25;
 		monitor.scaleY = ((monitor.rect.h / (screenSizeMM.height / 25.4)) / 96) + 0.25;
 
+		monitor.refreshRate = 0;
+		CGDisplayModeRef mode = CGDisplayCopyDisplayMode(display);
+		if (mode != NULL) {
+			monitor.refreshRate = (float) CGDisplayModeGetRefreshRate(mode); /* 0 for built-in panels */
+			CGDisplayModeRelease(mode);
+		}
+
 		return monitor;
 	}
 
 
 	static RGFW_monitor RGFW_monitors[7];
+	static u32 RGFW_monitorCount = 0;
 
 	RGFW_monitor* RGFW_getMonitors(void) {
 		static CGDirectDisplayID displays[7];
@@ -8068,9 +9859,16 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 		for (u32 i = 0; i < count; i++)
 			RGFW_monitors[i] = RGFW_NSCreateMonitor(displays[i]);
 
+		RGFW_monitorCount = count;
 		return RGFW_monitors;
 	}
 
+	u32 RGFW_getMonitorCount(void) {
+		if (RGFW_monitorCount == 0)
+			RGFW_getMonitors();
+		return RGFW_monitorCount;
+	}
+
 	RGFW_monitor RGFW_getPrimaryMonitor(void) {
 		CGDirectDisplayID primary = CGMainDisplayID();
 		return RGFW_NSCreateMonitor(primary);
@@ -8216,16 +10014,7 @@ RGFW_UNUSED(win); /*!< if buffer rendering is not being used */
 		assert(win != NULL);
 		release(win->src.view);
 
-#ifdef RGFW_ALLOC_DROPFILES
-		{
-			u32 i;
-			for (i = 0; i < RGFW_MAX_DROPS; i++)
-				RGFW_FREE(win->event.droppedFiles[i]);
-
-
-			RGFW_FREE(win->event.droppedFiles);
-		}
-#endif
+		RGFW_window_freeDrops(win);
 	
 #ifdef RGFW_BUFFER
 		release(win->src.bitmap);
@@ -8276,8 +10065,7 @@ EM_BOOL Emscripten_on_keydown(int eventType, const EmscriptenKeyboardEvent* e, v
 	RGFW_events[RGFW_eventLen].lockState = 0;
 	RGFW_eventLen++;
 
-	RGFW_keyboard[RGFW_apiKeyCodeToRGFW(e->keyCode)].prev = RGFW_keyboard[RGFW_apiKeyCodeToRGFW(e->keyCode)].current;
-	RGFW_keyboard[RGFW_apiKeyCodeToRGFW(e->keyCode)].current = 1;
+	RGFW_window_setKey(RGFW_root, (u8)RGFW_apiKeyCodeToRGFW(e->keyCode), 1);
 	RGFW_keyCallback(RGFW_root, RGFW_apiKeyCodeToRGFW(e->keyCode), RGFW_events[RGFW_eventLen].keyName, 0, 1);
 	
     return EM_TRUE;
@@ -8292,8 +10080,7 @@ EM_BOOL Emscripten_on_keyup(int eventType, const EmscriptenKeyboardEvent* e, voi
 	RGFW_events[RGFW_eventLen].lockState = 0;
 	RGFW_eventLen++;
 
-	RGFW_keyboard[RGFW_apiKeyCodeToRGFW(e->keyCode)].prev = RGFW_keyboard[RGFW_apiKeyCodeToRGFW(e->keyCode)].current;
-	RGFW_keyboard[RGFW_apiKeyCodeToRGFW(e->keyCode)].current = 0;
+	RGFW_window_setKey(RGFW_root, (u8)RGFW_apiKeyCodeToRGFW(e->keyCode), 0);
 
 	RGFW_keyCallback(RGFW_root, RGFW_apiKeyCodeToRGFW(e->keyCode), RGFW_events[RGFW_eventLen].keyName, 0, 0);
 
@@ -8368,8 +10155,7 @@ EM_BOOL Emscripten_on_mousedown(int eventType, const EmscriptenMouseEvent* e, vo
 	RGFW_events[RGFW_eventLen].button = e->button + 1; 
 	RGFW_events[RGFW_eventLen].scroll = 0;
 
-	RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].prev = RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current;	
-	RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current = 1;
+	RGFW_window_setMouseButton(RGFW_root, RGFW_events[RGFW_eventLen].button, 1);
 
 	RGFW_mouseButtonCallback(RGFW_root, RGFW_events[RGFW_eventLen].button, RGFW_events[RGFW_eventLen].scroll, 1);
 	RGFW_eventLen++;
@@ -8385,8 +10171,7 @@ EM_BOOL Emscripten_on_mouseup(int eventType, const EmscriptenMouseEvent* e, void
 	RGFW_events[RGFW_eventLen].button = e->button + 1; 
 	RGFW_events[RGFW_eventLen].scroll = 0;
 
-	RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].prev = RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current;	
-	RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current = 0;
+	RGFW_window_setMouseButton(RGFW_root, RGFW_events[RGFW_eventLen].button, 0);
 
 	RGFW_mouseButtonCallback(RGFW_root, RGFW_events[RGFW_eventLen].button, RGFW_events[RGFW_eventLen].scroll, 0);
 	RGFW_eventLen++;
@@ -8401,8 +10186,7 @@ EM_BOOL Emscripten_on_wheel(int eventType, const EmscriptenWheelEvent* e, void*
 	RGFW_events[RGFW_eventLen].button = RGFW_mouseScrollUp + (e->deltaY < 0); 
 	RGFW_events[RGFW_eventLen].scroll = e->deltaY;
 
-	RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].prev = RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current;	
-	RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current = 1;
+	RGFW_window_setMouseButton(RGFW_root, RGFW_events[RGFW_eventLen].button, 1);
 
 	RGFW_mouseButtonCallback(RGFW_root, RGFW_events[RGFW_eventLen].button, RGFW_events[RGFW_eventLen].scroll, 1);
 	RGFW_eventLen++;
@@ -8421,8 +10205,7 @@ EM_BOOL Emscripten_on_touchstart(int eventType, const EmscriptenTouchEvent* e, v
 	    RGFW_events[RGFW_eventLen].scroll = 0;
 
 
-	    RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].prev = RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current;	
-	    RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current = 1;
+	    RGFW_window_setMouseButton(RGFW_root, RGFW_events[RGFW_eventLen].button, 1);
 
         RGFW_mousePosCallback(RGFW_root, RGFW_events[RGFW_eventLen].point);
 
@@ -8456,8 +10239,7 @@ EM_BOOL Emscripten_on_touchend(int eventType, const EmscriptenTouchEvent* e, voi
 	    RGFW_events[RGFW_eventLen].button = 1; 
 	    RGFW_events[RGFW_eventLen].scroll = 0;
 
-	    RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].prev = RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current;	
-	    RGFW_mouseButtons[RGFW_events[RGFW_eventLen].button].current = 0;
+	    RGFW_window_setMouseButton(RGFW_root, RGFW_events[RGFW_eventLen].button, 0);
         
 	    RGFW_mouseButtonCallback(RGFW_root, RGFW_events[RGFW_eventLen].button, RGFW_events[RGFW_eventLen].scroll, 0);
 	    RGFW_eventLen++;
@@ -8482,8 +10264,12 @@ void EMSCRIPTEN_KEEPALIVE Emscripten_onDrop(size_t count) {
 	if (!(RGFW_root->_winArgs & RGFW_ALLOW_DND))
 		return;
 
-	RGFW_events[RGFW_eventLen].droppedFilesCount = count;	
-	RGFW_dndCallback(RGFW_root, RGFW_events[RGFW_eventLen].droppedFiles, count);
+	RGFW_UNUSED(count);
+	RGFW_window_endDrop(RGFW_root);
+
+	RGFW_events[RGFW_eventLen].droppedFiles = RGFW_root->event.droppedFiles;
+	RGFW_events[RGFW_eventLen].droppedFilesCount = RGFW_root->event.droppedFilesCount;	
+	RGFW_dndCallback(RGFW_root, RGFW_root->event.droppedFiles, RGFW_root->event.droppedFilesCount);
 	RGFW_eventLen++;
 }
 
@@ -8492,6 +10278,9 @@ void RGFW_stopCheckEvents(void) {
 	RGFW_stopCheckEvents_bool = RGFW_TRUE;
 }
 
+/* there's only one thread */
+void RGFW_window_stopCheckEvents(RGFW_window* win) { RGFW_UNUSED(win); RGFW_stopCheckEvents(); }
+
 void RGFW_window_eventWait(RGFW_window* win, i32 waitMS) {
 	RGFW_UNUSED(win);
 
@@ -8526,14 +10315,12 @@ void RGFW_init_buffer(RGFW_window* win) {
 }
 
 void EMSCRIPTEN_KEEPALIVE RGFW_makeSetValue(size_t index, char* file) { 
-	/* This seems like a terrible idea, don't replicate this unless you hate yourself or the OS */
-	/* TODO: find a better way to do this, 
-		strcpy doesn't seem to work, maybe because of asyncio
-	*/
+	/* the js side frees file after Emscripten_onDrop, so it's copied into the window's drop arena */
+	if (index == 0)
+		RGFW_window_beginDrop(RGFW_root);
 
 	RGFW_events[RGFW_eventLen].type = RGFW_dnd;
-	char** arr = (char**)&RGFW_events[RGFW_eventLen].droppedFiles[index];
-	*arr = file;
+	RGFW_window_addDrop(RGFW_root, file, strlen(file));
 }
 
 #include <sys/stat.h>
@@ -8688,7 +10475,7 @@ RGFW_Event* RGFW_window_checkEvent(RGFW_window* win) {
 	static u8 index = 0;
 	
 	if (index == 0) 
-		RGFW_resetKey();
+		RGFW_window_resetKeys(win);
 
 	/* check gamepads */
     for (int i = 0; (i < emscripten_get_num_gamepads()) && (i < 4); i++) {
@@ -8739,8 +10526,6 @@ RGFW_Event* RGFW_window_checkEvent(RGFW_window* win) {
 	if (RGFW_eventLen == 0)
 		return NULL;
 	
-	RGFW_events[index].frameTime = win->event.frameTime;
-	RGFW_events[index].frameTime2 = win->event.frameTime2;
 	RGFW_events[index].inFocus = win->event.inFocus;
 
 	win->event = RGFW_events[index];
@@ -8957,6 +10742,7 @@ void RGFW_window_setName(RGFW_window* win, char* name) {
 
 /* unsupported functions */
 RGFW_monitor* RGFW_getMonitors(void) { return NULL; }
+u32 RGFW_getMonitorCount(void) { return 0; }
 RGFW_monitor RGFW_getPrimaryMonitor(void) { return (RGFW_monitor){}; }
 void RGFW_window_move(RGFW_window* win, RGFW_point v) { RGFW_UNUSED(win) RGFW_UNUSED(v) }
 void RGFW_window_setMinSize(RGFW_window* win, RGFW_area a) { RGFW_UNUSED(win) RGFW_UNUSED(a)  }
@@ -8983,10 +10769,8 @@ RGFW_monitor RGFW_window_getMonitor(RGFW_window* win) { RGFW_UNUSED(win) return
 #include <pthread.h>
 
 	RGFW_thread RGFW_createThread(RGFW_threadFunc_ptr ptr, void* args) {
-		RGFW_UNUSED(args);
-		
 		RGFW_thread t;
-		pthread_create((pthread_t*) &t, NULL, *ptr, NULL);
+		pthread_create((pthread_t*) &t, NULL, *ptr, args);
 		return t;
 	}
 	void RGFW_cancelThread(RGFW_thread thread) { pthread_cancel((pthread_t) thread); }
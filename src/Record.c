@@ -0,0 +1,450 @@
+//
+//  Record.c
+//  LabExcelsior
+//
+//  Session recording and replay, see Record.h
+//
+
+#include "Record.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define LAB_RECORD_VERSION 2     // 1 had whole pixel positions and no samples
+
+#define LAB_RECORD_SUBPIXEL 256.0f
+#define LAB_RECORD_MAX_SAMPLES 4096     // per event, anything more is a damaged file
+
+enum {
+    LAB_RECORD_TAG_EVENT = 1,
+    LAB_RECORD_TAG_TRANSACTION,
+    LAB_RECORD_TAG_FRAME,
+};
+
+static const char LabRecordMagic[4] = { 'L', 'R', 'E', 'C' };
+
+static uint64_t LabRecordNow(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static size_t LabRecordPutVarint(uint8_t* p, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// small negative numbers stay small
+static uint64_t LabRecordZigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t LabRecordUnzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static int64_t LabRecordFixed(float v) {
+    v *= LAB_RECORD_SUBPIXEL;
+    return (int64_t)(v < 0 ? v - 0.5f : v + 0.5f);
+}
+
+
+struct LabRecorder {
+    FILE* file;
+    uint64_t start;         // ns, LabRecordNow
+    uint64_t last;          // us since start, of the previous record
+    int open;               // there are records since the last frame
+    LabRecordStats stats;
+};
+
+LabRecorder* LabRecorderCreate(const char* path, unsigned int width, unsigned int height) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+        return NULL;
+
+    LabRecorder* r = (LabRecorder*)calloc(1, sizeof(LabRecorder));
+    if (r == NULL) {
+        fclose(file);
+        return NULL;
+    }
+
+    r->file = file;
+    r->start = LabRecordNow();
+
+    uint8_t header[4 + 3 * 10];
+    size_t n = sizeof(LabRecordMagic);
+    memcpy(header, LabRecordMagic, n);
+    n += LabRecordPutVarint(header + n, LAB_RECORD_VERSION);
+    n += LabRecordPutVarint(header + n, width);
+    n += LabRecordPutVarint(header + n, height);
+    fwrite(header, 1, n, r->file);
+    r->stats.bytes = n;
+
+    return r;
+}
+
+void LabRecorderDestroy(LabRecorder* r) {
+    if (r == NULL)
+        return;
+    if (r->open)
+        LabRecorderFrame(r, 0);
+    fclose(r->file);
+    free(r);
+}
+
+// the tag and the time since the previous record, returns the record's time in us
+static size_t LabRecorderBegin(LabRecorder* r, uint8_t* p, int tag, uint64_t* us) {
+    uint64_t now = (LabRecordNow() - r->start) / 1000ull;
+    if (now < r->last)
+        now = r->last;
+
+    p[0] = (uint8_t)tag;
+    size_t n = 1 + LabRecordPutVarint(p + 1, now - r->last);
+    r->last = now;
+    r->open = 1;
+    *us = now;
+    return n;
+}
+
+static void LabRecorderWrite(LabRecorder* r, const void* data, size_t size) {
+    fwrite(data, 1, size, r->file);
+    r->stats.bytes += size;
+}
+
+void LabRecorderEvent(LabRecorder* r, LabRecordEvent* event) {
+    uint8_t record[256];
+    uint64_t us;
+    size_t n = LabRecorderBegin(r, record, LAB_RECORD_TAG_EVENT, &us);
+
+    // what the replay will see, to the microsecond
+    event->time = us * 1000ull;
+
+    record[n++] = event->type;
+    record[n++] = event->button;
+    record[n++] = event->flags;
+    n += LabRecordPutVarint(record + n, event->key);
+    n += LabRecordPutVarint(record + n, LabRecordZigzag(LabRecordFixed(event->x)));
+    n += LabRecordPutVarint(record + n, LabRecordZigzag(LabRecordFixed(event->y)));
+    n += LabRecordPutVarint(record + n, event->sampleCount);
+
+    // each sample relative to the one before, the first to the event
+    int64_t x = LabRecordFixed(event->x), y = LabRecordFixed(event->y), t = 0;
+    unsigned int i;
+    for (i = 0; i < event->sampleCount; i++) {
+        const LabRecordSample* sample = &event->samples[i];
+        int64_t sx = LabRecordFixed(sample->x), sy = LabRecordFixed(sample->y);
+        int64_t st = (int64_t)(sample->t * 1e6);
+        if (n > sizeof(record) - 3 * 10) {
+            LabRecorderWrite(r, record, n);
+            n = 0;
+        }
+        n += LabRecordPutVarint(record + n, LabRecordZigzag(sx - x));
+        n += LabRecordPutVarint(record + n, LabRecordZigzag(sy - y));
+        n += LabRecordPutVarint(record + n, LabRecordZigzag(st - t));
+        x = sx;
+        y = sy;
+        t = st;
+    }
+    LabRecorderWrite(r, record, n);
+
+    r->stats.events++;
+    r->stats.duration = us * 1000ull;
+}
+
+void LabRecorderTransaction(LabRecorder* r, const char* message) {
+    uint8_t record[32];
+    uint64_t us;
+    size_t length = message ? strlen(message) : 0;
+    size_t n = LabRecorderBegin(r, record, LAB_RECORD_TAG_TRANSACTION, &us);
+
+    n += LabRecordPutVarint(record + n, length);
+    LabRecorderWrite(r, record, n);
+    LabRecorderWrite(r, message, length);
+
+    r->stats.transactions++;
+    r->stats.duration = us * 1000ull;
+}
+
+void LabRecorderFrame(LabRecorder* r, int flags) {
+    uint8_t record[16];
+    uint64_t us;
+    size_t n = LabRecorderBegin(r, record, LAB_RECORD_TAG_FRAME, &us);
+
+    record[n++] = (uint8_t)flags;
+    LabRecorderWrite(r, record, n);
+
+    r->open = 0;
+    r->stats.frames++;
+    r->stats.duration = us * 1000ull;
+}
+
+void LabRecorderGetStats(const LabRecorder* r, LabRecordStats* stats) {
+    *stats = r->stats;
+}
+
+
+struct LabReplay {
+    uint8_t* data;
+    size_t size, pos;
+    unsigned int version, width, height;
+    uint64_t time;                  // us, of the last record read
+    uint64_t paceStart;             // ns, LabRecordNow at the first LabReplayPace
+
+    // the current frame's
+    LabRecordEvent* events;
+    unsigned int eventCapacity;
+    LabRecordSample* samples;
+    unsigned int sampleCount, sampleCapacity;
+    const char** transactions;
+    size_t* offsets;                // into text, until the frame is complete
+    unsigned int transactionCapacity;
+    char* text;
+    size_t textSize, textCapacity;
+
+    LabRecordStats stats;
+};
+
+static int LabReplayVarint(LabReplay* r, uint64_t* v) {
+    int shift;
+    *v = 0;
+    for (shift = 0; shift < 64 && r->pos < r->size; shift += 7) {
+        uint8_t b = r->data[r->pos++];
+        *v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return 1;
+    }
+    return 0;
+}
+
+static int LabReplayByte(LabReplay* r, uint8_t* v) {
+    if (r->pos >= r->size)
+        return 0;
+    *v = r->data[r->pos++];
+    return 1;
+}
+
+// makes room for n more of size in *array, doubling
+static int LabReplayReserve(void** array, unsigned int* capacity, unsigned int count, size_t size) {
+    if (count < *capacity)
+        return 1;
+
+    unsigned int grown = *capacity ? *capacity * 2 : 64;
+    void* p = realloc(*array, grown * size);
+    if (p == NULL)
+        return 0;
+    *array = p;
+    *capacity = grown;
+    return 1;
+}
+
+LabReplay* LabReplayOpen(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+        return NULL;
+
+    LabReplay* r = (LabReplay*)calloc(1, sizeof(LabReplay));
+    long size = -1;
+    if (r != NULL && fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        r->data = (uint8_t*)malloc((size_t)size);
+        if (r->data != NULL && fread(r->data, 1, (size_t)size, file) == (size_t)size)
+            r->size = (size_t)size;
+    }
+    fclose(file);
+
+    if (r == NULL || r->size < sizeof(LabRecordMagic) || memcmp(r->data, LabRecordMagic, sizeof(LabRecordMagic)) != 0) {
+        LabReplayClose(r);
+        return NULL;
+    }
+
+    uint64_t version = 0, width = 0, height = 0;
+    r->pos = sizeof(LabRecordMagic);
+    if (!LabReplayVarint(r, &version) || version < 1 || version > LAB_RECORD_VERSION ||
+        !LabReplayVarint(r, &width) || !LabReplayVarint(r, &height)) {
+        LabReplayClose(r);
+        return NULL;
+    }
+
+    r->version = (unsigned int)version;
+    r->width = (unsigned int)width;
+    r->height = (unsigned int)height;
+    return r;
+}
+
+void LabReplayClose(LabReplay* r) {
+    if (r == NULL)
+        return;
+    free(r->data);
+    free(r->events);
+    free(r->samples);
+    free(r->transactions);
+    free(r->offsets);
+    free(r->text);
+    free(r);
+}
+
+void LabReplaySize(const LabReplay* r, unsigned int* width, unsigned int* height) {
+    *width = r->width;
+    *height = r->height;
+}
+
+static void LabReplayFinishFrame(LabReplay* r, LabReplayFrame* frame, unsigned int events, unsigned int transactions, int flags) {
+    unsigned int i, sample = 0;
+    for (i = 0; i < transactions; i++)
+        r->transactions[i] = r->text + r->offsets[i];
+
+    // the samples array moves as it grows, so the events only point into it once the frame is read
+    for (i = 0; i < events; i++) {
+        r->events[i].samples = r->events[i].sampleCount ? r->samples + sample : NULL;
+        sample += r->events[i].sampleCount;
+    }
+
+    frame->time = r->time * 1000ull;
+    frame->flags = flags;
+    frame->events = r->events;
+    frame->eventCount = events;
+    frame->transactions = r->transactions;
+    frame->transactionCount = transactions;
+
+    r->stats.frames++;
+    r->stats.bytes = r->pos;
+    r->stats.duration = frame->time;
+}
+
+int LabReplayNext(LabReplay* r, LabReplayFrame* frame) {
+    unsigned int events = 0, transactions = 0;
+    r->textSize = 0;
+    r->sampleCount = 0;
+
+    while (r->pos < r->size) {
+        uint8_t tag, flags;
+        uint64_t dt;
+        if (!LabReplayByte(r, &tag) || !LabReplayVarint(r, &dt))
+            return -1;
+        r->time += dt;
+
+        if (tag == LAB_RECORD_TAG_EVENT) {
+            uint64_t key, x, y, count = 0;
+            if (!LabReplayReserve((void**)&r->events, &r->eventCapacity, events, sizeof(LabRecordEvent)))
+                return -1;
+
+            LabRecordEvent* e = &r->events[events];
+            if (!LabReplayByte(r, &e->type) || !LabReplayByte(r, &e->button) || !LabReplayByte(r, &e->flags) ||
+                !LabReplayVarint(r, &key) || !LabReplayVarint(r, &x) || !LabReplayVarint(r, &y) ||
+                (r->version >= 2 && !LabReplayVarint(r, &count)) || count > LAB_RECORD_MAX_SAMPLES)
+                return -1;
+
+            float scale = r->version >= 2 ? LAB_RECORD_SUBPIXEL : 1.0f;
+            int64_t sx = LabRecordUnzigzag(x), sy = LabRecordUnzigzag(y), st = 0;
+            e->time = r->time * 1000ull;
+            e->key = (uint32_t)key;
+            e->x = (float)sx / scale;
+            e->y = (float)sy / scale;
+            e->samples = NULL;
+            e->sampleCount = (unsigned int)count;
+
+            for (; count; count--) {
+                uint64_t dx, dy, dt;
+                if (!LabReplayReserve((void**)&r->samples, &r->sampleCapacity, r->sampleCount, sizeof(LabRecordSample)) ||
+                    !LabReplayVarint(r, &dx) || !LabReplayVarint(r, &dy) || !LabReplayVarint(r, &dt))
+                    return -1;
+
+                LabRecordSample* sample = &r->samples[r->sampleCount++];
+                sx += LabRecordUnzigzag(dx);
+                sy += LabRecordUnzigzag(dy);
+                st += LabRecordUnzigzag(dt);
+                sample->x = (float)sx / scale;
+                sample->y = (float)sy / scale;
+                sample->t = (double)st / 1e6;
+            }
+            events++;
+            r->stats.events++;
+        }
+        else if (tag == LAB_RECORD_TAG_TRANSACTION) {
+            uint64_t length;
+            if (!LabReplayVarint(r, &length) || length > r->size - r->pos)
+                return -1;
+
+            unsigned int capacity = r->transactionCapacity;
+            if (!LabReplayReserve((void**)&r->transactions, &capacity, transactions, sizeof(const char*)) ||
+                !LabReplayReserve((void**)&r->offsets, &r->transactionCapacity, transactions, sizeof(size_t)))
+                return -1;
+
+            if (r->textSize + length + 1 > r->textCapacity) {
+                size_t grown = (r->textSize + length + 1) * 2;
+                char* p = (char*)realloc(r->text, grown);
+                if (p == NULL)
+                    return -1;
+                r->text = p;
+                r->textCapacity = grown;
+            }
+
+            r->offsets[transactions++] = r->textSize;
+            memcpy(r->text + r->textSize, r->data + r->pos, (size_t)length);
+            r->textSize += (size_t)length;
+            r->text[r->textSize++] = '\0';
+            r->pos += (size_t)length;
+            r->stats.transactions++;
+        }
+        else if (tag == LAB_RECORD_TAG_FRAME) {
+            if (!LabReplayByte(r, &flags))
+                return -1;
+            LabReplayFinishFrame(r, frame, events, transactions, flags);
+            return 1;
+        }
+        else
+            return -1;
+    }
+
+    // the recording stopped before the frame ended
+    if (events || transactions) {
+        LabReplayFinishFrame(r, frame, events, transactions, 0);
+        return 1;
+    }
+    return 0;
+}
+
+void LabReplayPace(LabReplay* r, uint64_t time) {
+    uint64_t now = LabRecordNow();
+    if (r->paceStart == 0)
+        r->paceStart = now - time;
+
+    uint64_t when = r->paceStart + time;
+    if (when <= now)
+        return;
+
+    uint64_t ns = when - now;
+#ifdef _WIN32
+    Sleep((DWORD)(ns / 1000000ull));
+#else
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000ull);
+    ts.tv_nsec = (long)(ns % 1000000000ull);
+    nanosleep(&ts, NULL);
+#endif
+}
+
+void LabReplayGetStats(const LabReplay* r, LabRecordStats* stats) {
+    *stats = r->stats;
+}
@@ -0,0 +1,126 @@
+//
+//  Record.h
+//  LabExcelsior
+//
+//  Session recording and replay, for repeatable performance runs.
+//
+
+
+/*
+ LabRecorder writes what the frame loop saw to a file: every input event as
+ it was drained, with its time, the transactions the mode manager ran, and
+ where each frame ended and whether it was drawn.
+
+     recorder = LabRecorderCreate("session.lrec", width, height);
+
+     loop:
+         for each event:
+             LabRecorderEvent(recorder, &event)
+             hand the event to the modes
+         update the modes                LabRecorderTransaction for each one that ran
+         LabRecorderFrame(recorder, flags)
+         render if the frame is drawn
+
+ LabReplay reads it back a frame at a time, so a driver can feed the same
+ events to a mode manager without a window, either at the recorded pace
+ (LabReplayPace before each frame) or as fast as it can. Transactions can't
+ be stored, they are closures; the replay produces its own from the events,
+ and the recorded messages are there to check they are the same ones.
+
+ The file is a header and a stream of records, each a tag byte, the time
+ since the previous record in microseconds, and the record's fields, all
+ integers as LEB128 varints. Positions are fixed point, 1/256 of a pixel, so
+ the sub-pixel mouse samples survive; a mouse move is about a dozen bytes and
+ each of its samples a few more.
+ */
+
+#ifndef Record_h
+#define Record_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// one of the pointer positions a coalesced mouse move went through
+typedef struct LabRecordSample {
+    float x, y;             // same space as LabRecordEvent::x, y
+    double t;               // seconds, only meaningful relative to other samples
+} LabRecordSample;
+
+// an input event as the application handles it, not tied to the windowing library
+typedef struct LabRecordEvent {
+    uint64_t time;          // ns since the recording started, set by LabRecorderEvent
+    uint8_t type;           // the windowing library's event type
+    uint8_t button;
+    uint8_t flags;          // LAB_RECORD_LEFT_HELD
+    uint32_t key;
+    float x, y;             // the pointer, or the new size for a resize
+    const LabRecordSample* samples;     // a mouse move's samples, oldest first
+    unsigned int sampleCount;
+} LabRecordEvent;
+
+enum {
+    LAB_RECORD_LEFT_HELD = 1 << 0,          // the left button was down after the event, following the batch's press and release events
+};
+
+enum {
+    LAB_RECORD_FRAME_DRAWN     = 1 << 0,    // the frame was rendered
+    LAB_RECORD_FRAME_ANIMATING = 1 << 1,    // continuous rendering was on
+};
+
+typedef struct LabRecordStats {
+    unsigned int frames, events, transactions;
+    uint64_t bytes;
+    uint64_t duration;      // ns, to the last record
+} LabRecordStats;
+
+typedef struct LabRecorder LabRecorder;
+
+// width and height of the window when recording starts, NULL if path can't be written
+LabRecorder* LabRecorderCreate(const char* path, unsigned int width, unsigned int height);
+
+// ends the last frame if it is open, and closes the file
+void LabRecorderDestroy(LabRecorder*);
+
+void LabRecorderEvent(LabRecorder*, LabRecordEvent* event);
+void LabRecorderTransaction(LabRecorder*, const char* message);
+void LabRecorderFrame(LabRecorder*, int flags);
+
+void LabRecorderGetStats(const LabRecorder*, LabRecordStats*);
+
+typedef struct LabReplayFrame {
+    uint64_t time;                      // ns since the recording started, when the frame ended
+    int flags;                          // LAB_RECORD_FRAME_DRAWN, ...
+    const LabRecordEvent* events;
+    unsigned int eventCount;
+    const char* const* transactions;    // messages, in the order they ran
+    unsigned int transactionCount;
+} LabReplayFrame;
+
+typedef struct LabReplay LabReplay;
+
+// NULL if path can't be read or isn't a recording
+LabReplay* LabReplayOpen(const char* path);
+void       LabReplayClose(LabReplay*);
+
+// the window size the recording started with
+void LabReplaySize(const LabReplay*, unsigned int* width, unsigned int* height);
+
+// the next frame, valid until the next call. 1 for a frame, 0 at the end,
+// -1 if the file is cut short or damaged
+int LabReplayNext(LabReplay*, LabReplayFrame* frame);
+
+// sleeps until time (LabReplayFrame::time) comes around again, counted
+// from the first call
+void LabReplayPace(LabReplay*, uint64_t time);
+
+// what has been read so far
+void LabReplayGetStats(const LabReplay*, LabRecordStats*);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* Record_h */
@@ -0,0 +1,276 @@
+//
+//  StreamBuffer.c
+//  LabExcelsior
+//
+//  Per-frame streaming of dynamic geometry to the GPU, see StreamBuffer.h
+//
+
+#include "StreamBuffer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__APPLE__)
+    #ifndef GL_SILENCE_DEPRECATION
+        #define GL_SILENCE_DEPRECATION
+    #endif
+    #include <OpenGL/gl.h>
+#else
+    #ifdef _WIN32
+        #define WIN32_LEAN_AND_MEAN
+        #include <windows.h>
+    #endif
+    #include <GL/gl.h>
+#endif
+
+#define LAB_STREAM_REGIONS 3    // frames in flight
+#define LAB_STREAM_ALIGN 256    // regions start on a boundary any attribute or index type is happy with
+
+/* the GL 1.5 - 4.4 bits used here, so no glext.h is needed */
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#define LAB_GL_ARRAY_BUFFER 0x8892
+#define LAB_GL_STREAM_DRAW 0x88E0
+#define LAB_GL_NUM_EXTENSIONS 0x821D
+#define LAB_GL_MAP_WRITE_BIT 0x0002
+#define LAB_GL_MAP_PERSISTENT_BIT 0x0040
+#define LAB_GL_MAP_COHERENT_BIT 0x0080
+#define LAB_GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define LAB_GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define LAB_GL_ALREADY_SIGNALED 0x911A
+#define LAB_GL_TIMEOUT_EXPIRED 0x911B
+
+typedef struct __GLsync* LabGLsync;
+
+typedef void (APIENTRY* LabGenBuffersFunc)(GLsizei, GLuint*);
+typedef void (APIENTRY* LabDeleteBuffersFunc)(GLsizei, const GLuint*);
+typedef void (APIENTRY* LabBindBufferFunc)(GLenum, GLuint);
+typedef void (APIENTRY* LabBufferDataFunc)(GLenum, ptrdiff_t, const void*, GLenum);
+typedef void (APIENTRY* LabBufferSubDataFunc)(GLenum, ptrdiff_t, ptrdiff_t, const void*);
+typedef void (APIENTRY* LabBufferStorageFunc)(GLenum, ptrdiff_t, const void*, GLbitfield);
+typedef void* (APIENTRY* LabMapBufferRangeFunc)(GLenum, ptrdiff_t, ptrdiff_t, GLbitfield);
+typedef GLboolean (APIENTRY* LabUnmapBufferFunc)(GLenum);
+typedef LabGLsync (APIENTRY* LabFenceSyncFunc)(GLenum, GLbitfield);
+typedef GLenum (APIENTRY* LabClientWaitSyncFunc)(LabGLsync, GLbitfield, uint64_t);
+typedef void (APIENTRY* LabDeleteSyncFunc)(LabGLsync);
+typedef const GLubyte* (APIENTRY* LabGetStringiFunc)(GLenum, GLuint);
+
+struct LabStreamBuffer {
+    GLuint buffer;
+    size_t regionSize;
+    unsigned int region;
+    size_t offset;              // bump pointer within the region
+    size_t flushed;             // bytes of the region already uploaded, subdata path only
+    int inFrame;
+
+    unsigned char* mapped;      // the whole buffer when persistent, else NULL
+    unsigned char* staging;     // one region of CPU memory on the subdata path
+
+    LabGLsync fence[LAB_STREAM_REGIONS];
+    unsigned long long stalls;
+
+    LabGenBuffersFunc genBuffers;
+    LabDeleteBuffersFunc deleteBuffers;
+    LabBindBufferFunc bindBuffer;
+    LabBufferDataFunc bufferData;
+    LabBufferSubDataFunc bufferSubData;
+    LabBufferStorageFunc bufferStorage;
+    LabMapBufferRangeFunc mapBufferRange;
+    LabUnmapBufferFunc unmapBuffer;
+    LabFenceSyncFunc fenceSync;            // NULL before GL 3.2, the regions are then only implicitly synchronized
+    LabClientWaitSyncFunc clientWaitSync;
+    LabDeleteSyncFunc deleteSync;
+};
+
+// GL 4.4, or the extension; a loader alone can't tell, GLX hands out pointers for anything
+static int LabStreamHasBufferStorage(LabGLLoader load) {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+    if (version != NULL && sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 4 || (major == 4 && minor >= 4)))
+        return 1;
+
+    // compatibility contexts still have the one string, core ones only have glGetStringi
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (extensions != NULL)
+        return strstr(extensions, "GL_ARB_buffer_storage") != NULL;
+
+    LabGetStringiFunc getStringi = (LabGetStringiFunc)load("glGetStringi");
+    if (getStringi == NULL)
+        return 0;
+
+    GLint count = 0;
+    glGetIntegerv(LAB_GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* name = (const char*)getStringi(GL_EXTENSIONS, (GLuint)i);
+        if (name != NULL && strcmp(name, "GL_ARB_buffer_storage") == 0)
+            return 1;
+    }
+    return 0;
+}
+
+LabStreamBuffer* LabStreamBufferCreate(LabGLLoader load, size_t frameBytes, int flags) {
+    if (load == NULL || frameBytes == 0)
+        return NULL;
+
+    LabStreamBuffer* sb = (LabStreamBuffer*)calloc(1, sizeof(LabStreamBuffer));
+    if (sb == NULL)
+        return NULL;
+
+    sb->genBuffers = (LabGenBuffersFunc)load("glGenBuffers");
+    sb->deleteBuffers = (LabDeleteBuffersFunc)load("glDeleteBuffers");
+    sb->bindBuffer = (LabBindBufferFunc)load("glBindBuffer");
+    sb->bufferData = (LabBufferDataFunc)load("glBufferData");
+    sb->bufferSubData = (LabBufferSubDataFunc)load("glBufferSubData");
+    sb->fenceSync = (LabFenceSyncFunc)load("glFenceSync");
+    sb->clientWaitSync = (LabClientWaitSyncFunc)load("glClientWaitSync");
+    sb->deleteSync = (LabDeleteSyncFunc)load("glDeleteSync");
+
+    if (!sb->genBuffers || !sb->deleteBuffers || !sb->bindBuffer || !sb->bufferData || !sb->bufferSubData) {
+        free(sb);
+        return NULL;
+    }
+
+    if (!sb->fenceSync || !sb->clientWaitSync || !sb->deleteSync)
+        sb->fenceSync = NULL;
+
+    sb->regionSize = (frameBytes + LAB_STREAM_ALIGN - 1) & ~(size_t)(LAB_STREAM_ALIGN - 1);
+    size_t size = sb->regionSize * LAB_STREAM_REGIONS;
+
+    sb->genBuffers(1, &sb->buffer);
+    sb->bindBuffer(LAB_GL_ARRAY_BUFFER, sb->buffer);
+
+    if (!(flags & LAB_STREAM_SUBDATA) && sb->fenceSync != NULL && LabStreamHasBufferStorage(load)) {
+        sb->bufferStorage = (LabBufferStorageFunc)load("glBufferStorage");
+        sb->mapBufferRange = (LabMapBufferRangeFunc)load("glMapBufferRange");
+        sb->unmapBuffer = (LabUnmapBufferFunc)load("glUnmapBuffer");
+
+        if (sb->bufferStorage && sb->mapBufferRange && sb->unmapBuffer) {
+            GLbitfield access = LAB_GL_MAP_WRITE_BIT | LAB_GL_MAP_PERSISTENT_BIT | LAB_GL_MAP_COHERENT_BIT;
+            sb->bufferStorage(LAB_GL_ARRAY_BUFFER, (ptrdiff_t)size, NULL, access);
+            sb->mapped = (unsigned char*)sb->mapBufferRange(LAB_GL_ARRAY_BUFFER, 0, (ptrdiff_t)size, access);
+
+            if (sb->mapped == NULL) {
+                // storage is immutable, start over with a buffer the fallback can respecify
+                sb->deleteBuffers(1, &sb->buffer);
+                sb->genBuffers(1, &sb->buffer);
+                sb->bindBuffer(LAB_GL_ARRAY_BUFFER, sb->buffer);
+            }
+        }
+    }
+
+    if (sb->mapped == NULL) {
+        sb->staging = (unsigned char*)malloc(sb->regionSize);
+        if (sb->staging == NULL) {
+            sb->bindBuffer(LAB_GL_ARRAY_BUFFER, 0);
+            LabStreamBufferDestroy(sb);
+            return NULL;
+        }
+        sb->bufferData(LAB_GL_ARRAY_BUFFER, (ptrdiff_t)size, NULL, LAB_GL_STREAM_DRAW);
+    }
+
+    sb->bindBuffer(LAB_GL_ARRAY_BUFFER, 0);
+    sb->region = LAB_STREAM_REGIONS - 1; // the first BeginFrame moves to region 0
+    return sb;
+}
+
+void LabStreamBufferBeginFrame(LabStreamBuffer* sb) {
+    if (sb->inFrame)
+        LabStreamBufferEndFrame(sb);
+
+    sb->region = (sb->region + 1) % LAB_STREAM_REGIONS;
+    sb->offset = 0;
+    sb->flushed = 0;
+    sb->inFrame = 1;
+
+    LabGLsync fence = sb->fence[sb->region];
+    if (fence == NULL)
+        return;
+
+    // usually signalled long ago, so poll before flushing and blocking
+    GLenum status = sb->clientWaitSync(fence, 0, 0);
+    if (status == LAB_GL_TIMEOUT_EXPIRED) {
+        sb->stalls++;
+        do
+            status = sb->clientWaitSync(fence, LAB_GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        while (status == LAB_GL_TIMEOUT_EXPIRED);
+    }
+
+    sb->deleteSync(fence);
+    sb->fence[sb->region] = NULL;
+}
+
+void* LabStreamBufferAlloc(LabStreamBuffer* sb, size_t size, size_t align, size_t* offset) {
+    if (align == 0)
+        align = 1;
+
+    size_t start = (sb->offset + align - 1) & ~(align - 1);
+    if (start > sb->regionSize || size > sb->regionSize - start)
+        return NULL;
+
+    sb->offset = start + size;
+    if (offset != NULL)
+        *offset = sb->region * sb->regionSize + start;
+
+    if (sb->mapped != NULL)
+        return sb->mapped + sb->region * sb->regionSize + start;
+
+    return sb->staging + start;
+}
+
+void LabStreamBufferFlush(LabStreamBuffer* sb) {
+    // coherent mappings need nothing, the writes are visible to commands issued after them
+    if (sb->mapped != NULL || sb->offset == sb->flushed)
+        return;
+
+    sb->bindBuffer(LAB_GL_ARRAY_BUFFER, sb->buffer);
+    sb->bufferSubData(LAB_GL_ARRAY_BUFFER, (ptrdiff_t)(sb->region * sb->regionSize + sb->flushed),
+                      (ptrdiff_t)(sb->offset - sb->flushed), sb->staging + sb->flushed);
+    sb->bindBuffer(LAB_GL_ARRAY_BUFFER, 0);
+    sb->flushed = sb->offset;
+}
+
+void LabStreamBufferEndFrame(LabStreamBuffer* sb) {
+    if (!sb->inFrame)
+        return;
+
+    LabStreamBufferFlush(sb);
+    sb->inFrame = 0;
+
+    if (sb->fenceSync != NULL && sb->offset != 0)
+        sb->fence[sb->region] = sb->fenceSync(LAB_GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+unsigned int LabStreamBufferName(const LabStreamBuffer* sb) {
+    return sb->buffer;
+}
+
+int LabStreamBufferPersistent(const LabStreamBuffer* sb) {
+    return sb->mapped != NULL;
+}
+
+unsigned long long LabStreamBufferStalls(const LabStreamBuffer* sb) {
+    return sb->stalls;
+}
+
+void LabStreamBufferDestroy(LabStreamBuffer* sb) {
+    if (sb == NULL)
+        return;
+
+    for (int i = 0; i < LAB_STREAM_REGIONS; i++)
+        if (sb->fence[i] != NULL)
+            sb->deleteSync(sb->fence[i]);
+
+    if (sb->mapped != NULL) {
+        sb->bindBuffer(LAB_GL_ARRAY_BUFFER, sb->buffer);
+        sb->unmapBuffer(LAB_GL_ARRAY_BUFFER);
+        sb->bindBuffer(LAB_GL_ARRAY_BUFFER, 0);
+    }
+
+    sb->deleteBuffers(1, &sb->buffer);
+    free(sb->staging);
+    free(sb);
+}
@@ -0,0 +1,84 @@
+//
+//  StreamBuffer.h
+//  LabExcelsior
+//
+//  Per-frame streaming of dynamic geometry to the GPU.
+//
+
+
+/*
+ A LabStreamBuffer is one GL buffer object split into three regions, one per
+ frame in flight. LabStreamBufferBeginFrame moves to the next region, waiting
+ on its fence only if the GPU is still reading the frame from three frames
+ ago, and LabStreamBufferAlloc bumps a pointer through it. Nothing is ever
+ reallocated, the way glBufferData every frame does.
+
+ With ARB_buffer_storage (GL 4.4) the buffer is mapped once, persistent and
+ coherent, and Alloc returns memory the GPU reads directly. Otherwise Alloc
+ returns staging memory, and LabStreamBufferFlush uploads what was written
+ since the last flush with glBufferSubData.
+
+     LabStreamBufferBeginFrame(sb);
+     size_t offset;
+     float* v = (float*)LabStreamBufferAlloc(sb, count * 8, 4, &offset);
+     ... write count x, y pairs to v ...
+     LabStreamBufferFlush(sb);
+     glBindBuffer(GL_ARRAY_BUFFER, LabStreamBufferName(sb));
+     glVertexPointer(2, GL_FLOAT, 0, (const void*)offset);
+     glDrawArrays(GL_POINTS, 0, count);
+     LabStreamBufferEndFrame(sb);
+
+ Modes get the frame's stream buffer in ViewInteraction::stream.
+ */
+
+#ifndef StreamBuffer_h
+#define StreamBuffer_h
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct LabStreamBuffer LabStreamBuffer;
+
+#ifndef LabGLLoader_defined
+#define LabGLLoader_defined
+typedef void* (*LabGLLoader)(const char* name);
+#endif
+
+enum {
+    LAB_STREAM_SUBDATA = 1 << 0,    // use the glBufferSubData path even if buffer storage is available
+};
+
+// call on the GL thread, frameBytes is the most one frame can allocate. NULL if
+// buffer objects aren't supported
+LabStreamBuffer* LabStreamBufferCreate(LabGLLoader load, size_t frameBytes, int flags);
+void             LabStreamBufferDestroy(LabStreamBuffer*);
+
+void LabStreamBufferBeginFrame(LabStreamBuffer*);
+
+// write-only memory for this frame, and its offset in the buffer object. align
+// must be a power of two. NULL if the frame's region is used up
+void* LabStreamBufferAlloc(LabStreamBuffer*, size_t size, size_t align, size_t* offset);
+
+// makes everything allocated so far visible to the GPU, call before drawing from it
+void LabStreamBufferFlush(LabStreamBuffer*);
+
+// flushes, and fences the frame's region so it's reused only once the GPU is done with it
+void LabStreamBufferEndFrame(LabStreamBuffer*);
+
+// the GL buffer object name, to bind as GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+unsigned int LabStreamBufferName(const LabStreamBuffer*);
+
+// 1 if the buffer is persistently mapped, 0 on the glBufferSubData path
+int LabStreamBufferPersistent(const LabStreamBuffer*);
+
+// how often BeginFrame had to wait for the GPU
+unsigned long long LabStreamBufferStalls(const LabStreamBuffer*);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* StreamBuffer_h */
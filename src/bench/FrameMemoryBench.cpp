@@ -0,0 +1,137 @@
+//
+//  FrameMemoryBench.cpp
+//  LabExcelsior
+//
+//  Heap allocations per frame with modes building their transient data on
+//  the heap, and in frame memory (FrameMemory.hpp).
+//
+
+#include "Modes.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+// every heap allocation in the process goes through here to be counted, the
+// containers' and the frame memory arenas' when they grow
+static std::atomic<size_t> gAllocations { 0 };
+
+void* operator new(size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+using namespace lab;
+
+namespace {
+
+bool gUseFrameMemory = false;
+
+struct Vertex { float x, y, z; };
+
+// builds a draw list and labels every frame, the sort of scratch data a
+// manipulator or overlay mode would make
+class ScratchMode : public MinorMode
+{
+public:
+    ScratchMode() = default;
+    static const char* sname() { return "Scratch"; }
+    const std::string Name() const override { return sname(); }
+
+    void Render(const ViewInteraction& vi) override {
+        if (gUseFrameMemory) {
+            auto mm = ModeManager::Canonical();
+            std::pmr::vector<Vertex> verts(mm->FrameMemory());
+            std::pmr::vector<std::pmr::string> labels(mm->FrameMemory());
+            Build(vi, verts, labels);
+        }
+        else {
+            std::vector<Vertex> verts;
+            std::vector<std::string> labels;
+            Build(vi, verts, labels);
+        }
+    }
+
+    float checksum = 0;
+
+private:
+    template <typename Verts, typename Labels>
+    void Build(const ViewInteraction& vi, Verts& verts, Labels& labels) {
+        for (int i = 0; i < 2000; i++)
+            verts.push_back({ vi.x + i, vi.y, 0.f });
+        for (int i = 0; i < 64; i++) {
+            labels.emplace_back("handle label that won't fit in place ");
+            labels.back() += std::to_string(i).c_str();
+        }
+        checksum += verts.back().x + (float)labels.back().size();
+    }
+};
+
+class ScratchMajorMode : public MajorMode
+{
+    std::vector<std::string> _modes { "Scratch" };
+
+public:
+    static const char* sname() { return "ScratchMajor"; }
+    const std::string Name() const override { return sname(); }
+    const std::vector<std::string>& ModeConfiguration() const override { return _modes; }
+};
+
+struct Result {
+    double perFrame;        // allocations
+    double us;              // per frame
+};
+
+Result Run(ModeManager& mm, int frames) {
+    ViewInteraction vi;
+    vi.view = { 1280, 720, 0, 0, 1280, 720 };
+
+    size_t allocations = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        vi.x = (float)f;
+        size_t before = gAllocations.load();
+        mm.UpdateTransactionQueueAndModes();
+        mm.RunViewportHovering(vi);
+        mm.RunModeRendering(vi);
+        allocations += gAllocations.load() - before;
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return { (double)allocations / frames, s * 1e6 / frames };
+}
+
+} // anon
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 2000;
+
+    ModeManager mm;
+    mm.RegisterMinorMode<ScratchMode>([]() { return std::make_shared<ScratchMode>(); });
+    mm.RegisterMajorMode<ScratchMajorMode>([]() { return std::make_shared<ScratchMajorMode>(); });
+    mm.ActivateMajorMode(ScratchMajorMode::sname());
+
+    // settle, the first frames activate the modes and size the arenas
+    gUseFrameMemory = true;
+    Run(mm, 10);
+    gUseFrameMemory = false;
+    Run(mm, 10);
+
+    printf("%d frames, 2000 vertices and 64 strings per frame\n", frames);
+
+    Result heap = Run(mm, frames);
+    printf("  heap          %8.1f allocations per frame  %8.2f us per frame\n", heap.perFrame, heap.us);
+
+    gUseFrameMemory = true;
+    Result frame = Run(mm, frames);
+    printf("  frame memory  %8.1f allocations per frame  %8.2f us per frame\n", frame.perFrame, frame.us);
+
+    return frame.perFrame == 0 ? 0 : 1;
+}
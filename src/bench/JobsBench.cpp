@@ -0,0 +1,94 @@
+//
+//  JobsBench.cpp
+//  LabExcelsior
+//
+//  Scaling of the job system (Jobs.hpp) from 1 to 64 workers.
+//
+
+#include "Jobs.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace lab;
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// embarrassingly parallel, big independent chunks of arithmetic
+double Coarse(JobSystem& jobs, std::vector<float>& out) {
+    auto start = std::chrono::steady_clock::now();
+    jobs.ParallelFor(0, out.size(), 16384, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            float x = (float)i * 0.001f;
+            out[i] = std::sin(x) * std::cos(x * 0.5f) + std::sqrt(x);
+        }
+    });
+    return Seconds(start);
+}
+
+// fine grained, nested fork/join with almost no work per job
+int Fib(JobSystem& jobs, int n) {
+    if (n < 12) {
+        int a = 0, b = 1;
+        for (int i = 0; i < n; i++) {
+            int c = a + b;
+            a = b;
+            b = c;
+        }
+        return a;
+    }
+
+    int left = 0;
+    JobCounter counter;
+    jobs.Spawn(counter, [&jobs, &left, n]() { left = Fib(jobs, n - 1); });
+    int right = Fib(jobs, n - 2);
+    jobs.Wait(counter);
+    return left + right;
+}
+
+double Fine(JobSystem& jobs, int& result) {
+    auto start = std::chrono::steady_clock::now();
+    result = Fib(jobs, 32);
+    return Seconds(start);
+}
+
+} // anon
+
+int main() {
+    printf("hardware threads %u\n", std::thread::hardware_concurrency());
+    printf("%8s %14s %9s %14s %9s\n", "workers", "coarse ms", "speedup", "fine ms", "speedup");
+
+    std::vector<float> out(1 << 24);
+    double coarse1 = 0, fine1 = 0;
+
+    for (unsigned int workers = 1; workers <= 64; workers *= 2) {
+        JobSystem jobs(workers);
+
+        // best of a few, the first run also warms the pools and the threads up
+        double coarse = 1e9, fine = 1e9;
+        int result = 0;
+        for (int run = 0; run < 3; run++) {
+            coarse = std::min(coarse, Coarse(jobs, out));
+            fine = std::min(fine, Fine(jobs, result));
+        }
+
+        if (workers == 1) {
+            coarse1 = coarse;
+            fine1 = fine;
+        }
+
+        printf("%8u %14.2f %9.2f %14.2f %9.2f\n", workers,
+               coarse * 1e3, coarse1 / coarse, fine * 1e3, fine1 / fine);
+
+        if (result != 2178309)
+            printf("wrong result %d\n", result);
+    }
+    return 0;
+}
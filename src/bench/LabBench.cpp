@@ -0,0 +1,408 @@
+//
+//  LabBench.cpp
+//  LabExcelsior
+//
+//  Benchmarks of the mode, journal and transaction machinery in Modes.hpp,
+//  and of RGFW's RGBA -> BGRA buffer conversion.
+//
+//  LabBench [--json results.json] [--label name] [--filter substring] [--quick]
+//
+//  Each benchmark is calibrated to run for a while, repeated, and the median
+//  taken. compare.py flags regressions between two JSON files.
+//
+
+#include "Modes.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lab;
+
+extern "C" {
+// RGFW.h, built alone by Swizzle.c
+void   RGFW_swizzleBGRA(unsigned char* pixels, size_t count);
+size_t RGFW_swizzleBGRA_scalar(unsigned char* pixels, size_t count);
+}
+
+namespace {
+
+struct Result {
+    std::string name;
+    long long param;
+    double nsPerOp;
+    unsigned long long iterations;
+};
+
+struct Options {
+    const char* json = nullptr;
+    const char* label = "";
+    const char* filter = nullptr;
+    double seconds = 0.2;       // per repetition
+    int repetitions = 5;
+};
+
+Options gOptions;
+std::vector<Result> gResults;
+std::atomic<unsigned long long> gSink { 0 };
+unsigned long long gWork = 0;       // what the modes do, from the main thread only
+
+double Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// run(n) does n operations and returns the seconds the part being measured
+// took, for benchmarks that need untimed setup between operations. Grows n
+// until a run takes long enough to time, then takes the median of the repetitions
+void MeasureTimed(const std::string& name, long long param, const std::function<double(unsigned long long)>& run) {
+    if (gOptions.filter && name.find(gOptions.filter) == std::string::npos)
+        return;
+
+    unsigned long long n = 1;
+    for (;;) {
+        double elapsed = run(n);
+        if (elapsed >= gOptions.seconds * 0.5 || n >= (1ull << 40))
+            break;
+        n = elapsed <= 0 ? n * 10 : std::max(n * 2, (unsigned long long)(n * gOptions.seconds / elapsed));
+    }
+
+    std::vector<double> times;
+    for (int r = 0; r < gOptions.repetitions; r++)
+        times.push_back(run(n) * 1e9 / (double)n);
+    std::sort(times.begin(), times.end());
+
+    Result result { name, param, times[times.size() / 2], n };
+    gResults.push_back(result);
+    printf("%-28s %8lld %14.1f ns/op %12llu iterations\n", name.c_str(), param, result.nsPerOp, n);
+    fflush(stdout);
+}
+
+// run(n) does n operations, all of it timed
+void Measure(const std::string& name, long long param, const std::function<void(unsigned long long)>& run) {
+    MeasureTimed(name, param, [&](unsigned long long n) {
+        double start = Now();
+        run(n);
+        return Now() - start;
+    });
+}
+
+// drops everything, without buffering it anywhere
+struct NullBuf : std::streambuf {
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// ModeManager logs every transaction and mode activation, which isn't what's being measured
+struct QuietCout {
+    NullBuf sink;
+    std::streambuf* saved;
+    QuietCout() : saved(std::cout.rdbuf(&sink)) {}
+    ~QuietCout() { std::cout.rdbuf(saved); }
+};
+
+
+/*
+ C++ modes. Registration is keyed by the type's sname, so to register any
+ number of modes of one type, sname hands out whatever name is next.
+ */
+
+std::string gNextName;
+
+class BenchMode : public MinorMode
+{
+    std::string _name;
+    int _id;
+
+public:
+    BenchMode(const std::string& name, int id) : _name(name), _id(id) {}
+    static const char* sname() { return gNextName.c_str(); }
+    const std::string Name() const override { return _name; }
+
+    void Update() override { gWork++; }
+    void Render(const ViewInteraction& vi) override { gWork += (unsigned long long)vi.x; }
+    int ViewportHoverBid(const ViewInteraction& vi) override { return (_id * 7919 + (int)vi.x) & 1023; }
+    void ViewportHovering(const ViewInteraction&) override { gWork++; }
+    int ViewportDragBid(const ViewInteraction& vi) override { return (_id * 104729 + (int)vi.y) & 1023; }
+    void ViewportDragging(const ViewInteraction&) override { gWork++; }
+};
+
+class BenchMajorMode : public MajorMode
+{
+    std::vector<std::string> _modes;
+
+public:
+    explicit BenchMajorMode(const std::vector<std::string>& modes) : _modes(modes) {}
+    static const char* sname() { return "BenchMajor"; }
+    const std::string Name() const override { return sname(); }
+    const std::vector<std::string>& ModeConfiguration() const override { return _modes; }
+};
+
+// a manager with count active C++ modes, or C modes if c
+std::unique_ptr<ModeManager> MakeManager(int count, bool c, std::vector<CMode*>& cmodes) {
+    std::unique_ptr<ModeManager> mm(new ModeManager());
+
+    std::vector<std::string> names;
+    for (int i = 0; i < count; i++) {
+        std::string name = "Bench" + std::to_string(i);
+        names.push_back(name);
+
+        if (c) {
+            // the same work as BenchMode, user is the id
+            CMode* m = ExcelsiorCreateMode(name.c_str());
+            m->user = (void*)(uintptr_t)i;
+            m->update = [](CMode*, CModeManager*) { gWork++; };
+            m->render = [](CMode*, const CViewInteraction* vi) { gWork += (unsigned long long)vi->x; };
+            m->hoverBid = [](CMode* m, const CViewInteraction* vi) { return ((int)(uintptr_t)m->user * 7919 + (int)vi->x) & 1023; };
+            m->hovering = [](CMode*, const CViewInteraction*) { gWork++; };
+            m->dragBid = [](CMode* m, const CViewInteraction* vi) { return ((int)(uintptr_t)m->user * 104729 + (int)vi->y) & 1023; };
+            m->dragging = [](CMode*, const CViewInteraction*) { gWork++; };
+            ExcelsiorRegisterMode(mm->CModes(), m);
+            cmodes.push_back(m);
+        }
+        else {
+            gNextName = name;
+            mm->RegisterMinorMode<BenchMode>([name, i]() { return std::make_shared<BenchMode>(name, i); });
+        }
+    }
+
+    mm->RegisterMajorMode<BenchMajorMode>([names]() { return std::make_shared<BenchMajorMode>(names); });
+    mm->ActivateMajorMode(BenchMajorMode::sname());
+    mm->UpdateTransactionQueueAndModes();
+    return mm;
+}
+
+void FreeManager(std::unique_ptr<ModeManager>& mm, std::vector<CMode*>& cmodes) {
+    mm.reset();
+    for (CMode* m : cmodes)
+        ExcelsiorFreeNode(m);
+    cmodes.clear();
+}
+
+ViewInteraction Interaction(unsigned long long i) {
+    ViewInteraction vi;
+    vi.view = { 1280, 720, 0, 0, 1280, 720 };
+    vi.x = (float)(i % 1280);
+    vi.y = (float)((i * 7) % 720);
+    return vi;
+}
+
+void BenchDispatch() {
+    const int counts[] = { 1, 16, 64, 256 };
+    for (int c = 0; c < 2; c++) {
+        for (int count : counts) {
+            std::vector<CMode*> cmodes;
+            auto mm = MakeManager(count, c == 1, cmodes);
+
+            // a frame's worth: update, hover, render
+            Measure(c ? "dispatch/frame/c" : "dispatch/frame/cpp", count, [&](unsigned long long n) {
+                for (unsigned long long i = 0; i < n; i++) {
+                    ViewInteraction vi = Interaction(i);
+                    mm->UpdateTransactionQueueAndModes();
+                    mm->RunViewportHovering(vi);
+                    mm->RunModeRendering(vi);
+                }
+            });
+
+            Measure(c ? "bidding/hover/c" : "bidding/hover/cpp", count, [&](unsigned long long n) {
+                for (unsigned long long i = 0; i < n; i++)
+                    mm->RunViewportHovering(Interaction(i));
+            });
+
+            Measure(c ? "bidding/drag/c" : "bidding/drag/cpp", count, [&](unsigned long long n) {
+                for (unsigned long long i = 0; i < n; i++)
+                    mm->RunViewportDragging(Interaction(i));
+            });
+
+            FreeManager(mm, cmodes);
+        }
+    }
+}
+
+Transaction MakeTransaction(unsigned long long i) {
+    return Transaction("bench", [i]() { gSink.fetch_add(i, std::memory_order_relaxed); });
+}
+
+void BenchJournal() {
+    const int sizes[] = { 100, 1000, 10000 };
+
+    for (int size : sizes) {
+        // per appended transaction, including truncating the journal when full
+        Measure("journal/append", size, [&](unsigned long long n) {
+            std::unique_ptr<Journal> journal(new Journal());
+            int length = 0;
+            for (unsigned long long i = 0; i < n; i++) {
+                if (length == size) {
+                    journal.reset(new Journal());
+                    length = 0;
+                }
+                journal->Append(MakeTransaction(i));
+                length++;
+            }
+        });
+
+        // per fork, size forks of the same node, and discarding them
+        Measure("journal/fork", size, [&](unsigned long long n) {
+            unsigned long long done = 0;
+            while (done < n) {
+                Journal journal;
+                journal.Append(MakeTransaction(0));
+                for (int i = 0; i < size && done < n; i++, done++)
+                    journal.Fork(MakeTransaction(i));
+            }
+        });
+
+        // per node, cutting a journal of size back to the root, what appending after undoing all of it does.
+        // Only the cut is timed, not building the journal
+        MeasureTimed("journal/truncate", size, [&](unsigned long long n) {
+            double elapsed = 0;
+            unsigned long long done = 0;
+            while (done < n) {
+                Journal journal;
+                for (int i = 0; i < size; i++)
+                    journal.Append(MakeTransaction(i));
+
+                double start = Now();
+                JournalNode::Truncate(&journal.root);
+                elapsed += Now() - start;
+                done += (unsigned long long)size;
+            }
+            return elapsed;
+        });
+
+        // a whole walk over a journal of size
+        {
+            Journal journal;
+            for (int i = 0; i < size; i++)
+                journal.Append(MakeTransaction(i));
+
+            Measure("journal/validate", size, [&](unsigned long long n) {
+                for (unsigned long long i = 0; i < n; i++)
+                    gSink += journal.Validate();
+            });
+        }
+    }
+}
+
+// producers threads enqueue while the main thread drains, per transaction
+void BenchQueue() {
+    const int producers[] = { 1, 2, 4, 8 };
+
+    for (int threads : producers) {
+        Measure("queue/enqueue+drain", threads, [&](unsigned long long n) {
+            ModeManager mm;
+            unsigned long long each = (n + (unsigned long long)threads - 1) / (unsigned long long)threads;
+            std::atomic<int> finished { 0 };
+
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; t++)
+                workers.emplace_back([&]() {
+                    for (unsigned long long i = 0; i < each; i++)
+                        mm.EnqueueTransaction(MakeTransaction(i));
+                    finished++;
+                });
+
+            while (finished.load() < threads)
+                mm.UpdateTransactionQueueAndModes();
+            mm.UpdateTransactionQueueAndModes();
+
+            for (auto& w : workers)
+                w.join();
+        });
+    }
+}
+
+// per frame, converting a whole 1080p or 4K buffer the way the X11 RGFW_BUFFER swap does
+void BenchSwizzle() {
+    const struct { long long height; size_t width; } sizes[] = { { 1080, 1920 }, { 2160, 3840 } };
+
+    for (auto size : sizes) {
+        size_t pixels = size.width * (size_t)size.height;
+        std::vector<unsigned char> frame(pixels * 4);
+        for (size_t i = 0; i < frame.size(); i++)
+            frame[i] = (unsigned char)(i * 31);
+
+        Measure("swizzle/simd", size.height, [&](unsigned long long n) {
+            for (unsigned long long i = 0; i < n; i++) {
+                RGFW_swizzleBGRA(frame.data(), pixels);
+                gSink += frame[i % frame.size()];
+            }
+        });
+
+        Measure("swizzle/scalar", size.height, [&](unsigned long long n) {
+            for (unsigned long long i = 0; i < n; i++) {
+                RGFW_swizzleBGRA_scalar(frame.data(), pixels);
+                gSink += frame[i % frame.size()];
+            }
+        });
+    }
+}
+
+std::string Escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+bool WriteJson(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f)
+        return false;
+
+    fprintf(f, "{\n  \"label\": \"%s\",\n  \"threads\": %u,\n  \"results\": [\n",
+            Escape(gOptions.label).c_str(), std::thread::hardware_concurrency());
+    for (size_t i = 0; i < gResults.size(); i++) {
+        const Result& r = gResults[i];
+        fprintf(f, "    { \"name\": \"%s\", \"param\": %lld, \"ns_per_op\": %.3f, \"iterations\": %llu }%s\n",
+                Escape(r.name).c_str(), r.param, r.nsPerOp, r.iterations, i + 1 < gResults.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+} // anon
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            gOptions.json = argv[++i];
+        else if (!strcmp(argv[i], "--label") && i + 1 < argc)
+            gOptions.label = argv[++i];
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            gOptions.filter = argv[++i];
+        else if (!strcmp(argv[i], "--quick")) {
+            gOptions.seconds = 0.02;
+            gOptions.repetitions = 3;
+        }
+        else {
+            fprintf(stderr, "usage: %s [--json results.json] [--label name] [--filter substring] [--quick]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    QuietCout quiet;
+    BenchDispatch();
+    BenchJournal();
+    BenchQueue();
+    BenchSwizzle();
+
+    if (gOptions.json && !WriteJson(gOptions.json)) {
+        fprintf(stderr, "could not write %s\n", gOptions.json);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+//
+//  Swizzle.c
+//  LabExcelsior
+//
+//  RGFW's RGBA -> BGRA conversion on its own, without a windowing backend,
+//  for LabBench.
+//
+
+#define RGFW_SWIZZLE_IMPLEMENTATION
+#define RGFWDEF
+#define RGFW_NO_API
+#include "RGFW.h"
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+#
+#  compare.py
+#  LabExcelsior
+#
+#  Compares two LabBench --json runs.
+#
+#  compare.py base.json new.json [--threshold percent]
+#
+#  Exits 1 if anything got slower by more than the threshold.
+#
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        run = json.load(f)
+    return run, {(r["name"], r["param"]): r["ns_per_op"] for r in run["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare two LabBench runs")
+    parser.add_argument("base")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="percent slower that counts as a regression (default 10)")
+    args = parser.parse_args()
+
+    base_run, base = load(args.base)
+    new_run, new = load(args.new)
+
+    print("%-28s %8s %14s %14s %9s" % ("benchmark", "param",
+          base_run.get("label") or "base", new_run.get("label") or "new", "change"))
+
+    regressions = 0
+    for key in sorted(base.keys() | new.keys()):
+        name, param = key
+        if key not in base or key not in new:
+            only = "base" if key in base else "new"
+            print("%-28s %8d %44s" % (name, param, "only in " + only))
+            continue
+
+        b, n = base[key], new[key]
+        change = (n - b) / b * 100.0 if b > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  slower"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  faster"
+        print("%-28s %8d %14.1f %14.1f %+8.1f%%%s" % (name, param, b, n, change, flag))
+
+    if regressions:
+        print("%d regression%s over %.0f%%" % (regressions, "" if regressions == 1 else "s", args.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
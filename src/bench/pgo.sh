@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+#  pgo.sh
+#  LabExcelsior
+#
+#  Builds LabBench as a plain release build and as a profile guided one
+#  trained on the benchmarks, then compares the two.
+#
+#  pgo.sh <source dir> <work dir> [extra cmake arguments]
+#
+#  Leaves <work dir>/release, <work dir>/pgo and their LabBench --json results.
+#
+
+set -e
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 <source dir> <work dir> [extra cmake arguments]" >&2
+    exit 1
+fi
+
+src=$1
+work=$2
+shift 2
+bench=$(cd "$(dirname "$0")" && pwd)
+
+cmake -S "$src" -B "$work/release" -DCMAKE_BUILD_TYPE=Release -DLAB_PGO=OFF "$@"
+cmake --build "$work/release" --target LabBench
+
+cmake -S "$src" -B "$work/pgo" -DCMAKE_BUILD_TYPE=Release -DLAB_PGO=GENERATE "$@"
+cmake --build "$work/pgo" --target lab-pgo-train
+cmake -S "$src" -B "$work/pgo" -DLAB_PGO=USE
+cmake --build "$work/pgo" --target LabBench
+
+"$work/release/LabBench" --json "$work/release.json" --label release
+"$work/pgo/LabBench" --json "$work/pgo.json" --label pgo
+python3 "$bench/compare.py" "$work/release.json" "$work/pgo.json"
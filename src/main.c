@@ -1,13 +1,37 @@
 #define RGFWDEF
-#define RGFW_ALLOC_DROPFILES
 #define RGFW_PRINT_ERRORS
 #define RGFW_OPENGL
 #define RGFW_IMPLEMENTATION
 
 #include "RGFW.h"
+#include "Latency.h"
+#include "Headless.h"
+#include "FrameCapture.h"
+#include "StreamBuffer.h"
+#include "Present.h"
+#include "Record.h"
+#include "Modes.hpp"
 #include <stdio.h>
+#include <stdatomic.h>
+#ifdef __APPLE__
+#include <pthread.h>
+#endif
 
-void drawLoop(RGFW_window* w); /* I seperate the draw loop only because it's run twice */
+void drawLoop(RGFW_window* w, unsigned int probe, LabFrameCapture* capture, struct CModeManager* modes, LabStreamBuffer* stream); /* I seperate the draw loop only because it's run twice */
+void drawScene(void);
+void toggleCapture(RGFW_window* win);
+void printMonitors(RGFW_window* win);
+int runHeadless(unsigned int frames, const char* pattern);
+int runStream(unsigned int frames, int flags);
+int runPresent(unsigned int frames, double hz);
+int runReplay(const char* path, int fast);
+CMode* registerCursorMode(struct CModeManager* modes);
+LabRecordEvent inputEvent(RGFW_window* win, RGFW_Event* event, int leftHeld);
+int trackLeftButton(int held, u8 type, u8 button);
+unsigned int dispatchInput(struct CModeManager* modes, const LabRecordEvent* input, int leftHeld, u32 w, u32 h);
+void recordTransaction(void* user, const char* message);
+void stampProbe(void* user, unsigned int probe, int stage);
+void requestRedraw2(void);
 
 #ifdef RGFW_WINDOWS
 DWORD loop2(void* args);
@@ -17,18 +41,90 @@ void* loop2(void* args);
 
 
 unsigned char icon[4 * 3 * 3] = {0xFF, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0xFF};
-unsigned char running = 1, running2 = 1;
+atomic_uchar running = 1, running2 = 1;
+
+/* 
+    frames are only drawn on demand, when something changed or another thread asked for one,
+    continuous rendering only happens while animating (toggled with 'a'),
+    loop2 sets redraw from its own thread, so it is atomic
+*/
+atomic_uchar redraw = 1;
+atomic_uchar redraw2 = 1; /* the same for win2, which is drawn by loop2 */
+unsigned char animating = 0;
+float spin = 0;
+
+unsigned char rawMouse = 0; /* sub-pixel, timestamped mouse samples (toggled with 'r') */
+
+/* recording the main window to capture_00000.qoi, capture_00001.qoi, ... (toggled with 'c') */
+LabFrameCapture* capture = NULL;
+LabFrameWriter* writer = NULL;
+
+RGFW_clipboardRequest paste; /* read without stalling the frame, it finishes with RGFW_clipboardReady */
+
+void printPaste(void) {
+    if (paste.status == RGFW_clipboardDone)
+        printf("Pasted : %s\n", paste.data);
+
+    if (paste.data != NULL)
+        RGFW_clipboardFree(paste.data);
+    paste.data = NULL;
+}
+
+_Atomic(RGFW_window*) win2; /* made by loop2, except on macOS */
 
 /* callbacks are another way you can handle events in RGFW */
 void refreshCallback(RGFW_window* win) {
-    drawLoop(win);
+    if (win == win2) { /* only loop2 draws with win2's context */
+        requestRedraw2();
+        return;
+    }
+
+    drawLoop(win, 0, NULL, NULL, NULL);
+}
+
+#ifdef __APPLE__
+/* win2's events are checked on the main thread on macOS, so loop2 sleeps here until it has something to draw */
+pthread_mutex_t loop2Lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t loop2Wake = PTHREAD_COND_INITIALIZER;
+#endif
+
+/* wakes loop2 up to look at redraw2 and running2 */
+void wakeLoop2(void) {
+    #ifdef __APPLE__
+    pthread_mutex_lock(&loop2Lock);
+    pthread_cond_signal(&loop2Wake);
+    pthread_mutex_unlock(&loop2Lock);
+    #else
+    RGFW_window_stopCheckEvents(win2);
+    #endif
 }
 
+void requestRedraw2(void) {
+    redraw2 = 1;
+    wakeLoop2();
+}
+
+int main(int argc, char** argv) {
+    /* 
+        `LabGL --headless 10000` renders offscreen without a window or a display, then prints the frame rate,
+        `LabGL --headless 100 frames/%04llu.png` also writes every frame (.png, .qoi or raw RGBA otherwise)
+    */
+    if (argc > 2 && strcmp(argv[1], "--headless") == 0)
+        return runHeadless((unsigned int)atoi(argv[2]), argc > 3 ? argv[3] : NULL);
+
+    /* `LabGL --stream 500` measures streaming a million vertices a frame, `--stream 500 subdata` without buffer storage */
+    if (argc > 2 && strcmp(argv[1], "--stream") == 0)
+        return runStream((unsigned int)atoi(argv[2]), (argc > 3 && strcmp(argv[3], "subdata") == 0) ? LAB_STREAM_SUBDATA : 0);
 
-RGFW_window* win2;
+    /* `LabGL --present 600` paces offscreen frames to a simulated 60, 120 and 144 hz display, `--present 600 90` to just one */
+    if (argc > 2 && strcmp(argv[1], "--present") == 0)
+        return runPresent((unsigned int)atoi(argv[2]), argc > 3 ? atof(argv[3]) : 0);
 
-int main(void) {
-	RGFW_setClassName("RGFW Basic");
+    /* `LabGL --replay session.lrec` plays a recording back offscreen at the pace it was recorded, `--replay session.lrec fast` as fast as it goes */
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+        return runReplay(argv[2], argc > 3 && strcmp(argv[3], "fast") == 0);
+
+    RGFW_setClassName("RGFW Basic");
     RGFW_window* win = RGFW_createWindow("RGFW Example Window", RGFW_RECT(500, 500, 500, 500), RGFW_ALLOW_DND | RGFW_CENTER);
     RGFW_window_makeCurrent(win);
     
@@ -39,7 +135,7 @@ int main(void) {
     #ifdef RGFW_MACOS
     win2 = RGFW_createWindow("subwindow", RGFW_RECT(200, 200, 200, 200), 0);
     #endif
-    RGFW_createThread((RGFW_threadFunc_ptr)loop2, NULL); /* the function must be run after the window of this thread is made for some reason (using X11) */
+    RGFW_thread thread = RGFW_createThread((RGFW_threadFunc_ptr)loop2, NULL); /* the function must be run after the window of this thread is made for some reason (using X11) */
 
     unsigned char i;
 
@@ -47,71 +143,288 @@ int main(void) {
     glClearColor(0, 0, 0, 0);
 
     RGFW_window_setMouseStandard(win, RGFW_MOUSE_RESIZE_NESW);
+
+    /* animated frames are paced to the monitor, each starts as late as it can and still make the next vblank */
+    #ifdef RGFW_X11
+    LabPresent* present = LabPresentCreate((LabGLLoader)RGFW_getProcAddress, win->src.display, win->src.window, RGFW_window_getMonitor(win).refreshRate, 0);
+    #else
+    LabPresent* present = LabPresentCreate(NULL, NULL, 0, RGFW_window_getMonitor(win).refreshRate, 0);
+    #endif
+
+    /* modes written in C, run through the same lab::ModeManager as the C++ ones */
+    struct CModeManager* modes = ExcelsiorCreateModeManager();
+    ExcelsiorSetWakeCallback(modes, RGFW_stopCheckEvents);
+    ExcelsiorSetProbeCallback(modes, stampProbe, NULL);
+    CMode* cursorMode = registerCursorMode(modes);
+
+    /* the modes' per-frame geometry, NULL leaves them to draw without one */
+    LabStreamBuffer* stream = LabStreamBufferCreate((LabGLLoader)RGFW_getProcAddress, 1 << 20, 0);
+
+    /* `LabGL --plugins build/plugins` loads mode plugins from there, and reloads them when they're rebuilt */
+    if (argc > 2 && strcmp(argv[1], "--plugins") == 0 && !ExcelsiorLoadPlugins(modes, argv[2]))
+        printf("plugins : couldn't watch %s\n", argv[2]);
+
+    /* `LabGL --record session.lrec` records the input and the transactions, for --replay */
+    LabRecorder* recorder = NULL;
+    if (argc > 2 && strcmp(argv[1], "--record") == 0) {
+        recorder = LabRecorderCreate(argv[2], win->r.w, win->r.h);
+        if (recorder == NULL)
+            printf("record : couldn't write %s\n", argv[2]);
+        else
+            ExcelsiorSetTransactionCallback(modes, recordTransaction, recorder);
+    }
     
     u32 fps = 0;
+    RGFW_Event events[64];
+
+    /* `LabGL --latency 1000` measures input to photon latency with synthetic mouse moves, prints the histograms and exits */
+    unsigned int probes = (argc > 2 && strcmp(argv[1], "--latency") == 0) ? (unsigned int)atoi(argv[2]) : 0;
+    if (probes && !LabLatencyBegin(probes)) {
+        printf("latency : XTest isn't available\n");
+        probes = 0;
+    }
+
+    unsigned int probe = 0; /* the probe the next frame carries */
+    int leftHeld = 0; /* as of the event being handled, RGFW_isMousePressed only knows the end of the batch */
 
     while (running && !RGFW_isPressed(win, RGFW_Escape)) {   
         #ifdef __APPLE__
-        RGFW_window_checkEvent(win2);
+        while (RGFW_window_checkEvent(win2) != NULL) {
+            if (win2->event.type == RGFW_quit) {
+                running2 = 0;
+                wakeLoop2();
+            }
+
+            else if (win2->event.type == RGFW_mouseButtonPressed)
+                redraw = 1;
+
+            else if (win2->event.type == RGFW_windowResized || win2->event.type == RGFW_windowRefresh)
+                requestRedraw2();
+        }
         #endif
 
-        RGFW_window_eventWait(win, RGFW_NEXT);
-        
-        while (RGFW_window_checkEvent(win) != NULL) {
-            if (win->event.type == RGFW_windowMoved) {
+        if (probes) {
+            if (!LabLatencyActive())
+                break;
+
+            LabLatencyInject(win->r.x + (i32)(win->r.w / 2), win->r.y + (i32)(win->r.h / 2));
+        }
+
+        /* sleep until there is input or another thread calls RGFW_stopCheckEvents, unless we're animating */
+        if (animating)
+            LabPresentWait(present);
+        RGFW_window_eventWait(win, animating ? RGFW_NO_WAIT : (probes ? 100 : RGFW_NEXT));
+
+        /* drain everything that is pending in one go, mouse moves come back coalesced */
+        u32 eventCount = RGFW_window_drainEvents(win, events, sizeof(events) / sizeof(events[0]));
+        u32 e;
+
+        for (e = 0; e < eventCount; e++) {
+            RGFW_Event* event = &events[e];
+
+            /* what the modes are given, recorded as it's handled */
+            leftHeld = trackLeftButton(leftHeld, (u8)event->type, event->button);
+            LabRecordEvent input = inputEvent(win, event, leftHeld);
+            if (recorder != NULL)
+                LabRecorderEvent(recorder, &input);
+
+            if (event->type == RGFW_windowMoved) {
                 printf("window moved\n");
             }
-            else if (win->event.type == RGFW_windowResized) {
+            else if (event->type == RGFW_windowResized) {
                 printf("window resized\n");
+                redraw = 1;
             }
-            if (win->event.type == RGFW_quit) {
+            else if (event->type == RGFW_windowRefresh)
+                redraw = 1;
+
+            if (event->type == RGFW_quit) {
                 running = 0;  
                 break;
             }
-            if (RGFW_isPressed(win, RGFW_Up)) {
-                char* str = RGFW_readClipboard(NULL);
-                printf("Pasted : %s\n", str);
-                free(str);
+
+            /* the frame carries a probe the modes were given on to the swap */
+            unsigned int dispatched = dispatchInput(modes, &input, leftHeld, win->r.w, win->r.h);
+            if (dispatched) {
+                probe = dispatched;
+                redraw = 1;
             }
-            else if (RGFW_isPressed(win, RGFW_Down))
-                RGFW_writeClipboard("DOWN", 4);
-            else if (RGFW_isPressed(win, RGFW_Space))
-                printf("fps : %i\n", fps);
-            else if (RGFW_isPressed(win, RGFW_w))
-                RGFW_window_setMouseDefault(win);
-            else if (RGFW_isPressed(win, RGFW_q))
-                RGFW_window_showMouse(win, 0);
-            else if (RGFW_isPressed(win, RGFW_t)) {
-                RGFW_window_setMouse(win, icon, RGFW_AREA(3, 3), 4);
+
+            if (event->type == RGFW_keyPressed) {
+                if (event->keyCode == RGFW_Up) {
+                    /* a read still in flight owns paste.data, it finishes (or times out) with RGFW_clipboardReady */
+                    if (paste.status != RGFW_clipboardPending) {
+                        paste.data = NULL;
+                        if (RGFW_window_readClipboardAsync(win, &paste) && paste.status != RGFW_clipboardPending)
+                            printPaste(); /* only X11 has to wait for the owner */
+                    }
+                }
+                else if (event->keyCode == RGFW_Down)
+                    RGFW_writeClipboard("DOWN", 4);
+                else if (event->keyCode == RGFW_Space)
+                    printf("fps : %i\n", fps);
+                else if (event->keyCode == RGFW_w)
+                    RGFW_window_setMouseDefault(win);
+                else if (event->keyCode == RGFW_q)
+                    RGFW_window_showMouse(win, 0);
+                else if (event->keyCode == RGFW_t) {
+                    RGFW_window_setMouse(win, icon, RGFW_AREA(3, 3), 4);
+                }
+                else if (event->keyCode == RGFW_a) {
+                    animating = !animating;
+                    redraw = 1;
+                }
+                else if (event->keyCode == RGFW_r) {
+                    rawMouse = !rawMouse;
+                    RGFW_window_setRawMouse(win, rawMouse);
+                }
+                else if (event->keyCode == RGFW_c)
+                    toggleCapture(win);
+                else if (event->keyCode == RGFW_m)
+                    printMonitors(win);
             }
 
-            if (win->event.type == RGFW_dnd) {
-                for (i = 0; i < win->event.droppedFilesCount; i++)
-                    printf("dropped : %s\n", win->event.droppedFiles[i]);
+            else if (event->type == RGFW_dnd) {
+                for (i = 0; i < event->droppedFilesCount; i++)
+                    printf("dropped : %s\n", event->droppedFiles[i]);
             }
 
-            else if (win->event.type == RGFW_jsButtonPressed)
-                printf("pressed %i\n", win->event.button);
+            else if (event->type == RGFW_jsButtonPressed)
+                printf("pressed %i\n", event->button);
+
+            else if (event->type == RGFW_jsAxisMove && !event->button)
+                printf("{%i, %i}\n", event->axis[0].x, event->axis[0].y);
 
-            else if (win->event.type == RGFW_jsAxisMove && !win->event.button)
-                printf("{%i, %i}\n", win->event.axis[0].x, win->event.axis[0].y);
+            else if (event->type == RGFW_clipboardReady)
+                printPaste();
+
+            else if (event->type == RGFW_jsConnected)
+                printf("joystick %i connected\n", event->joystick);
+
+            else if (event->type == RGFW_jsDisconnected)
+                printf("joystick %i disconnected\n", event->joystick);
+
+            else if (event->type == RGFW_mousePosChanged && rawMouse && event->motionSampleCount && leftHeld) {
+                RGFW_pointerSample* last = &win->motionSamples[event->motionSample + event->motionSampleCount - 1];
+                printf("drag : %i samples, last {%.2f, %.2f} at %llu ms\n", event->motionSampleCount, last->x, last->y, (unsigned long long)last->time);
+            }
         }
 
-        drawLoop(win);
+        if (animating) {
+            spin += 1.0f;
+            redraw = 1;
+        }
+
+        ExcelsiorUpdateTransactionQueueAndModes(modes);
+        if (ExcelsiorNeedsRedraw(modes))
+            redraw = 1;
+
+        /* take the request, loop2 may set it again while this frame draws */
+        unsigned char drawn = atomic_exchange(&redraw, 0);
+
+        if (recorder != NULL)
+            LabRecorderFrame(recorder, (drawn ? LAB_RECORD_FRAME_DRAWN : 0) | (animating ? LAB_RECORD_FRAME_ANIMATING : 0));
+
+        if (!drawn)
+            continue;
+
+        drawLoop(win, probe, capture, modes, stream);
+        probe = 0;
+
+        if (animating)
+            LabPresentDone(present);
+
         fps = RGFW_window_checkFPS(win, 0);
     }
 
+    LabPresentStats presentStats;
+    LabPresentGetStats(present, &presentStats);
+    if (presentStats.frames)
+        LabPresentPrint(present, "present");
+    LabPresentDestroy(present);
+
+    if (probes)
+        LabLatencyEnd();
+
+    if (capture != NULL)
+        toggleCapture(win);
+
+    if (recorder != NULL) {
+        LabRecordStats recordStats;
+        LabRecorderGetStats(recorder, &recordStats);
+        printf("record : %u frames, %u events, %u transactions in %.1f s, %llu bytes\n", recordStats.frames, recordStats.events,
+               recordStats.transactions, (double)recordStats.duration / 1e9, (unsigned long long)recordStats.bytes);
+        ExcelsiorSetTransactionCallback(modes, NULL, NULL);
+        LabRecorderDestroy(recorder);
+    }
+
+    ExcelsiorFreeModeManager(modes);
+    ExcelsiorFreeNode(cursorMode);
+
+    RGFW_window_makeCurrent(win);
+    LabStreamBufferDestroy(stream);
+
     running2 = 0;
+
+    /* wake loop2 up so it can see running2, its window has to be made first */
+    while (win2 == NULL)
+        RGFW_sleep(1);
+
+    wakeLoop2();
+    RGFW_joinThread(thread);
+
+    RGFW_window_close(win2);
     RGFW_window_close(win);
 }
 
-void drawLoop(RGFW_window *w) {
+void drawLoop(RGFW_window *w, unsigned int probe, LabFrameCapture* capture, struct CModeManager* modes, LabStreamBuffer* stream) {
     RGFW_window_makeCurrent(w);
 
+    drawScene();
+
+    if (modes != NULL) {
+        CViewInteraction vi;
+        memset(&vi, 0, sizeof(vi));
+        vi.w = vi.ww = (float)w->r.w;
+        vi.h = vi.wh = (float)w->r.h;
+        vi.probe = probe;
+        vi.stream = stream;
+
+        if (stream != NULL)
+            LabStreamBufferBeginFrame(stream);
+        ExcelsiorRunModeRendering(modes, &vi); /* stamps LAB_LATENCY_RENDER through stampProbe */
+        if (stream != NULL)
+            LabStreamBufferEndFrame(stream);
+    }
+    else
+        LabLatencyStamp(probe, LAB_LATENCY_RENDER);
+
+    /* before the swap, the back buffer is what was just drawn */
+    if (capture != NULL)
+        LabFrameCaptureFrame(capture, (int)w->r.w, (int)w->r.h);
+    
+    RGFW_window_swapBuffers(w); /* NOTE(EimaMei): Rendering should always go: 1. Clear everything 2. Render 3. Swap buffers. Based on https://www.khronos.org/opengl/wiki/Common_Mistakes#Swap_Buffers */
+
+    if (probe) {
+        LabLatencyStamp(probe, LAB_LATENCY_SWAP);
+
+        #ifndef RGFW_VULKAN
+        glFinish();
+        LabLatencyStamp(probe, LAB_LATENCY_FINISH);
+        #endif
+
+        LabLatencyFinish(probe);
+    }
+}
+
+void drawScene(void) {
     #ifndef RGFW_VULKAN
     glClearColor(255, 255, 255, 255);
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+
+    glLoadIdentity();
+    glRotatef(spin, 0, 0, 1);
     
     glBegin(GL_TRIANGLES);
         glColor3f(1, 0, 0); glVertex2f(-0.6, -0.75);
@@ -122,11 +435,623 @@ void drawLoop(RGFW_window *w) {
     #else
 
     #endif
+}
 
-    
-    RGFW_window_swapBuffers(w); /* NOTE(EimaMei): Rendering should always go: 1. Clear everything 2. Render 3. Swap buffers. Based on https://www.khronos.org/opengl/wiki/Common_Mistakes#Swap_Buffers */
+/* a mode written in C, a cross that follows the mouse while dragging */
+typedef struct cursorState {
+    float x, y;
+    int visible;
+    float placedX, placedY; /* where the last drag ended, set by a transaction so it's journaled */
+    int placed;
+} cursorState;
+
+int cursorDragBid(CMode* mode, const CViewInteraction* vi) {
+    RGFW_UNUSED(mode); RGFW_UNUSED(vi);
+    return 0; /* anything that cares more outbids it */
 }
 
+void cursorPlace(void* user) {
+    cursorState* cursor = (cursorState*)user;
+    cursor->placedX = cursor->x;
+    cursor->placedY = cursor->y;
+    cursor->placed = 1;
+}
+
+void cursorDragging(CMode* mode, const CViewInteraction* vi) {
+    cursorState* cursor = (cursorState*)mode->user;
+    cursor->x = vi->x;
+    cursor->y = vi->y;
+    cursor->visible = !vi->end;
+    if (vi->end)
+        ExcelsiorEnqueueTransaction(mode->cmm, "Place cursor", cursorPlace, cursor);
+    ExcelsiorRequestRedraw(mode->cmm);
+}
+
+void cursorCross(float px, float py, const CViewInteraction* vi) {
+    #ifndef RGFW_VULKAN
+    float x = px / vi->w * 2 - 1, y = 1 - py / vi->h * 2;
+    float dx = 20 / vi->w, dy = 20 / vi->h;
+
+    glVertex2f(x - dx, y); glVertex2f(x + dx, y);
+    glVertex2f(x, y - dy); glVertex2f(x, y + dy);
+    #else
+    RGFW_UNUSED(px); RGFW_UNUSED(py); RGFW_UNUSED(vi);
+    #endif
+}
+
+void cursorRender(CMode* mode, const CViewInteraction* vi) {
+    cursorState* cursor = (cursorState*)mode->user;
+    if ((!cursor->visible && !cursor->placed) || vi->w <= 0 || vi->h <= 0)
+        return;
+
+    #ifndef RGFW_VULKAN
+    glLoadIdentity();
+    glBegin(GL_LINES);
+        if (cursor->placed) {
+            glColor3f(0.6f, 0.6f, 0.6f);
+            cursorCross(cursor->placedX, cursor->placedY, vi);
+        }
+        if (cursor->visible) {
+            glColor3f(0, 0, 0);
+            cursorCross(cursor->x, cursor->y, vi);
+        }
+    glEnd();
+    #endif
+}
+
+CMode* registerCursorMode(struct CModeManager* modes) {
+    static cursorState cursor;
+
+    CMode* mode = ExcelsiorCreateMode("Cursor");
+    mode->user = &cursor;
+    mode->dragBid = cursorDragBid;
+    mode->dragging = cursorDragging;
+    mode->render = cursorRender;
+
+    ExcelsiorRegisterMode(modes, mode);
+    ExcelsiorActivateMode(mode);
+    return mode;
+}
+
+LabRecordSample inputSamples[RGFW_MAX_MOTION_SAMPLES]; /* the drained batch's, indexed like win->motionSamples */
+
+/* an event as the modes see it, with everything a replay needs to do the same */
+LabRecordEvent inputEvent(RGFW_window* win, RGFW_Event* event, int leftHeld) {
+    LabRecordEvent input;
+    memset(&input, 0, sizeof(input));
+    input.type = (u8)event->type;
+    input.button = event->button;
+    input.key = event->keyCode;
+    input.x = (float)event->point.x;
+    input.y = (float)event->point.y;
+
+    if (event->type == RGFW_windowResized) {
+        input.x = (float)win->r.w;
+        input.y = (float)win->r.h;
+    }
+
+    /* the positions a coalesced move went through, sub-pixel in raw mouse mode */
+    if (event->type == RGFW_mousePosChanged && event->motionSampleCount) {
+        u32 i;
+        for (i = 0; i < event->motionSampleCount; i++) {
+            const RGFW_pointerSample* sample = &win->motionSamples[event->motionSample + i];
+            inputSamples[event->motionSample + i].x = (float)sample->x;
+            inputSamples[event->motionSample + i].y = (float)sample->y;
+            inputSamples[event->motionSample + i].t = (double)sample->time / 1000.0;
+        }
+
+        input.samples = &inputSamples[event->motionSample];
+        input.sampleCount = event->motionSampleCount;
+    }
+
+    if (leftHeld)
+        input.flags |= LAB_RECORD_LEFT_HELD;
+    return input;
+}
+
+/* whether the left button is down after an event, given whether it was before */
+int trackLeftButton(int held, u8 type, u8 button) {
+    if (button != RGFW_mouseLeft)
+        return held;
+    if (type == RGFW_mouseButtonPressed)
+        return 1;
+    if (type == RGFW_mouseButtonReleased)
+        return 0;
+    return held;
+}
+
+/* the modes drag while the left button is held, and hover otherwise. Returns the latency probe the move carried, if any */
+unsigned int dispatchInput(struct CModeManager* modes, const LabRecordEvent* input, int leftHeld, u32 w, u32 h) {
+    if (input->type != RGFW_mousePosChanged &&
+        !((input->type == RGFW_mouseButtonPressed || input->type == RGFW_mouseButtonReleased) && input->button == RGFW_mouseLeft))
+        return 0;
+
+    static CViewSample samples[RGFW_MAX_MOTION_SAMPLES];
+    size_t i;
+
+    CViewInteraction vi;
+    memset(&vi, 0, sizeof(vi));
+    vi.w = vi.ww = (float)w;
+    vi.h = vi.wh = (float)h;
+    vi.x = input->x;
+    vi.y = input->y;
+    vi.start = (input->type == RGFW_mouseButtonPressed);
+    vi.end = (input->type == RGFW_mouseButtonReleased);
+
+    for (i = 0; i < input->sampleCount && i < RGFW_MAX_MOTION_SAMPLES; i++) {
+        samples[i].x = input->samples[i].x;
+        samples[i].y = input->samples[i].y;
+        samples[i].t = input->samples[i].t;
+    }
+    vi.samples = i ? samples : NULL;
+    vi.sampleCount = i;
+
+    /* the first move after an injection belongs to the probe in flight */
+    if (input->type == RGFW_mousePosChanged) {
+        vi.probe = LabLatencyPending();
+        LabLatencyStamp(vi.probe, LAB_LATENCY_EVENT);
+    }
+
+    if (vi.start || vi.end || leftHeld)
+        ExcelsiorRunViewportDragging(modes, &vi);
+    else
+        ExcelsiorRunViewportHovering(modes, &vi);
+    return vi.probe;
+}
+
+void stampProbe(void* user, unsigned int probe, int stage) {
+    (void)user;
+    LabLatencyStamp(probe, stage == EXCELSIOR_PROBE_DISPATCH ? LAB_LATENCY_DISPATCH : LAB_LATENCY_RENDER);
+}
+
+void recordTransaction(void* user, const char* message) {
+    LabRecorderTransaction((LabRecorder*)user, message);
+}
+
+void toggleCapture(RGFW_window* win) {
+    if (capture == NULL) {
+        writer = LabFrameWriterCreate("capture_%05llu.qoi", LAB_FRAME_QOI, 4);
+        
+        RGFW_window_makeCurrent(win);
+        capture = LabFrameCaptureCreate(RGFW_getProcAddress, LabFrameWriterWrite, writer);
+        
+        if (capture == NULL) {
+            printf("capture : pixel buffers or fences aren't supported\n");
+            LabFrameWriterDestroy(writer);
+            writer = NULL;
+        }
+        else
+            printf("capture : recording\n");
+        return;
+    }
+
+    RGFW_window_makeCurrent(win);
+    printf("capture : stopped, %llu frames dropped\n", LabFrameCaptureDropped(capture));
+    LabFrameCaptureDestroy(capture);
+    LabFrameWriterDestroy(writer);
+    capture = NULL;
+    writer = NULL;
+}
+
+/* the format is picked by the extension, anything else is written as raw RGBA */
+LabFrameFormat frameFormat(const char* pattern) {
+    const char* dot = strrchr(pattern, '.');
+    if (dot != NULL && strcmp(dot, ".png") == 0)
+        return LAB_FRAME_PNG;
+    if (dot != NULL && strcmp(dot, ".qoi") == 0)
+        return LAB_FRAME_QOI;
+    return LAB_FRAME_RAW;
+}
+
+/* the capture gets every frame a few frames late, without stalling the loop */
+void headlessFrame(const unsigned char* pixels, int width, int height, unsigned long long frame, void* user) {
+    RGFW_UNUSED(frame);
+
+    /* sample the center pixel, enough to tell the frames were really drawn */
+    u32* center = (u32*)user;
+    *center = ((const u32*)pixels)[(height / 2) * width + width / 2];
+}
+
+int runHeadless(unsigned int frames, const char* pattern) {
+    LabHeadless* headless = LabHeadlessCreate(500, 500);
+    if (headless == NULL) {
+        printf("headless : couldn't make an EGL context\n");
+        return 1;
+    }
+
+    u32 center = 0;
+    LabFrameWriter* frameWriter = NULL;
+    if (pattern != NULL) {
+        frameWriter = LabFrameWriterCreate(pattern, frameFormat(pattern), 4);
+        if (frameWriter == NULL) {
+            printf("headless : couldn't start writing %s\n", pattern);
+            LabHeadlessDestroy(headless);
+            return 1;
+        }
+    }
+
+    LabFrameCapture* frameCapture;
+    if (frameWriter != NULL) {
+        frameCapture = LabFrameCaptureCreate(LabHeadlessGetProcAddress, LabFrameWriterWrite, frameWriter);
+        if (frameCapture == NULL) {
+            /* frames were asked for, a run that writes none shouldn't look like it worked */
+            printf("headless : no pixel buffers or fences, can't capture to %s\n", pattern);
+            LabFrameWriterDestroy(frameWriter);
+            LabHeadlessDestroy(headless);
+            return 1;
+        }
+        LabFrameCaptureSetLossless(frameCapture, 1); /* nobody is watching, every frame should reach the disk */
+    }
+    else
+        frameCapture = LabFrameCaptureCreate(LabHeadlessGetProcAddress, headlessFrame, &center);
+
+    /* the same modes as the window, given a drag around the center every second */
+    struct CModeManager* modes = ExcelsiorCreateModeManager();
+    CMode* cursorMode = registerCursorMode(modes);
+    LabStreamBuffer* stream = LabStreamBufferCreate(LabHeadlessGetProcAddress, 1 << 20, 0);
+    int leftHeld = 0;
+
+    u64 start = RGFW_getTimeNS();
+
+    unsigned int i;
+    for (i = 0; i < frames; i++) {
+        LabRecordEvent input;
+        memset(&input, 0, sizeof(input));
+        input.type = (i % 60 == 0) ? RGFW_mouseButtonPressed : (i % 60 == 59 || i + 1 == frames) ? RGFW_mouseButtonReleased : RGFW_mousePosChanged;
+        input.button = (input.type == RGFW_mousePosChanged) ? 0 : RGFW_mouseLeft;
+        input.x = 250.0f + 150.0f * cosf((float)i * 0.1f);
+        input.y = 250.0f + 150.0f * sinf((float)i * 0.1f);
+        leftHeld = trackLeftButton(leftHeld, input.type, input.button);
+        dispatchInput(modes, &input, leftHeld, 500, 500);
+        ExcelsiorUpdateTransactionQueueAndModes(modes);
+        ExcelsiorNeedsRedraw(modes);
+
+        LabHeadlessBeginFrame(headless);
+        spin += 1.0f;
+        drawScene();
+
+        CViewInteraction vi;
+        memset(&vi, 0, sizeof(vi));
+        vi.w = vi.ww = vi.h = vi.wh = 500;
+        vi.stream = stream;
+        if (stream != NULL)
+            LabStreamBufferBeginFrame(stream);
+        ExcelsiorRunModeRendering(modes, &vi);
+        if (stream != NULL)
+            LabStreamBufferEndFrame(stream);
+
+        LabFrameCaptureFrame(frameCapture, 500, 500);
+        LabHeadlessEndFrame(headless);
+    }
+
+    LabFrameCaptureFinish(frameCapture);
+    LabHeadlessFinish(headless);
+
+    double seconds = (double)(RGFW_getTimeNS() - start) / 1e9;
+    printf("headless : %u frames in %.3f s (%.0f fps), %llu dropped", frames, seconds, frames / seconds, LabFrameCaptureDropped(frameCapture));
+    if (frameWriter == NULL)
+        printf(", last center pixel %08x", center);
+    printf("\n");
+
+    LabFrameCaptureDestroy(frameCapture);
+    LabFrameWriterDestroy(frameWriter); /* after the frameCapture, which may still be handing it frames */
+    LabStreamBufferDestroy(stream);
+    ExcelsiorFreeModeManager(modes);
+    ExcelsiorFreeNode(cursorMode);
+    LabHeadlessDestroy(headless);
+    return 0;
+}
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892 /* not in every gl.h */
+#endif
+
+typedef struct streamVertex {
+    float x, y;
+    u8 rgba[4];
+} streamVertex;
+
+int runStream(unsigned int frames, int flags) {
+    LabHeadless* headless = LabHeadlessCreate(500, 500);
+    if (headless == NULL) {
+        printf("stream : couldn't make an EGL context\n");
+        return 1;
+    }
+
+    const size_t count = 1000000;
+    LabStreamBuffer* stream = LabStreamBufferCreate(LabHeadlessGetProcAddress, count * sizeof(streamVertex), flags);
+    if (stream == NULL) {
+        printf("stream : buffer objects aren't supported\n");
+        LabHeadlessDestroy(headless);
+        return 1;
+    }
+
+    void (*bindBuffer)(GLenum, GLuint) = (void (*)(GLenum, GLuint))LabHeadlessGetProcAddress("glBindBuffer");
+
+    /* a spiral, made once so only the copy is timed */
+    streamVertex* spiral = (streamVertex*)malloc(count * sizeof(streamVertex));
+    if (spiral == NULL) {
+        printf("stream : out of memory\n");
+        LabStreamBufferDestroy(stream);
+        LabHeadlessDestroy(headless);
+        return 1;
+    }
+
+    size_t i;
+    for (i = 0; i < count; i++) {
+        float t = (float)i / (float)count;
+        spiral[i].x = t * cosf(t * 200.0f);
+        spiral[i].y = t * sinf(t * 200.0f);
+        spiral[i].rgba[0] = (u8)(255 * t);
+        spiral[i].rgba[1] = 128;
+        spiral[i].rgba[2] = (u8)(255 * (1 - t));
+        spiral[i].rgba[3] = 255;
+    }
+
+    u64 upload = 0; /* ns spent writing vertices and handing them to GL */
+    u64 start = RGFW_getTimeNS();
+
+    unsigned int f;
+    int status = 0;
+    for (f = 0; f < frames; f++) {
+        LabHeadlessBeginFrame(headless);
+        glClearColor(0, 0, 0, 1);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        u64 uploadStart = RGFW_getTimeNS();
+        LabStreamBufferBeginFrame(stream);
+
+        size_t offset;
+        streamVertex* v = (streamVertex*)LabStreamBufferAlloc(stream, count * sizeof(streamVertex), 4, &offset);
+        if (v == NULL) {
+            printf("stream : frame %u didn't fit in the buffer\n", f);
+            LabStreamBufferEndFrame(stream);
+            LabHeadlessEndFrame(headless);
+            status = 1;
+            break;
+        }
+        memcpy(v, spiral, count * sizeof(streamVertex));
+
+        LabStreamBufferFlush(stream);
+        upload += RGFW_getTimeNS() - uploadStart;
+
+        glLoadIdentity();
+        glRotatef((float)f, 0, 0, 1);
+
+        bindBuffer(GL_ARRAY_BUFFER, LabStreamBufferName(stream));
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(streamVertex), (const void*)offset);
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(streamVertex), (const void*)(offset + offsetof(streamVertex, rgba)));
+        glDrawArrays(GL_POINTS, 0, (GLsizei)count);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        bindBuffer(GL_ARRAY_BUFFER, 0);
+
+        LabStreamBufferEndFrame(stream);
+        LabHeadlessEndFrame(headless);
+    }
+
+    LabHeadlessFinish(headless);
+
+    double seconds = (double)(RGFW_getTimeNS() - start) / 1e9;
+    double megabytes = (double)f * (double)(count * sizeof(streamVertex)) / 1e6;
+    if (f)
+        printf("stream : %s, %u frames of %zu vertices in %.3f s, %.0f MB/s sustained, %.3f ms CPU upload per frame, %llu stalls\n",
+               LabStreamBufferPersistent(stream) ? "persistent mapping" : "glBufferSubData",
+               f, count, seconds, megabytes / seconds, (double)upload / 1e6 / f, LabStreamBufferStalls(stream));
+
+    free(spiral);
+    LabStreamBufferDestroy(stream);
+    LabHeadlessDestroy(headless);
+    return status;
+}
+
+/* a couple of passes over the scene, and four times that once a second to have deadlines to miss */
+void presentWorkload(unsigned int frame) {
+    int draws = (frame % 60 == 59) ? 8 : 2, d;
+    for (d = 0; d < draws; d++) {
+        spin += 1.0f;
+        drawScene();
+    }
+}
+
+int runPresent(unsigned int frames, double hz) {
+    LabHeadless* headless = LabHeadlessCreate(500, 500);
+    if (headless == NULL) {
+        printf("present : couldn't make an EGL context\n");
+        return 1;
+    }
+
+    double rates[] = { 60, 120, 144 };
+    int rateCount = 3, r, early;
+    if (hz > 0) {
+        rates[0] = hz;
+        rateCount = 1;
+    }
+
+    for (r = 0; r < rateCount; r++) {
+        for (early = 1; early >= 0; early--) {
+            /* no display, so no vblanks but the pacer's */
+            LabPresent* present = LabPresentCreate(NULL, NULL, 0, rates[r], LAB_PRESENT_SOFTWARE | (early ? LAB_PRESENT_EARLY : 0));
+
+            unsigned int i;
+            for (i = 0; i < frames; i++) {
+                LabPresentWait(present);
+                LabHeadlessBeginFrame(headless);
+                presentWorkload(i);
+                LabHeadlessEndFrame(headless);
+                LabHeadlessFinish(headless); /* the GPU's time counts, as it would for a real swap */
+                LabPresentDone(present);
+            }
+
+            char label[32];
+            snprintf(label, sizeof(label), "present %3.0f hz", rates[r]);
+            LabPresentPrint(present, label);
+            LabPresentDestroy(present);
+        }
+    }
+
+    LabHeadlessDestroy(headless);
+    return 0;
+}
+
+
+/* the transactions a replayed frame ran, against the ones recorded */
+typedef struct replayCheck {
+    const LabReplayFrame* frame;
+    unsigned int next;
+    unsigned int diverged;
+} replayCheck;
+
+void checkTransaction(void* user, const char* message) {
+    replayCheck* check = (replayCheck*)user;
+    if (check->next >= check->frame->transactionCount || strcmp(check->frame->transactions[check->next], message) != 0)
+        check->diverged++;
+    check->next++;
+}
+
+int compareTimes(const void* a, const void* b) {
+    u64 x = *(const u64*)a, y = *(const u64*)b;
+    return x < y ? -1 : x > y;
+}
+
+/* the frame loop without a window: the recorded events go through the same dispatchInput, the modes update, and frames are drawn where they were */
+int runReplay(const char* path, int fast) {
+    LabReplay* replay = LabReplayOpen(path);
+    if (replay == NULL) {
+        printf("replay : couldn't read %s\n", path);
+        return 1;
+    }
+
+    u32 w, h;
+    LabReplaySize(replay, &w, &h);
+
+    LabHeadless* headless = LabHeadlessCreate((int)w, (int)h);
+    if (headless == NULL) {
+        printf("replay : couldn't make an EGL context\n");
+        LabReplayClose(replay);
+        return 1;
+    }
+
+    struct CModeManager* modes = ExcelsiorCreateModeManager();
+    CMode* cursorMode = registerCursorMode(modes);
+
+    LabReplayFrame frame;
+    replayCheck check;
+    memset(&check, 0, sizeof(check));
+    check.frame = &frame;
+    ExcelsiorSetTransactionCallback(modes, checkTransaction, &check);
+
+    u64* times = NULL; /* ns per frame */
+    size_t timeCount = 0, timeCapacity = 0;
+    int recordTimes = 1;
+    int status, quit = 0, leftHeld = 0;
+    u64 start = RGFW_getTimeNS();
+
+    while (!quit && (status = LabReplayNext(replay, &frame)) == 1) {
+        if (!fast)
+            LabReplayPace(replay, frame.time);
+
+        u64 frameStart = RGFW_getTimeNS();
+        u32 e;
+
+        for (e = 0; e < frame.eventCount; e++) {
+            const LabRecordEvent* input = &frame.events[e];
+            if (input->type == RGFW_quit) {
+                quit = 1; /* the rest of the frame runs, as it did */
+                break;
+            }
+            if (input->type == RGFW_windowResized) {
+                w = (u32)input->x;
+                h = (u32)input->y;
+                LabHeadlessResize(headless, (int)w, (int)h);
+            }
+            leftHeld = trackLeftButton(leftHeld, input->type, input->button);
+            dispatchInput(modes, input, leftHeld, w, h);
+        }
+
+        unsigned int diverged = check.diverged;
+        check.next = 0;
+        ExcelsiorUpdateTransactionQueueAndModes(modes);
+        if (check.next < frame.transactionCount)
+            check.diverged += frame.transactionCount - check.next;
+        if (check.diverged != diverged)
+            printf("replay : frame at %.3f s ran other transactions than were recorded\n", (double)frame.time / 1e9);
+
+        ExcelsiorNeedsRedraw(modes);
+
+        if (frame.flags & LAB_RECORD_FRAME_ANIMATING)
+            spin += 1.0f;
+
+        if (frame.flags & LAB_RECORD_FRAME_DRAWN) {
+            LabHeadlessBeginFrame(headless);
+            drawScene();
+
+            CViewInteraction vi;
+            memset(&vi, 0, sizeof(vi));
+            vi.w = vi.ww = (float)w;
+            vi.h = vi.wh = (float)h;
+            ExcelsiorRunModeRendering(modes, &vi);
+
+            LabHeadlessEndFrame(headless);
+        }
+
+        /* out of memory only costs the timings of the frames after it */
+        if (timeCount == timeCapacity && recordTimes) {
+            size_t capacity = timeCapacity ? timeCapacity * 2 : 1024;
+            u64* grown = (u64*)realloc(times, capacity * sizeof(u64));
+            if (grown != NULL) {
+                times = grown;
+                timeCapacity = capacity;
+            }
+            else
+                recordTimes = 0;
+        }
+        if (timeCount < timeCapacity)
+            times[timeCount++] = RGFW_getTimeNS() - frameStart;
+    }
+
+    LabHeadlessFinish(headless);
+    double seconds = (double)(RGFW_getTimeNS() - start) / 1e9;
+
+    LabRecordStats stats;
+    LabReplayGetStats(replay, &stats);
+    printf("replay : %u frames, %u events, %u transactions (%u diverged) in %.3f s, recorded in %.3f s%s\n",
+           stats.frames, stats.events, stats.transactions, check.diverged, seconds, (double)stats.duration / 1e9,
+           status < 0 ? ", the file is cut short" : "");
+
+    if (timeCount) {
+        u64 sum = 0;
+        size_t i;
+        for (i = 0; i < timeCount; i++)
+            sum += times[i];
+        qsort(times, timeCount, sizeof(u64), compareTimes);
+        printf("replay : frame mean %.3f p50 %.3f p99 %.3f max %.3f ms\n", (double)sum / (double)timeCount / 1e6,
+               (double)times[timeCount / 2] / 1e6, (double)times[timeCount * 99 / 100] / 1e6, (double)times[timeCount - 1] / 1e6);
+    }
+    free(times);
+
+    ExcelsiorFreeModeManager(modes);
+    ExcelsiorFreeNode(cursorMode);
+    LabHeadlessDestroy(headless);
+    LabReplayClose(replay);
+    return (status < 0 || check.diverged) ? 1 : 0;
+}
+
+/* cached, so this costs nothing even after `xrandr` reconfigures the outputs */
+void printMonitors(RGFW_window* win) {
+    RGFW_monitor* monitors = RGFW_getMonitors();
+    RGFW_monitor current = RGFW_window_getMonitor(win);
+    u32 i;
+
+    for (i = 0; monitors != NULL && i < RGFW_getMonitorCount(); i++) {
+        RGFW_monitor* m = &monitors[i];
+        printf("monitor %s%s : %ix%i at %i, %i, %.0f dpi, %.2f hz\n", m->name,
+               strcmp(m->name, current.name) == 0 ? " (window)" : "",
+               m->rect.w, m->rect.h, m->rect.x, m->rect.y, m->scaleX * 96.f, m->refreshRate);
+    }
+}
 
 #ifdef RGFW_WINDOWS
 DWORD loop2(void* args) {
@@ -137,37 +1062,49 @@ void* loop2(void* args) {
 
     #ifndef __APPLE__
     RGFW_window* win = RGFW_createWindow("subwindow", RGFW_RECT(200, 200, 200, 200), 0);
+    win2 = win;
     #else
     RGFW_window* win = win2;
     #endif
 
+    RGFW_window_swapInterval(win, 1); /* it only draws on demand, but never faster than the display */
+
     while (running2) {
-//printf("hello\n");
-		/* 
-            not using a while loop here because there is only one event I care about 
-        */
         #ifndef __APPLE__
-        RGFW_window_checkEvent(win);
-        #endif
-
-        /* 
-            I could've also done
+        /* this window has nothing to animate, so it only wakes up for its own input */
+        RGFW_window_eventWait(win, RGFW_NEXT);
 
-            if (RGFW_checkEvents(win).type == RGFW_quit)
-        */
+        while (RGFW_window_checkEvent(win) != NULL) {
+            if (win->event.type == RGFW_quit)
+                running2 = 0;
 
-        if (win->event.type == RGFW_quit)
-            break;
+            else if (win->event.type == RGFW_mouseButtonPressed) {
+                /* ask the main window for a frame from this thread */
+                redraw = 1;
+                RGFW_stopCheckEvents(); /* wakes the main window */
+            }
 
-        if (win->event.type == RGFW_mouseButtonPressed) {
-            RGFW_stopCheckEvents();
+            else if (win->event.type == RGFW_windowResized || win->event.type == RGFW_windowRefresh)
+                redraw2 = 1;
         }
+        #else
+        /* win2's events are checked on the main thread, which asks for frames with requestRedraw2 */
+        pthread_mutex_lock(&loop2Lock);
+        while (running2 && !redraw2)
+            pthread_cond_wait(&loop2Wake, &loop2Lock);
+        pthread_mutex_unlock(&loop2Lock);
+        #endif
+
+        if (!running2)
+            break;
 
-        drawLoop(win);
+        if (atomic_exchange(&redraw2, 0))
+            drawLoop(win, 0, NULL, NULL, NULL);
     }
 
+    /* main closes this window once it has joined the thread */
     running = 0;
-    RGFW_window_close(win);
+    RGFW_stopCheckEvents();
 
     #ifdef RGFW_WINDOWS
     return 0;
@@ -33,7 +33,6 @@
 */ 
 //#define RGFW_IMPLEMENTATION
 #define RGFW_EXPORT
-#define RGFW_ALLOC_DROPFILES
 #define RGFW_PRINT_ERRORS
 #define RGFWDEF
 #define RGFW_NO_API
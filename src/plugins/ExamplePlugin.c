@@ -0,0 +1,69 @@
+//
+//  ExamplePlugin.c
+//  LabExcelsior
+//
+//  A mode plugin, rebuild it while LabGL runs with `--plugins <dir>` and the new build is swapped in
+//
+
+#include "Modes.hpp"
+
+#include <stdlib.h>
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl.h>
+#else
+    #include <GL/gl.h>
+#endif
+
+#ifdef _WIN32
+    #define EXAMPLE_EXPORT __declspec(dllexport)
+#else
+    #define EXAMPLE_EXPORT __attribute__((visibility("default")))
+#endif
+
+// survives reloads, so its layout must only ever grow
+typedef struct ExampleState {
+    unsigned int updates;
+} ExampleState;
+
+static void exampleUpdate(CMode* mode, struct CModeManager* cmm) {
+    (void)cmm;
+    ((ExampleState*)mode->user)->updates++;
+}
+
+// a square in the corner, change the color and rebuild
+static void exampleRender(CMode* mode, const CViewInteraction* vi) {
+    (void)vi;
+    float pulse = (float)(((ExampleState*)mode->user)->updates % 60) / 60.0f;
+
+    glLoadIdentity();
+    glBegin(GL_QUADS);
+        glColor3f(0.2f, 0.4f + 0.6f * pulse, 0.8f);
+        glVertex2f(0.7f, 0.7f);
+        glVertex2f(0.9f, 0.7f);
+        glVertex2f(0.9f, 0.9f);
+        glVertex2f(0.7f, 0.9f);
+    glEnd();
+}
+
+static void exampleBind(CMode* mode, int reloading) {
+    if (!reloading)
+        mode->user = calloc(1, sizeof(ExampleState));
+
+    mode->update = exampleUpdate;
+    mode->render = exampleRender;
+}
+
+static void exampleUnbind(CMode* mode, int reloading) {
+    if (!reloading) {
+        free(mode->user);
+        mode->user = NULL;
+    }
+}
+
+EXAMPLE_EXPORT const ExcelsiorPlugin* ExcelsiorPluginEntry(void) {
+    static const ExcelsiorPlugin plugin = {
+        EXCELSIOR_PLUGIN_VERSION, "Example", 1, exampleBind, exampleUnbind
+    };
+    return &plugin;
+}